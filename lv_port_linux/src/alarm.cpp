@@ -1 +0,0 @@
-../../src/menu/alarm.cpp
\ No newline at end of file
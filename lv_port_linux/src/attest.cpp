@@ -0,0 +1,347 @@
+/**
+ * smcat - runs AtEngine, the SMS PDU encoder and the outbox against a scripted
+ * modem.
+ *
+ * The modem is a string: what the engine writes is collected, and its answers
+ * are fed back in pieces split in awkward places, like a UART delivers them.
+ * Time is warped, see hal_clock_warp(), and only moves when a check moves it.
+ *
+ * Checks that lines are split and routed to the command in flight or the URC
+ * handlers, that a timed out command is followed by a resync so its late
+ * answer can't complete the next one, that PDUs match vectors worked out by
+ * hand, and that the outbox sends a round without letting other commands run
+ * in PDU mode. Exits with 1 if a check fails, so it can run as a regression
+ * test.
+ *
+ *   smcat [--verbose]
+ */
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "at_engine.h"
+#include "sms_outbox.h"
+#include "sms_pdu.h"
+#include "ui.h"
+
+static bool verbose;
+static int failed;
+
+// The smc_* the outbox needs, the filesystem kept in memory.
+static std::map<std::string, std::vector<uint8_t>> files;
+
+int smc_fs_read(const char * path, void * dest, size_t len)
+{
+    auto file = files.find(path);
+    if(file == files.end()) {
+        return -1;
+    }
+    if(file->second.size() != len) {
+        return -2;
+    }
+    memcpy(dest, file->second.data(), len);
+    return 0;
+}
+
+int smc_fs_write(const char * path, const void * src, size_t len)
+{
+    files[path].assign((const uint8_t *)src, (const uint8_t *)src + len);
+    return 0;
+}
+
+static void check(bool ok, const char * what)
+{
+    printf("%-48s %s\n", what, ok ? "ok" : "WRONG");
+    if(!ok) {
+        failed++;
+    }
+}
+
+// What the engine wrote since the last call.
+static std::string written;
+
+static size_t modem_write(void * ctx, const uint8_t * data, size_t len)
+{
+    (void)ctx;
+    written.append((const char *)data, len);
+    return len;
+}
+
+static std::string take_written(void)
+{
+    std::string out = written;
+    written.clear();
+    if(verbose) {
+        printf("  wrote \"%s\"\n", out.c_str());
+    }
+    return out;
+}
+
+static AtEngine at(modem_write, NULL);
+static unsigned long now;
+
+// Feeds text in pieces of chunk bytes.
+static void modem_says(const char * text, size_t chunk = 3)
+{
+    size_t len = strlen(text);
+    for(size_t i = 0; i < len; i += chunk) {
+        at.feed((const uint8_t *)text + i, len - i < chunk ? len - i : chunk, now);
+    }
+}
+
+static void advance(unsigned long ms)
+{
+    hal_clock_advance(ms * 1000);
+    now = millis();
+    at.poll(now);
+}
+
+struct Result {
+    int calls;
+    int result;
+    std::string lines;
+};
+
+static void on_result(void * ctx, int result, const char * lines)
+{
+    Result * res = (Result *)ctx;
+    res->calls++;
+    res->result = result;
+    res->lines = lines;
+}
+
+static std::vector<std::string> urcs;
+
+static void on_urc(void * ctx, const char * line)
+{
+    (void)ctx;
+    urcs.push_back(line);
+}
+
+static void check_engine(void)
+{
+    at.on_urc("+CMTI", on_urc, NULL);
+    at.on_urc("+CREG", on_urc, NULL);
+
+    Result csq = {};
+    at.command("AT+CSQ", on_result, &csq);
+    advance(0);
+    check(take_written() == "AT+CSQ\r", "a command is sent on poll");
+    modem_says("AT+CSQ\r\r\n+CS", 2);
+    modem_says("Q: 17,0\r\n\r\n+CMTI: \"SM\",3\r\n\r\nOK\r\n", 5);
+    check(csq.calls == 1 && csq.result == AT_OK && csq.lines == "+CSQ: 17,0\n",
+          "lines split, echo dropped");
+    check(urcs.size() == 1 && urcs[0] == "+CMTI: \"SM\",3", "a URC in the middle is routed");
+
+    Result creg = {};
+    urcs.clear();
+    at.command("AT+CREG?", on_result, &creg);
+    advance(0);
+    take_written();
+    modem_says("\r\n+CREG: 1,1\r\n\r\nOK\r\n");
+    modem_says("\r\n+CREG: 5\r\n");
+    check(creg.lines == "+CREG: 1,1\n" && urcs.size() == 1 && urcs[0] == "+CREG: 5",
+          "a command's own response is not a URC");
+
+    Result cmgs = {};
+    at.command("AT+CMGS=23", on_result, &cmgs, AT_DEFAULT_TIMEOUT_MS, "00AB");
+    advance(0);
+    take_written();
+    modem_says("\r\n> ");
+    check(take_written() == "00AB\x1A", "the payload follows the prompt");
+    modem_says("\r\n+CMS ERROR: 500\r\n");
+    check(cmgs.result == AT_ERROR && cmgs.lines == "+CMS ERROR: 500", "errors keep their code");
+
+    // The modem answers the first command after its timeout, the second must
+    // not take that answer for its own.
+    Result slow = {};
+    Result next = {};
+    at.command("AT+COPS?", on_result, &slow, 1000);
+    at.command("AT+CBC", on_result, &next);
+    advance(0);
+    take_written();
+    modem_says("\r\n+COPS: 0,0,\"Glo");
+    advance(1000);
+    check(slow.result == AT_TIMEOUT && take_written() == "", "nothing is sent right after a timeout");
+    advance(300);
+    modem_says("be\"\r\n\r\nOK\r\n");
+    advance(AT_RESYNC_QUIET_MS - 1);
+    check(next.calls == 0 && take_written() == "", "a late answer is dropped");
+    advance(1);
+    check(take_written() == "AT\r", "then the modem is checked with AT");
+    modem_says("\r\nOK\r\n");
+    check(next.calls == 0 && take_written() == "AT+CBC\r", "and only its OK lets the next one go");
+    modem_says("\r\n+CBC: 0,80,4000\r\n\r\nOK\r\n");
+    check(next.result == AT_OK && next.lines == "+CBC: 0,80,4000\n", "which gets its own answer");
+
+    Result prompt = {};
+    at.command("AT+CMGS=10", on_result, &prompt, 1000, "00");
+    advance(0);
+    take_written();
+    advance(1000);
+    check(prompt.result == AT_TIMEOUT && take_written() == "\x1B", "a missing prompt is escaped");
+    advance(AT_RESYNC_QUIET_MS);
+    take_written();
+    advance(AT_DEFAULT_TIMEOUT_MS);
+    advance(AT_RESYNC_QUIET_MS);
+    check(take_written() == "AT\r", "an unanswered AT is tried again");
+    modem_says("\r\nOK\r\n");
+
+    Result a = {};
+    Result b = {};
+    Result c = {};
+    at.command("AT+A", on_result, &a);
+    at.command("AT+B", NULL, &b);
+    at.command("AT+C", on_result, &c);
+    advance(0);
+    take_written();
+    check(at.cancel(on_result) == 1 && at.queued() == 2, "cancel leaves the command in flight");
+    modem_says("\r\nOK\r\n");
+    check(a.calls == 1 && take_written() == "AT+B\r", "and drops the rest");
+    modem_says("\r\nOK\r\n");
+    check(c.calls == 0 && at.queued() == 0, "without calling them");
+}
+
+static void check_pdu(const char * what, const char * number, const char * text, bool status_report,
+                      const char * const * hex, int parts)
+{
+    SmsPdu pdus[SMS_PDU_MAX_PARTS];
+    int got = sms_pdu_encode(number, text, 7, status_report, pdus, SMS_PDU_MAX_PARTS);
+    bool ok = got == parts;
+    for(int i = 0; ok && i < parts; i++) {
+        ok = strcmp(pdus[i].hex, hex[i]) == 0 && pdus[i].tpdu_len == (int)strlen(hex[i]) / 2 - 1;
+        if(!ok) {
+            printf("  part %d is %s (%d)\n", i + 1, pdus[i].hex, pdus[i].tpdu_len);
+        }
+    }
+    check(ok, what);
+}
+
+static void check_pdus(void)
+{
+    // The GSM-7 example from GSM 03.40 tutorials.
+    const char * hello[] = {"0011000B916407281553F80000AA0AE8329BFD4697D9EC37"};
+    check_pdu("GSM-7", "+46708251358", "hellohello", false, hello, 1);
+
+    const char * ext[] = {"0031000B916407281553F80000AA051B1E7EE303"};
+    check_pdu("GSM-7 extension table, status report", "+46708251358", "[x]", true, ext, 1);
+
+    const char * ucs2[] = {"0011000B916407281553F80008AA0C041F04400438043204350442"};
+    check_pdu("UCS-2", "+46708251358", "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82", false, ucs2, 1);
+
+    const char * surrogate[] = {"0011000A8110325476980008AA04D83DDE00"};
+    check_pdu("UCS-2 surrogate pair, national number", "0123456789", "\xF0\x9F\x98\x80", false, surrogate, 1);
+
+    // 153 and 8 septets, each after a header and a fill bit.
+    const char * concat[] = {
+        "0051000B916407281553F80000AAA0050003070201C2E170381C0E87C3E170381C0E87C3E170381C0E87C3E170381C0E"
+        "87C3E170381C0E87C3E170381C0E87C3E170381C0E87C3E170381C0E87C3E170381C0E87C3E170381C0E87C3E170381C"
+        "0E87C3E170381C0E87C3E170381C0E87C3E170381C0E87C3E170381C0E87C3E170381C0E87C3E170381C0E87C3E17038"
+        "1C0E87C3E170381C0E87C3",
+        "0051000B916407281553F80000AA0F050003070202C2E170381C0E8701",
+    };
+    check_pdu("concatenated GSM-7", "+46708251358", std::string(161, 'a').c_str(), false, concat, 2);
+
+    SmsPdu pdus[SMS_PDU_MAX_PARTS];
+    std::string too_long(153 * SMS_PDU_MAX_PARTS + 1, 'a');
+    check(sms_pdu_encode("+46708251358", too_long.c_str(), 0, true, pdus, SMS_PDU_MAX_PARTS) == -1,
+          "more than SMS_PDU_MAX_PARTS parts");
+    check(sms_pdu_encode("+4670825135x", "a", 0, true, pdus, SMS_PDU_MAX_PARTS) == -2 &&
+          sms_pdu_encode("+123456789012345678901", "a", 0, true, pdus, SMS_PDU_MAX_PARTS) == -2,
+          "invalid numbers");
+
+    int mr;
+    int status;
+    int err = sms_pdu_parse_status_report("0006D60B916407281553F8624010711541806240107115418000", &mr, &status);
+    check(err == 0 && mr == 0xD6 && status == 0, "status report");
+}
+
+// Answers every AT+CMGS with the next message reference, and everything
+// else with OK, until the engine has nothing left. Returns the commands.
+static std::vector<std::string> modem_answers(bool pdu_mode_fails)
+{
+    std::vector<std::string> cmds;
+    int mr = 1;
+    for(int i = 0; i < 100 && (at.queued() > 0 || !written.empty()); i++) {
+        advance(0);
+        std::string cmd = take_written();
+        if(cmd.empty()) {
+            continue;
+        }
+        cmds.push_back(cmd.substr(0, cmd.size() - 1));
+        if(cmd.compare(0, 8, "AT+CMGS=") == 0) {
+            modem_says("\r\n> ");
+            take_written();
+            char reply[32];
+            snprintf(reply, sizeof(reply), "\r\n+CMGS: %d\r\n\r\nOK\r\n", mr++);
+            modem_says(reply);
+        }
+        else if(cmd == "AT+CMGF=0\r" && pdu_mode_fails) {
+            modem_says("\r\nERROR\r\n");
+        }
+        else {
+            modem_says("\r\nOK\r\n");
+        }
+    }
+    return cmds;
+}
+
+static void check_outbox(void)
+{
+    SmsOutbox outbox;
+    outbox.setup(&at);
+
+    std::string four_parts(153 * 3 + 10, 'a');
+    check(outbox.queue("+46708251358", four_parts.c_str()) == 0, "queue a message of four parts");
+
+    // Not enough room for the whole round.
+    for(int i = 0; i < AT_QUEUE_LEN - SMS_PDU_MAX_PARTS - 1; i++) {
+        at.command("AT", NULL, NULL);
+    }
+    outbox.loop(now);
+    check(at.queued() == AT_QUEUE_LEN - SMS_PDU_MAX_PARTS - 1, "a round waits for room for all its parts");
+    modem_answers(false);
+
+    // +CMTI arrives during the round, its AT+CMGR must run in text mode.
+    outbox.loop(now);
+    at.command("AT+CMGR=3", NULL, NULL);
+    std::vector<std::string> cmds = modem_answers(false);
+    bool ok = cmds.size() == 7 && cmds[0] == "AT+CMGF=0" && cmds[5] == "AT+CMGF=1" && cmds[6] == "AT+CMGR=3";
+    for(int i = 1; ok && i < 5; i++) {
+        ok = cmds[i].compare(0, 8, "AT+CMGS=") == 0;
+    }
+    check(ok, "the round is queued at once");
+    check(outbox.file.entries[0].state == SMS_OUTBOX_SENT && outbox.pending() == 0, "and sends every part");
+
+    for(int mr = 1; mr <= 4; mr++) {
+        outbox.status_report(mr, 0x00);
+    }
+    check(outbox.file.entries[0].state == SMS_OUTBOX_FREE, "delivered once every part is");
+
+    outbox.queue("+46708251358", "hello");
+    outbox.loop(now);
+    cmds = modem_answers(true);
+    check(cmds.size() == 2 && cmds[0] == "AT+CMGF=0" && cmds[1] == "AT+CMGF=1",
+          "no part is sent if PDU mode fails");
+    outbox.loop(now);
+    check(outbox.file.entries[0].state == SMS_OUTBOX_QUEUED && outbox.file.entries[0].attempts == 0 &&
+          at.queued() == 0, "and the message waits without an attempt");
+    advance(SMS_OUTBOX_RETRY_MS);
+    outbox.loop(now);
+    cmds = modem_answers(false);
+    check(cmds.size() == 3 && outbox.file.entries[0].state == SMS_OUTBOX_SENT, "then goes out on the retry");
+}
+
+int main(int argc, char ** argv)
+{
+    verbose = argc > 1 && strcmp(argv[1], "--verbose") == 0;
+    hal_clock_warp();
+    now = millis();
+
+    check_engine();
+    check_pdus();
+    check_outbox();
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,539 @@
+/**
+ * smcbench - renders the SMC screens headless and times every frame.
+ *
+ * The display is a 320x240 RGB565 framebuffer in memory, rendered in DIRECT
+ * mode so each flush is one invalidated area. The clock is warped (see
+ * hal_clock_warp()) and advanced one refresh period per frame, and touches
+ * come from the script below, so every run draws the same pixels and only
+ * the render times differ.
+ *
+ * For each step it prints the frames rendered, the render time per frame,
+ * the invalidated areas and their pixels, the bytes the device would send
+ * over SPI for them, and an FNV-1a hash of the framebuffer afterwards. A hash
+ * changing means the screen looks different, a time changing with the same
+ * hash means it got cheaper or dearer to draw.
+ *
+ * With --dump, the framebuffer after each step is written to DIR/<step>.ppm.
+ *
+ * home-redraw draws the whole home screen every frame, mostly its background
+ * and the app buttons. The last step ticks the status bar for a minute, its
+ * pixels are what that redraws per minute.
+ *
+ * --alarms fills the alarm store with N (at most MAX_ALARMS) made up alarms
+ * first.
+ *
+ * --cycles then opens an app and goes back home N times, every other time the
+ * alarms and otherwise the other apps in turn, and prints the time from
+ * lifting the finger to the end of the first frame it caused, and the heap
+ * after the first and the last cycle.
+ *
+ * --profile runs the script under the draw profiler (src/menu/draw_prof.h)
+ * and prints which task types and widgets the render time went to.
+ *
+ * The framebuffer stands in for the ST7789's memory, smc_display_scroll()
+ * scrolls it as the panel would and the screens slide by scrolling it. With
+ * --no-scroll the display can't, and LVGL slides them instead.
+ *
+ *   smcbench [--frames] [--repeat N] [--alarms N] [--cycles N] [--dump DIR]
+ *            [--profile] [--no-scroll]
+ */
+#include <Arduino.h>
+#include <malloc.h>
+#include <unistd.h>
+
+#include "menu/draw_prof.h"
+#include "menu/lvgl_homescreen.h"
+#include "menu/menu.h"
+#include LVGL_INCLUDE
+
+#define BENCH_W 320
+#define BENCH_H 240
+#define BENCH_FRAME_MS LV_DEF_REFR_PERIOD
+// What the ST7789 driver sends besides the pixels, CASET, RASET and RAMWR
+// with their arguments per area and VSCRSADD with its own per scroll.
+#define BENCH_SPI_AREA 11
+#define BENCH_SPI_SCROLL 3
+
+enum BenchAction {
+    BENCH_IDLE, // Just let ms pass
+    BENCH_TAP,  // Press at x, y for two frames, then release
+    BENCH_DRAG, // Press at x, y and move to x2, y2 over ms
+    BENCH_STATUS, // A minute of status bar ticks, see status_minute()
+    BENCH_EDIT,   // Renames the first alarm in the store, as the web would
+    BENCH_REDRAW, // Invalidates the whole screen every frame for ms
+};
+
+struct BenchStep {
+    const char * name;
+    BenchAction action;
+    int x, y, x2, y2;
+    int ms; // How long to keep rendering after the action
+};
+
+// Positions are the centres of the widgets in lvgl_homescreen.cpp.
+static const BenchStep SCRIPT[] = {
+    {"home", BENCH_IDLE, 0, 0, 0, 0, 100},
+    {"alarms-open", BENCH_TAP, 160, 217, 0, 0, 400},
+    {"alarms-scroll", BENCH_DRAG, 160, 220, 160, 70, 300},
+    {"alarms-unscroll", BENCH_DRAG, 160, 70, 160, 220, 300},
+    {"alarms-idle", BENCH_IDLE, 0, 0, 0, 0, 1000},
+    {"alarms-edit", BENCH_EDIT, 0, 0, 0, 0, 100},
+    {"add-open", BENCH_TAP, 292, 43, 0, 0, 300},
+    {"add-scroll", BENCH_DRAG, 160, 200, 160, 40, 300},
+    {"add-unscroll", BENCH_DRAG, 160, 40, 160, 200, 300},
+    {"keyboard-open", BENCH_TAP, 160, 67, 0, 0, 300},
+    {"keyboard-type", BENCH_TAP, 40, 140, 0, 0, 100},
+    {"keyboard-close", BENCH_TAP, 160, 40, 0, 0, 300},
+    // Sweeps the minute hand with the clock in view
+    {"clock-show", BENCH_DRAG, 160, 200, 160, 120, 300},
+    {"clock-drag", BENCH_DRAG, 36, 144, 290, 144, 300},
+    {"clock-undrag", BENCH_DRAG, 290, 144, 36, 144, 300},
+    // Flings down to the buttons at the end of the panel
+    {"add-fling-1", BENCH_DRAG, 160, 220, 160, 20, 100},
+    {"add-fling-2", BENCH_DRAG, 160, 220, 160, 20, 100},
+    {"add-fling-3", BENCH_DRAG, 160, 220, 160, 20, 600},
+    {"add-cancel", BENCH_TAP, 236, 206, 0, 0, 300},
+    {"alarms-back", BENCH_TAP, 34, 14, 0, 0, 400},
+    {"home-idle", BENCH_IDLE, 0, 0, 0, 0, 1000},
+    {"home-redraw", BENCH_REDRAW, 0, 0, 0, 0, 1000},
+    {"status-minute", BENCH_STATUS, 0, 0, 0, 0, 0},
+};
+
+// Centres of the home screen's app buttons, in apps[] order.
+static const lv_point_t APP_BUTTONS[] = {
+    {56, 48}, {160, 48}, {264, 48}, {81, 133}, {238, 133}, {56, 217}, {160, 217}, {264, 217},
+};
+#define APP_COUNT (sizeof(APP_BUTTONS) / sizeof(APP_BUTTONS[0]))
+#define APP_ALARMS 6
+
+struct BenchFrame {
+    uint32_t areas;
+    uint32_t pixels;
+    uint32_t spi_bytes;
+};
+
+struct BenchStats {
+    uint32_t frames;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint32_t areas;
+    uint32_t pixels;
+    uint32_t spi_bytes;
+};
+
+static uint16_t framebuffer[BENCH_W * BENCH_H];
+static BenchFrame frame;
+
+static bool scroll_off;
+static int scroll_dx; // Columns the framebuffer is shown further right
+
+static lv_point_t touch_point;
+static bool touch_pressed;
+
+static Alarms alarms;
+
+static bool print_frames;
+static const char * dump_dir;
+
+static uint64_t wall_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// What LVGL and the screens allocated, LV_USE_STDLIB_MALLOC being the C
+// library's on both builds. main() turns off glibc's per thread cache, whose
+// blocks mallinfo2() counts as used although they were freed.
+static size_t heap_used(void)
+{
+    return mallinfo2().uordblks;
+}
+
+// The smc_* the alarms need, nothing is loaded or saved.
+int smc_fs_read(const char * path, void * dest, size_t len)
+{
+    LV_UNUSED(path);
+    LV_UNUSED(dest);
+    LV_UNUSED(len);
+    return -1;
+}
+
+int smc_fs_write(const char * path, const void * src, size_t len)
+{
+    LV_UNUSED(path);
+    LV_UNUSED(src);
+    LV_UNUSED(len);
+    return 0;
+}
+
+void smc_data_reset(void) {}
+
+void smc_device_restart(void) {}
+
+int smc_display_scroll(int dx)
+{
+    if(scroll_off) {
+        return -1;
+    }
+    frame.spi_bytes += BENCH_SPI_SCROLL;
+    scroll_dx = (dx % BENCH_W + BENCH_W) % BENCH_W;
+    return 0;
+}
+
+static uint32_t tick_cb(void)
+{
+    return millis();
+}
+
+static void flush_cb(lv_display_t * disp, const lv_area_t * area, uint8_t * px_map)
+{
+    LV_UNUSED(px_map);
+    frame.areas++;
+    frame.pixels += lv_area_get_size(area);
+    frame.spi_bytes += BENCH_SPI_AREA + lv_area_get_size(area) * 2;
+    lv_display_flush_ready(disp);
+}
+
+static void touch_read_cb(lv_indev_t * indev, lv_indev_data_t * data)
+{
+    LV_UNUSED(indev);
+    data->point = touch_point;
+    data->state = touch_pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+
+// The pixel shown at x, y, the framebuffer being scrolled by scroll_dx.
+static uint16_t shown_pixel(int x, int y)
+{
+    return framebuffer[y * BENCH_W + (x - scroll_dx + BENCH_W) % BENCH_W];
+}
+
+static uint32_t framebuffer_hash(void)
+{
+    uint32_t hash = 2166136261u;
+    for(int y = 0; y < BENCH_H; y++) {
+        for(int x = 0; x < BENCH_W; x++) {
+            uint16_t px = shown_pixel(x, y);
+            hash = (hash ^ (px & 0xFF)) * 16777619u;
+            hash = (hash ^ (px >> 8)) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+static void framebuffer_dump(const char * step)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.ppm", dump_dir, step);
+    FILE * file = fopen(path, "wb");
+    if(file == NULL) {
+        perror(path);
+        return;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", BENCH_W, BENCH_H);
+    for(int i = 0; i < BENCH_W * BENCH_H; i++) {
+        uint16_t px = shown_pixel(i % BENCH_W, i / BENCH_W);
+        uint8_t rgb[3] = {(uint8_t)((px >> 11) << 3), (uint8_t)(((px >> 5) & 0x3F) << 2), (uint8_t)((px & 0x1F) << 3)};
+        fwrite(rgb, 1, sizeof(rgb), file);
+    }
+    fclose(file);
+}
+
+// Advances the clock by a refresh period and renders what changed. Returns
+// how long it took, whether or not anything was drawn.
+static uint64_t render_frame(const char * step, BenchStats * stats)
+{
+    hal_clock_advance(BENCH_FRAME_MS * 1000);
+
+    frame = {};
+    uint64_t started = wall_ns();
+    homescreen_alarms_sync();
+    lv_timer_handler();
+    uint64_t took = wall_ns() - started;
+
+    stats->spi_bytes += frame.spi_bytes;
+    if(frame.areas == 0) {
+        return took;
+    }
+
+    stats->frames++;
+    stats->total_ns += took;
+    if(took > stats->max_ns) {
+        stats->max_ns = took;
+    }
+    stats->areas += frame.areas;
+    stats->pixels += frame.pixels;
+
+    if(print_frames) {
+        printf("  %-16s %6lums %7lluus %3u areas %6u px %7u B\n", step, millis(), (unsigned long long)(took / 1000),
+               frame.areas, frame.pixels, frame.spi_bytes);
+    }
+    return took;
+}
+
+static void render_for(const char * step, int ms, BenchStats * stats)
+{
+    for(int elapsed = 0; elapsed < ms; elapsed += BENCH_FRAME_MS) {
+        render_frame(step, stats);
+    }
+}
+
+// Ticks the status bar once a second for a minute, rendering in between. The
+// minute and the battery change once, the signal wanders by a few dBm every
+// tick without changing its bars and the next alarm stays.
+static void status_minute(const char * step, BenchStats * stats)
+{
+    static const int RSSI[] = {-61, -63, -60, -64, -62, -59, -65};
+    for(int sec = 0; sec < 60; sec++) {
+        struct tm now = {};
+        now.tm_hour = 9;
+        now.tm_min = 41 + (30 + sec) / 60;
+        now.tm_sec = (30 + sec) % 60;
+
+        HomescreenStatus st;
+        st.rssi = RSSI[sec % (sizeof(RSSI) / sizeof(RSSI[0]))];
+        st.battery = sec < 45 ? 80 : 79;
+        st.next_alarm = 8 * 3600;
+        homescreen_status_tick(&now, &st);
+        render_for(step, 1000, stats);
+    }
+}
+
+static void run_step(const BenchStep * step, BenchStats * stats)
+{
+    switch(step->action) {
+        case BENCH_IDLE:
+            break;
+        case BENCH_TAP:
+            touch_point = {step->x, step->y};
+            touch_pressed = true;
+            render_for(step->name, 2 * BENCH_FRAME_MS, stats);
+            touch_pressed = false;
+            render_frame(step->name, stats);
+            break;
+        case BENCH_DRAG: {
+            int moves = step->ms / BENCH_FRAME_MS;
+            touch_pressed = true;
+            for(int i = 0; i <= moves; i++) {
+                touch_point.x = step->x + (step->x2 - step->x) * i / moves;
+                touch_point.y = step->y + (step->y2 - step->y) * i / moves;
+                render_frame(step->name, stats);
+            }
+            touch_pressed = false;
+            render_frame(step->name, stats);
+            break;
+        }
+        case BENCH_STATUS:
+            status_minute(step->name, stats);
+            break;
+        case BENCH_EDIT: {
+            Alarm alarm;
+            if(alarms.get(0, &alarm) == 0) {
+                strncat(alarm.name, " (edited)", sizeof(alarm.name) - strlen(alarm.name) - 1);
+                alarms.set(0, &alarm);
+            }
+            break;
+        }
+        case BENCH_REDRAW:
+            for(int i = 0; i < step->ms / BENCH_FRAME_MS; i++) {
+                lv_obj_invalidate(lv_screen_active());
+                render_frame(step->name, stats);
+            }
+            return;
+    }
+    render_for(step->name, step->ms, stats);
+}
+
+static void stats_add(BenchStats * stats, uint64_t ns)
+{
+    stats->frames++;
+    stats->total_ns += ns;
+    if(ns > stats->max_ns) {
+        stats->max_ns = ns;
+    }
+}
+
+// Taps x, y and returns the time from the release to the end of the first
+// frame drawn after it.
+static uint64_t tap_to_frame(int x, int y)
+{
+    BenchStats ignored = {};
+    touch_point = {x, y};
+    touch_pressed = true;
+    render_for("cycle", 2 * BENCH_FRAME_MS, &ignored);
+    touch_pressed = false;
+
+    uint64_t took = 0;
+    do {
+        took += render_frame("cycle", &ignored);
+    } while(frame.areas == 0);
+    return took;
+}
+
+static void run_cycles(int cycles)
+{
+    BenchStats alarms = {};
+    BenchStats others = {};
+    BenchStats back = {};
+    size_t first_heap = 0;
+    BenchStats ignored = {};
+
+    for(int i = 0; i < cycles; i++) {
+        int app = APP_ALARMS;
+        if(i % 2 == 1) {
+            app = (i / 2) % (APP_COUNT - 1);
+            app += app >= APP_ALARMS;
+        }
+
+        uint64_t took = tap_to_frame(APP_BUTTONS[app].x, APP_BUTTONS[app].y);
+        stats_add(app == APP_ALARMS ? &alarms : &others, took);
+        render_for("cycle", 400, &ignored);
+
+        stats_add(&back, tap_to_frame(34, 14));
+        render_for("cycle", 400, &ignored);
+
+        if(i == 0) {
+            first_heap = heap_used();
+        }
+    }
+
+    printf("\n%-16s %6s %8s %8s\n", "tap to frame", "taps", "avg us", "max us");
+    const BenchStats * rows[] = {&alarms, &others, &back};
+    const char * names[] = {"alarms", "other apps", "back"};
+    for(int i = 0; i < 3; i++) {
+        printf("%-16s %6u %8llu %8llu\n", names[i], rows[i]->frames,
+               (unsigned long long)(rows[i]->frames ? rows[i]->total_ns / rows[i]->frames / 1000 : 0),
+               (unsigned long long)(rows[i]->max_ns / 1000));
+    }
+    printf("heap KB after the first cycle %zu, after the last %zu\n", first_heap / 1024, heap_used() / 1024);
+}
+
+// Replaces the alarms in the store with count made up ones, see --alarms.
+static void fill_alarms(int count)
+{
+    for(int i = 0; i < MAX_ALARMS; i++) {
+        if(i >= count) {
+            alarms.set(i, NULL);
+            continue;
+        }
+
+        Alarm alarm = {};
+        snprintf(alarm.name, sizeof(alarm.name), "Alarm %d", i);
+        if(i % 2 == 0) {
+            snprintf(alarm.description, sizeof(alarm.description), "Take %d with water", 1 + i % 3);
+        }
+        alarm.secondMark = ((i % 24) * 60 + (i * 7) % 60) * 60;
+        for(int day = 0; day < 7; day++) {
+            if((i + day) % 3 == 0) {
+                alarm.days |= SUNDAY >> day;
+            }
+        }
+        alarms.set(i, &alarm);
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    if(getenv("GLIBC_TUNABLES") == NULL) {
+        setenv("GLIBC_TUNABLES", "glibc.malloc.tcache_count=0", 1);
+        execv("/proc/self/exe", argv);
+    }
+
+    int repeat = 1;
+    int alarm_count = 0;
+    int cycles = 0;
+    bool profile = false;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--frames") == 0) {
+            print_frames = true;
+        }
+        else if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--alarms") == 0 && i + 1 < argc) {
+            alarm_count = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            cycles = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+            dump_dir = argv[++i];
+        }
+        else if(strcmp(argv[i], "--profile") == 0) {
+            profile = true;
+        }
+        else if(strcmp(argv[i], "--no-scroll") == 0) {
+            scroll_off = true;
+        }
+        else {
+            fprintf(stderr,
+                    "usage: %s [--frames] [--repeat N] [--alarms N] [--cycles N] [--dump DIR] [--profile] "
+                    "[--no-scroll]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    hal_clock_warp();
+    lv_init();
+    lv_tick_set_cb(tick_cb);
+
+    lv_display_t * disp = lv_display_create(BENCH_W, BENCH_H);
+    lv_display_set_color_format(disp, LV_COLOR_FORMAT_RGB565);
+    lv_display_set_buffers(disp, framebuffer, NULL, sizeof(framebuffer), LV_DISPLAY_RENDER_MODE_DIRECT);
+    lv_display_set_flush_cb(disp, flush_cb);
+
+    lv_indev_t * touch = lv_indev_create();
+    lv_indev_set_type(touch, LV_INDEV_TYPE_POINTER);
+    lv_indev_set_read_cb(touch, touch_read_cb);
+
+    homescreen_create(&alarms);
+    fill_alarms(alarm_count);
+
+    if(profile) {
+        smc_draw_prof_start(disp);
+    }
+
+    printf("%-16s %6s %8s %8s %6s %8s %8s %8s %8s\n", "step", "frames", "avg us", "max us", "areas", "pixels",
+           "spi B", "heap KB", "hash");
+    for(int r = 0; r < repeat; r++) {
+        BenchStats total = {};
+        for(const BenchStep & step : SCRIPT) {
+            BenchStats stats = {};
+            run_step(&step, &stats);
+
+            printf("%-16s %6u %8llu %8llu %6u %8u %8u %8zu %08x\n", step.name, stats.frames,
+                   (unsigned long long)(stats.frames ? stats.total_ns / stats.frames / 1000 : 0),
+                   (unsigned long long)(stats.max_ns / 1000), stats.areas, stats.pixels, stats.spi_bytes,
+                   heap_used() / 1024, framebuffer_hash());
+
+            if(dump_dir != NULL) {
+                framebuffer_dump(step.name);
+            }
+
+            total.frames += stats.frames;
+            total.total_ns += stats.total_ns;
+            total.max_ns = stats.max_ns > total.max_ns ? stats.max_ns : total.max_ns;
+            total.areas += stats.areas;
+            total.pixels += stats.pixels;
+            total.spi_bytes += stats.spi_bytes;
+        }
+        printf("%-16s %6u %8llu %8llu %6u %8u %8u\n", "total", total.frames,
+               (unsigned long long)(total.frames ? total.total_ns / total.frames / 1000 : 0),
+               (unsigned long long)(total.max_ns / 1000), total.areas, total.pixels, total.spi_bytes);
+    }
+
+    if(profile) {
+        static char report[4096];
+        smc_draw_prof_report(report, sizeof(report));
+        fputs(report, stdout);
+        smc_draw_prof_stop();
+    }
+
+    if(cycles > 0) {
+        run_cycles(cycles);
+    }
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+/**
+ * smc_alarm_buzzer_play() and smc_alarm_buzzer_off() on the desktop, see
+ * buzzer_linux.h.
+ */
+#include <Arduino.h>
+#include <cstdio>
+
+#include "buzzer_linux.h"
+#include "ui.h"
+
+BuzzerEvent buzzer_timeline[BUZZER_TIMELINE_MAX];
+size_t buzzer_timeline_len;
+
+static const SMC_Melody * buzzer_melody;
+static MelodyCursor buzzer_cursor;
+static uint32_t buzzer_started;
+static uint32_t buzzer_step_at;
+
+// Records every step which would have started by now.
+static void buzzer_catch_up(void)
+{
+    uint32_t now = millis();
+    uint16_t freq;
+    uint32_t ms;
+    while(buzzer_melody != NULL && (int32_t)(now - buzzer_step_at) >= 0 &&
+          buzzer_cursor.next(buzzer_melody, &freq, &ms)) {
+        if(buzzer_timeline_len < BUZZER_TIMELINE_MAX) {
+            buzzer_timeline[buzzer_timeline_len++] = {buzzer_step_at - buzzer_started, freq, ms};
+        }
+        printf("SMC buzzer +%ums: %uHz for %ums\n", buzzer_step_at - buzzer_started, freq, ms);
+        buzzer_step_at += ms;
+    }
+}
+
+void smc_alarm_buzzer_play(const struct SMC_Melody * melody)
+{
+    buzzer_catch_up();
+    if(melody == buzzer_melody) {
+        return;
+    }
+
+    printf("SMC buzzer started playing\n");
+    buzzer_melody = melody;
+    buzzer_cursor = MelodyCursor();
+    buzzer_started = buzzer_step_at = millis();
+    buzzer_catch_up();
+}
+
+void smc_alarm_buzzer_off(void)
+{
+    if(buzzer_melody != NULL) {
+        buzzer_catch_up();
+        printf("SMC buzzer stopped playing\n");
+        buzzer_melody = NULL;
+    }
+}
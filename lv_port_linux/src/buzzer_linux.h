@@ -0,0 +1,23 @@
+#ifndef SMC_BUZZER_LINUX_H
+#define SMC_BUZZER_LINUX_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Instead of sound, smc_alarm_buzzer_play() on the desktop records the tones
+// it would have played, with the same MelodyCursor as the device, so tests can
+// compare timelines. Steps are recorded once millis() has reached them, when
+// the buzzer is next played or turned off.
+struct BuzzerEvent {
+  uint32_t at_ms;  // Since the melody started playing
+  uint16_t freq;   // 0 for silence
+  uint32_t ms;
+};
+
+#define BUZZER_TIMELINE_MAX 256
+
+// Every step since boot, the ones past BUZZER_TIMELINE_MAX are dropped.
+extern BuzzerEvent buzzer_timeline[BUZZER_TIMELINE_MAX];
+extern size_t buzzer_timeline_len;
+
+#endif
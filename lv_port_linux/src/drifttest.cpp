@@ -0,0 +1,148 @@
+/**
+ * smcdrift - runs DriftTracker against simulated RTCs for a month each.
+ *
+ * Each RTC runs off by a fixed rate and starts off by some amount. The syncs
+ * happen as Clock::handle_sync() does them: the RTC is read in whole seconds,
+ * compared against NTP time a random amount into its second, and written when
+ * the tracker asks for it, restarting its second. The next sync is
+ * next_interval_secs() later.
+ *
+ * Exits with 1 if the syncs or corrections of any RTC aren't the expected
+ * ones, or the RTC was ever found further off than the tolerance allows, so
+ * it can run as a regression test. The sub second parts come from a fixed
+ * seed, so the counts are the same every run.
+ *
+ *   smcdrift [--quiet]
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "drift.h"
+
+static const int64_t DAY_MS = 24 * 60 * 60 * 1000LL;
+static const int DAYS = 30;
+
+struct DriftCase {
+    const char * name;
+    double ppm;          // How fast the RTC runs
+    int64_t start_off_ms; // Where the RTC starts, against NTP
+    int syncs;
+    int corrections;
+};
+
+// The DS3231 is good to about 2ppm, the others are worse RTCs or a DS3231
+// far out of its temperature range. A correction leaves the RTC behind by
+// up to a second, so one running slow needs more of them.
+static const DriftCase cases[] = {
+    {"exact", 0, 0, 35, 0},
+    {"exact, set wrong", 0, 5300, 35, 1},
+    {"ds3231", 2, 0, 49, 2},
+    {"ds3231 slow", -2, 0, 64, 4},
+    {"20ppm", 20, 0, 182, 23},
+    {"-20ppm", -20, 0, 406, 56},
+    {"100ppm", 100, 0, 526, 117},
+    {"-300ppm, set wrong", -300, -8000, 720, 503},
+};
+
+// The simulated RTC, at rtc_base_ms when NTP was at ntp_base_ms.
+struct SimRtc {
+    double ppm;
+    int64_t ntp_base_ms;
+    int64_t rtc_base_ms;
+
+    int64_t now_ms(int64_t ntp_ms)
+    {
+        return rtc_base_ms + (int64_t)((ntp_ms - ntp_base_ms) * (1 + ppm / 1e6));
+    }
+
+    // Whole seconds, like the DS3231.
+    int64_t read_sec(int64_t ntp_ms)
+    {
+        int64_t ms = now_ms(ntp_ms);
+        return ms >= 0 ? ms / 1000 : (ms - 999) / 1000;
+    }
+
+    // Setting the seconds restarts the current one.
+    void write_sec(int64_t ntp_ms, int64_t sec)
+    {
+        ntp_base_ms = ntp_ms;
+        rtc_base_ms = sec * 1000;
+    }
+};
+
+static uint32_t rand_state = 1;
+
+// The sub second part of the NTP time at a sync, the same every run.
+static int64_t rand_ms(void)
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return (rand_state >> 16) % 1000;
+}
+
+static bool run(const DriftCase * c, bool quiet)
+{
+    DriftTracker drift;
+    // 2026-03-23 00:00 GMT+0
+    int64_t start_ms = 1774224000LL * 1000;
+    SimRtc rtc = {c->ppm, start_ms, start_ms + c->start_off_ms};
+
+    int syncs = 0;
+    int corrections = 0;
+    long worst_ms = 0;
+    int64_t ntp_ms = start_ms + rand_ms();
+    while(ntp_ms < start_ms + DAYS * DAY_MS) {
+        int64_t ntp_sec = ntp_ms / 1000;
+        long offset_ms = (long)((rtc.read_sec(ntp_ms) - ntp_sec) * 1000 - ntp_ms % 1000);
+        long real_ms = (long)(rtc.now_ms(ntp_ms) - ntp_ms);
+        syncs++;
+
+        // Once the first correction is done, the RTC should never have
+        // wandered further than the tolerance and the resolution allow.
+        if(corrections > 0 || c->start_off_ms == 0) {
+            if(labs(real_ms) > labs(worst_ms)) {
+                worst_ms = real_ms;
+            }
+        }
+
+        if(drift.record(ntp_sec, offset_ms)) {
+            ntp_ms += rand_ms();
+            rtc.write_sec(ntp_ms, ntp_ms / 1000);
+            drift.corrected(ntp_ms / 1000, -(long)(ntp_ms % 1000));
+            corrections++;
+        }
+
+        long interval = drift.next_interval_secs();
+        if(!quiet) {
+            printf("  day %5.2f: off by %5ldms (really %5ldms), %.2fppm, next in %lds\n",
+                   (ntp_ms - start_ms) / (double)DAY_MS, offset_ms, real_ms, drift.drift_ppm(), interval);
+        }
+        ntp_ms += interval * 1000 + rand_ms();
+    }
+
+    // Corrected only once surely out of tolerance, which the RTC can be off
+    // by up to the resolution more, or further if it drifts past that within
+    // the shortest interval.
+    long max_ms = DRIFT_TOLERANCE_MS + DRIFT_RESOLUTION_MS +
+                  (long)(fabs(c->ppm) * DRIFT_MIN_INTERVAL_SECS / 1000);
+    bool ok = syncs == c->syncs && corrections == c->corrections && labs(worst_ms) <= max_ms;
+    printf("%-20s %4d syncs (expected %d), %3d corrections (expected %d), worst %5ldms (max %ld)%s\n",
+           c->name, syncs, c->syncs, corrections, c->corrections, worst_ms, max_ms, ok ? "" : "  WRONG");
+    return ok;
+}
+
+int main(int argc, char ** argv)
+{
+    bool quiet = argc > 1 && strcmp(argv[1], "--quiet") == 0;
+
+    int wrong = 0;
+    for(const DriftCase & c : cases) {
+        if(!run(&c, quiet)) {
+            wrong++;
+        }
+    }
+
+    return wrong == 0 ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+/**
+ * The part of the Arduino core the firmware uses, for building it on Linux.
+ *
+ * Together with the smc_* functions in smc_linux.cpp this is the hardware
+ * layer of the desktop build. GPIO writes are kept in memory, the clock is
+ * CLOCK_MONOTONIC, and UARTs are ttys given in the environment, see
+ * HardwareSerial.h. On the ESP32, the Arduino core itself is the backend.
+ */
+#ifndef SMC_HAL_ARDUINO_H
+#define SMC_HAL_ARDUINO_H
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+
+#include "HardwareSerial.h"
+#include "WString.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+
+#define HAL_GPIO_PINS 40
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+// Desktop only, what digitalRead() returns for an input.
+void hal_gpio_set_input(uint8_t pin, int val);
+// Desktop only, how many times pin was written since boot.
+uint32_t hal_gpio_writes(uint8_t pin);
+
+// Desktop only, stops millis() and micros() following the real clock. From
+// then on only hal_clock_advance() and delay() move them, so simulations run
+// as fast as they can and the same every time. esp_timer callbacks run as
+// they pass their deadlines, see esp_timer.h.
+void hal_clock_warp(void);
+void hal_clock_advance(uint64_t us);
+
+// LEDC, no pin is driven, see hal_ledc_on_tone().
+#define HAL_LEDC_CHANNELS 16
+double ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+double ledcWriteTone(uint8_t channel, double freq);
+
+// Desktop only, called with every ledcWriteTone(), e.g. to record a timeline.
+void hal_ledc_on_tone(void (*fn)(uint8_t channel, double freq));
+
+// FreeRTOS critical sections, a mutex on the desktop.
+typedef std::mutex portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux) (mux)->lock()
+#define portEXIT_CRITICAL(mux) (mux)->unlock()
+#define IRAM_ATTR
+
+void esp_restart(void);
+
+#endif
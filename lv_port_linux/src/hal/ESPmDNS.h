@@ -0,0 +1,15 @@
+#ifndef SMC_HAL_ESPMDNS_H
+#define SMC_HAL_ESPMDNS_H
+
+#include <cstdint>
+
+// Nothing is announced on the desktop, every call succeeds.
+class MDNSResponder {
+ public:
+  bool begin(const char* hostname);
+  bool addService(const char* service, const char* proto, uint16_t port);
+};
+
+extern MDNSResponder MDNS;
+
+#endif
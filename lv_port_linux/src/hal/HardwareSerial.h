@@ -0,0 +1,34 @@
+#ifndef SMC_HAL_HARDWARESERIAL_H
+#define SMC_HAL_HARDWARESERIAL_H
+
+#include <cstddef>
+#include <cstdint>
+
+// As on the ESP32, including it brings in the rest of the core.
+#include "Arduino.h"
+
+#define SERIAL_8N1 0x800001c
+
+// A UART on the desktop is the tty in SMC_UART<n>, e.g. SMC_UART2 set to the
+// pty tools/modem_sim.py prints. Without it nothing is ever received and
+// writes are dropped.
+class HardwareSerial {
+ public:
+  explicit HardwareSerial(int uart_nr);
+  ~HardwareSerial();
+
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1,
+             int8_t rx_pin = -1, int8_t tx_pin = -1);
+  void end(void);
+  size_t setRxBufferSize(size_t size);
+
+  int available(void);
+  size_t read(uint8_t* buf, size_t len);
+  size_t write(const uint8_t* buf, size_t len);
+
+ private:
+  int uart_nr;
+  int fd = -1;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef SMC_HAL_LITTLEFS_H
+#define SMC_HAL_LITTLEFS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+
+// A file in the directory standing in for the flash, see LittleFSFS.
+class File {
+ public:
+  File(FILE* file = NULL) : file(file) {}
+
+  operator bool(void) const { return file != NULL; }
+  bool isDirectory(void) { return false; }
+
+  size_t readBytes(char* buf, size_t len);
+  size_t write(const uint8_t* buf, size_t len);
+  void close(void);
+
+ private:
+  FILE* file;
+};
+
+// The flash is the directory in SMC_FS_DIR, or smc_fs in the working
+// directory, shared with smc_fs_read() and smc_fs_write().
+class LittleFSFS {
+ public:
+  bool exists(const char* path);
+  File open(const char* path, const char* mode);
+  bool format(void);
+};
+
+extern LittleFSFS LittleFS;
+
+#endif
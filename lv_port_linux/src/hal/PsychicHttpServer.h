@@ -0,0 +1,141 @@
+#ifndef SMC_HAL_PSYCHICHTTPSERVER_H
+#define SMC_HAL_PSYCHICHTTPSERVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Arduino.h"
+#include "esp_err.h"
+
+// PsychicHttp on the desktop, the part of it the firmware uses. There is no
+// socket: requests come from hal_http_request(), go through the handlers
+// registered with on() like on the ESP32, and the response is kept in the
+// PsychicResponse for the caller to look at. Parameters come from the query
+// string only, and requests have no headers.
+
+enum http_method {
+  HTTP_DELETE = 0,
+  HTTP_GET = 1,
+  HTTP_HEAD = 2,
+  HTTP_POST = 3,
+  HTTP_PUT = 4,
+};
+
+const char* http_method_str(enum http_method method);
+
+class PsychicRequest;
+class PsychicResponse;
+
+typedef std::function<esp_err_t(PsychicRequest*, PsychicResponse*)>
+    PsychicHttpRequestCallback;
+
+class PsychicWebParameter {
+ public:
+  PsychicWebParameter(const String& name, const String& value)
+      : param_name(name), param_value(value) {}
+
+  const String& name(void) const { return param_name; }
+  const String& value(void) const { return param_value; }
+
+ private:
+  String param_name;
+  String param_value;
+};
+
+class PsychicRequest {
+ public:
+  // Desktop only, uri may have a query string. Upload handlers get body in
+  // pieces of chunk bytes.
+  PsychicRequest(const char* uri, const char* body, size_t len, size_t chunk);
+
+  bool hasParam(const char* name);
+  PsychicWebParameter* getParam(const char* name);
+  bool hasHeader(const char* name);
+  String header(const char* name);
+
+  esp_err_t loadBody(void);
+  const String& body(void);
+  const String& uri(void);
+
+  size_t chunk;
+
+ private:
+  String request_uri;
+  String request_body;
+  std::vector<PsychicWebParameter> params;
+};
+
+class PsychicResponse {
+ public:
+  esp_err_t send(int code);
+  // A 200 text/html.
+  esp_err_t send(const char* content);
+  esp_err_t send(int code, const char* content_type, const char* content);
+  void setContentType(const char* content_type);
+  void addHeader(const char* field, const char* value);
+
+  esp_err_t sendChunk(uint8_t* chunk, size_t chunksize);
+  esp_err_t finishChunking(void);
+
+  size_t getContentLength(void);
+
+  // Desktop only, what was sent.
+  int status = 0;
+  std::string content_type;
+  std::vector<std::pair<std::string, std::string>> headers;
+  std::string content;
+};
+
+class PsychicHandler {
+ public:
+  virtual ~PsychicHandler() {}
+  virtual esp_err_t handleRequest(PsychicRequest* request,
+                                  PsychicResponse* response) = 0;
+};
+
+class PsychicWebHandler : public PsychicHandler {
+ public:
+  void onRequest(PsychicHttpRequestCallback fn) { request_fn = fn; }
+  esp_err_t handleRequest(PsychicRequest* request,
+                          PsychicResponse* response) override;
+
+ protected:
+  PsychicHttpRequestCallback request_fn;
+};
+
+struct PsychicEndpoint {
+  std::string uri;
+  int method;
+  PsychicHandler* handler;
+};
+
+class PsychicHttpServer {
+ public:
+  virtual ~PsychicHttpServer();
+
+  PsychicEndpoint* on(const char* uri, int method,
+                      PsychicHttpRequestCallback fn);
+  PsychicEndpoint* on(const char* uri, int method, PsychicHandler* handler);
+
+  esp_err_t begin(void);
+
+  // Desktop only, see hal_http_request().
+  esp_err_t handle(int method, PsychicRequest* request,
+                   PsychicResponse* response);
+
+ private:
+  std::vector<PsychicEndpoint*> endpoints;
+};
+
+// Desktop only, runs a request through the server begin() was last called
+// on. Upload handlers get body chunk bytes at a time, as if it were arriving
+// over the network. Returns what the handler returned, or ESP_FAIL with a 404
+// in response if no endpoint matches.
+esp_err_t hal_http_request(int method, const char* uri, const char* body,
+                           size_t chunk, PsychicResponse* response);
+
+#endif
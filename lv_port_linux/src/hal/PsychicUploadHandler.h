@@ -0,0 +1,23 @@
+#ifndef SMC_HAL_PSYCHICUPLOADHANDLER_H
+#define SMC_HAL_PSYCHICUPLOADHANDLER_H
+
+#include "PsychicHttpServer.h"
+
+typedef std::function<esp_err_t(PsychicRequest* request,
+                                const String& filename, uint64_t index,
+                                uint8_t* data, size_t len, bool last)>
+    PsychicUploadCallback;
+
+// Hands the body to the upload callback as it arrives, then runs the request
+// callback. Only plain bodies, no multipart.
+class PsychicUploadHandler : public PsychicWebHandler {
+ public:
+  void onUpload(PsychicUploadCallback fn) { upload_fn = fn; }
+  esp_err_t handleRequest(PsychicRequest* request,
+                          PsychicResponse* response) override;
+
+ private:
+  PsychicUploadCallback upload_fn;
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef SMC_HAL_WSTRING_H
+#define SMC_HAL_WSTRING_H
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// The part of Arduino's String the firmware uses, PsychicHttp's requests hand
+// out parameters, headers and bodies as one.
+class String {
+ public:
+  String(void) {}
+  String(const char* str) : str(str != NULL ? str : "") {}
+  String(const char* str, size_t len) : str(str, len) {}
+
+  const char* c_str(void) const { return str.c_str(); }
+  unsigned int length(void) const { return str.length(); }
+  long toInt(void) const { return atol(str.c_str()); }
+
+  bool operator==(const char* other) const { return str == other; }
+  bool operator==(const String& other) const { return str == other.str; }
+  bool operator!=(const char* other) const { return str != other; }
+
+ private:
+  std::string str;
+};
+
+#endif
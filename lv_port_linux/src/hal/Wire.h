@@ -0,0 +1,10 @@
+#ifndef SMC_HAL_WIRE_H
+#define SMC_HAL_WIRE_H
+
+// Only so uRTCLib.h, and with it clock.h, can be included. There is no I2C on
+// the desktop and clock.cpp isn't built.
+class TwoWire {};
+
+extern TwoWire Wire;
+
+#endif
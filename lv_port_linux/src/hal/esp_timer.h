@@ -0,0 +1,33 @@
+#ifndef SMC_HAL_ESP_TIMER_H
+#define SMC_HAL_ESP_TIMER_H
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+// esp_timer on the desktop, one-shot timers only. They run with the warped
+// clock only, see hal_clock_warp(): hal_clock_advance() and delay() stop at
+// each deadline they pass, in order, and call the callback there, on the
+// calling thread. With the real clock, timers never fire.
+
+typedef void (*esp_timer_cb_t)(void* arg);
+
+struct esp_timer;
+typedef struct esp_timer* esp_timer_handle_t;
+
+struct esp_timer_create_args_t {
+  esp_timer_cb_t callback;
+  void* arg;
+  const char* name;
+};
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args,
+                           esp_timer_handle_t* out_handle);
+// ESP_ERR_INVALID_STATE if timer is already running, like on the ESP32.
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+// ESP_ERR_INVALID_STATE if timer isn't running.
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+esp_err_t esp_timer_delete(esp_timer_handle_t timer);
+int64_t esp_timer_get_time(void);
+
+#endif
@@ -0,0 +1,66 @@
+#include <LittleFS.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <climits>
+#include <cstdlib>
+
+LittleFSFS LittleFS;
+
+static void fs_path(const char * path, char * dest, size_t size)
+{
+    const char * dir = getenv("SMC_FS_DIR");
+    snprintf(dest, size, "%s/%s", dir != NULL ? dir : "smc_fs", path[0] == '/' ? path + 1 : path);
+}
+
+size_t File::readBytes(char * buf, size_t len)
+{
+    return file != NULL ? fread(buf, 1, len, file) : 0;
+}
+
+size_t File::write(const uint8_t * buf, size_t len)
+{
+    return file != NULL ? fwrite(buf, 1, len, file) : 0;
+}
+
+void File::close(void)
+{
+    if(file != NULL) {
+        fclose(file);
+        file = NULL;
+    }
+}
+
+bool LittleFSFS::exists(const char * path)
+{
+    char full[PATH_MAX];
+    fs_path(path, full, sizeof(full));
+    return access(full, F_OK) == 0;
+}
+
+File LittleFSFS::open(const char * path, const char * mode)
+{
+    char full[PATH_MAX];
+    fs_path(path, full, sizeof(full));
+    return File(fopen(full, mode[0] == 'w' ? "wb" : "rb"));
+}
+
+bool LittleFSFS::format(void)
+{
+    char dir_path[PATH_MAX];
+    fs_path("", dir_path, sizeof(dir_path));
+    DIR * dir = opendir(dir_path);
+    if(dir == NULL) {
+        return true;
+    }
+
+    while(struct dirent * entry = readdir(dir)) {
+        if(entry->d_name[0] == '.') {
+            continue;
+        }
+        char full[PATH_MAX];
+        fs_path(entry->d_name, full, sizeof(full));
+        unlink(full);
+    }
+    closedir(dir);
+    return true;
+}
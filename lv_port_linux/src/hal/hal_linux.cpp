@@ -0,0 +1,320 @@
+#include <Arduino.h>
+#include <ESPmDNS.h>
+#include <Wire.h>
+#include <esp_timer.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+static uint8_t gpio_modes[HAL_GPIO_PINS];
+static uint8_t gpio_levels[HAL_GPIO_PINS];
+static uint32_t gpio_writes[HAL_GPIO_PINS];
+
+static void (*ledc_on_tone)(uint8_t channel, double freq);
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void * arg;
+    bool armed;
+    uint64_t deadline_us;
+    esp_timer * next;
+};
+
+// Every timer created, armed or not.
+static esp_timer * timers;
+
+// See hal_clock_warp().
+static bool warped;
+static uint64_t warped_us;
+
+static uint64_t monotonic_us(void)
+{
+    if(warped) {
+        return warped_us;
+    }
+
+    static uint64_t boot;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t now = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    if(boot == 0) {
+        boot = now;
+    }
+    return now - boot;
+}
+
+unsigned long millis(void)
+{
+    return monotonic_us() / 1000;
+}
+
+unsigned long micros(void)
+{
+    return monotonic_us();
+}
+
+void delay(uint32_t ms)
+{
+    delayMicroseconds(ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    if(warped) {
+        hal_clock_advance(us);
+    }
+    else {
+        usleep(us);
+    }
+}
+
+void hal_clock_warp(void)
+{
+    if(!warped) {
+        warped_us = monotonic_us();
+        warped = true;
+    }
+}
+
+void hal_clock_advance(uint64_t us)
+{
+    uint64_t until = warped_us + us;
+
+    // One at a time, a callback may arm a timer due before until.
+    for(;;) {
+        esp_timer * due = NULL;
+        for(esp_timer * t = timers; t != NULL; t = t->next) {
+            if(t->armed && t->deadline_us <= until && (due == NULL || t->deadline_us < due->deadline_us)) {
+                due = t;
+            }
+        }
+        if(due == NULL) {
+            break;
+        }
+
+        if(due->deadline_us > warped_us) {
+            warped_us = due->deadline_us;
+        }
+        due->armed = false;
+        due->callback(due->arg);
+    }
+
+    warped_us = until;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t * args, esp_timer_handle_t * out_handle)
+{
+    if(args == NULL || args->callback == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_timer * timer = new esp_timer();
+    timer->callback = args->callback;
+    timer->arg = args->arg;
+    timer->next = timers;
+    timers = timer;
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if(timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    timer->armed = true;
+    timer->deadline_us = monotonic_us() + timeout_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if(!timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    timer->armed = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if(timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    for(esp_timer ** t = &timers; *t != NULL; t = &(*t)->next) {
+        if(*t == timer) {
+            *t = timer->next;
+            break;
+        }
+    }
+    delete timer;
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return monotonic_us();
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if(pin < HAL_GPIO_PINS) {
+        gpio_modes[pin] = mode;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if(pin < HAL_GPIO_PINS) {
+        gpio_levels[pin] = val;
+        gpio_writes[pin]++;
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    return pin < HAL_GPIO_PINS ? gpio_levels[pin] : LOW;
+}
+
+void hal_gpio_set_input(uint8_t pin, int val)
+{
+    if(pin < HAL_GPIO_PINS && gpio_modes[pin] != OUTPUT) {
+        gpio_levels[pin] = val;
+    }
+}
+
+uint32_t hal_gpio_writes(uint8_t pin)
+{
+    return pin < HAL_GPIO_PINS ? gpio_writes[pin] : 0;
+}
+
+double ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits)
+{
+    (void)resolution_bits;
+    return channel < HAL_LEDC_CHANNELS ? freq : 0;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel)
+{
+    (void)pin;
+    (void)channel;
+}
+
+double ledcWriteTone(uint8_t channel, double freq)
+{
+    if(channel >= HAL_LEDC_CHANNELS) {
+        return 0;
+    }
+    if(ledc_on_tone != NULL) {
+        ledc_on_tone(channel, freq);
+    }
+    return freq;
+}
+
+void hal_ledc_on_tone(void (*fn)(uint8_t channel, double freq))
+{
+    ledc_on_tone = fn;
+}
+
+MDNSResponder MDNS;
+TwoWire Wire;
+
+bool MDNSResponder::begin(const char * hostname)
+{
+    (void)hostname;
+    return true;
+}
+
+bool MDNSResponder::addService(const char * service, const char * proto, uint16_t port)
+{
+    (void)service;
+    (void)proto;
+    (void)port;
+    return true;
+}
+
+void esp_restart(void)
+{
+    printf("SMC restart requested, exiting\n");
+    exit(0);
+}
+
+HardwareSerial::HardwareSerial(int uart_nr) : uart_nr(uart_nr) {}
+
+HardwareSerial::~HardwareSerial()
+{
+    end();
+}
+
+// The tty keeps the line settings of its other end, the pins are the ESP32's.
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rx_pin, int8_t tx_pin)
+{
+    (void)baud;
+    (void)config;
+    (void)rx_pin;
+    (void)tx_pin;
+
+    char name[16];
+    snprintf(name, sizeof(name), "SMC_UART%d", uart_nr);
+    const char * path = getenv(name);
+    if(path == NULL) {
+        printf("SMC %s is not set, uart %d stays disconnected\n", name, uart_nr);
+        return;
+    }
+
+    fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if(fd < 0) {
+        perror(path);
+        return;
+    }
+
+    struct termios tio;
+    if(tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+}
+
+void HardwareSerial::end(void)
+{
+    if(fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+size_t HardwareSerial::setRxBufferSize(size_t size)
+{
+    return size;
+}
+
+int HardwareSerial::available(void)
+{
+    int len = 0;
+    if(fd < 0 || ioctl(fd, FIONREAD, &len) != 0) {
+        return 0;
+    }
+    return len;
+}
+
+size_t HardwareSerial::read(uint8_t * buf, size_t len)
+{
+    if(fd < 0) {
+        return 0;
+    }
+    ssize_t res = ::read(fd, buf, len);
+    return res < 0 ? 0 : res;
+}
+
+size_t HardwareSerial::write(const uint8_t * buf, size_t len)
+{
+    if(fd < 0) {
+        return len;
+    }
+    ssize_t res = ::write(fd, buf, len);
+    return res < 0 ? 0 : res;
+}
@@ -0,0 +1,230 @@
+#include <PsychicHttpServer.h>
+#include <PsychicUploadHandler.h>
+#include <cctype>
+
+// See hal_http_request().
+static PsychicHttpServer * running;
+
+const char * http_method_str(enum http_method method)
+{
+    switch(method) {
+        case HTTP_DELETE:
+            return "DELETE";
+        case HTTP_GET:
+            return "GET";
+        case HTTP_HEAD:
+            return "HEAD";
+        case HTTP_POST:
+            return "POST";
+        case HTTP_PUT:
+            return "PUT";
+    }
+    return "<unknown>";
+}
+
+// %XX and '+' in a query string.
+static std::string url_decode(const char * src, size_t len)
+{
+    std::string out;
+    for(size_t i = 0; i < len; i++) {
+        if(src[i] == '+') {
+            out += ' ';
+        }
+        else if(src[i] == '%' && i + 2 < len && isxdigit(src[i + 1]) && isxdigit(src[i + 2])) {
+            char hex[3] = {src[i + 1], src[i + 2], 0x00};
+            out += (char)strtol(hex, NULL, 16);
+            i += 2;
+        }
+        else {
+            out += src[i];
+        }
+    }
+    return out;
+}
+
+PsychicRequest::PsychicRequest(const char * uri, const char * body, size_t len, size_t chunk)
+    : chunk(chunk), request_body(body, len)
+{
+    const char * query = strchr(uri, '?');
+    if(query == NULL) {
+        request_uri = String(uri);
+        return;
+    }
+    request_uri = String(uri, query - uri);
+
+    const char * cur = query + 1;
+    while(*cur) {
+        size_t param_len = strcspn(cur, "&");
+        const char * eq = (const char *)memchr(cur, '=', param_len);
+        size_t name_len = eq != NULL ? (size_t)(eq - cur) : param_len;
+        std::string name = url_decode(cur, name_len);
+        std::string value = eq != NULL ? url_decode(eq + 1, param_len - name_len - 1) : "";
+        params.push_back(PsychicWebParameter(String(name.c_str()), String(value.c_str())));
+        cur += param_len;
+        if(*cur == '&') {
+            cur++;
+        }
+    }
+}
+
+bool PsychicRequest::hasParam(const char * name)
+{
+    return getParam(name) != NULL;
+}
+
+PsychicWebParameter * PsychicRequest::getParam(const char * name)
+{
+    for(PsychicWebParameter & param : params) {
+        if(param.name() == name) {
+            return &param;
+        }
+    }
+    return NULL;
+}
+
+bool PsychicRequest::hasHeader(const char * name)
+{
+    (void)name;
+    return false;
+}
+
+String PsychicRequest::header(const char * name)
+{
+    (void)name;
+    return String();
+}
+
+esp_err_t PsychicRequest::loadBody(void)
+{
+    return ESP_OK;
+}
+
+const String & PsychicRequest::body(void)
+{
+    return request_body;
+}
+
+const String & PsychicRequest::uri(void)
+{
+    return request_uri;
+}
+
+esp_err_t PsychicResponse::send(int code)
+{
+    status = code;
+    return ESP_OK;
+}
+
+esp_err_t PsychicResponse::send(const char * body)
+{
+    return send(200, "text/html", body);
+}
+
+esp_err_t PsychicResponse::send(int code, const char * type, const char * body)
+{
+    status = code;
+    content_type = type;
+    content = body;
+    return ESP_OK;
+}
+
+void PsychicResponse::setContentType(const char * type)
+{
+    content_type = type;
+}
+
+void PsychicResponse::addHeader(const char * field, const char * value)
+{
+    headers.push_back({field, value});
+}
+
+esp_err_t PsychicResponse::sendChunk(uint8_t * chunk, size_t chunksize)
+{
+    status = 200;
+    content.append((const char *)chunk, chunksize);
+    return ESP_OK;
+}
+
+esp_err_t PsychicResponse::finishChunking(void)
+{
+    return ESP_OK;
+}
+
+size_t PsychicResponse::getContentLength(void)
+{
+    return content.size();
+}
+
+esp_err_t PsychicWebHandler::handleRequest(PsychicRequest * request, PsychicResponse * response)
+{
+    return request_fn(request, response);
+}
+
+// An empty body never reaches the upload callback, as on the ESP32.
+esp_err_t PsychicUploadHandler::handleRequest(PsychicRequest * request, PsychicResponse * response)
+{
+    const String & body = request->body();
+    size_t chunk = request->chunk > 0 ? request->chunk : body.length();
+    for(size_t index = 0; index < body.length(); index += chunk) {
+        size_t len = body.length() - index < chunk ? body.length() - index : chunk;
+        esp_err_t err = upload_fn(request, String(), index, (uint8_t *)body.c_str() + index, len,
+                                  index + len == body.length());
+        if(err != ESP_OK) {
+            response->send(500);
+            return err;
+        }
+    }
+
+    return request_fn(request, response);
+}
+
+PsychicHttpServer::~PsychicHttpServer()
+{
+    if(running == this) {
+        running = NULL;
+    }
+    for(PsychicEndpoint * endpoint : endpoints) {
+        delete endpoint;
+    }
+}
+
+PsychicEndpoint * PsychicHttpServer::on(const char * uri, int method, PsychicHttpRequestCallback fn)
+{
+    PsychicWebHandler * handler = new PsychicWebHandler();
+    handler->onRequest(fn);
+    return on(uri, method, handler);
+}
+
+PsychicEndpoint * PsychicHttpServer::on(const char * uri, int method, PsychicHandler * handler)
+{
+    PsychicEndpoint * endpoint = new PsychicEndpoint{uri, method, handler};
+    endpoints.push_back(endpoint);
+    return endpoint;
+}
+
+esp_err_t PsychicHttpServer::begin(void)
+{
+    running = this;
+    return ESP_OK;
+}
+
+esp_err_t PsychicHttpServer::handle(int method, PsychicRequest * request, PsychicResponse * response)
+{
+    for(PsychicEndpoint * endpoint : endpoints) {
+        if(endpoint->method == method && request->uri() == endpoint->uri.c_str()) {
+            return endpoint->handler->handleRequest(request, response);
+        }
+    }
+
+    response->send(404);
+    return ESP_FAIL;
+}
+
+esp_err_t hal_http_request(int method, const char * uri, const char * body, size_t chunk,
+                           PsychicResponse * response)
+{
+    assert(running != NULL);
+
+    PsychicRequest request(uri, body != NULL ? body : "", body != NULL ? strlen(body) : 0, chunk);
+    return running->handle(method, &request, response);
+}
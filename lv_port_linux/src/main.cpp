@@ -29,14 +29,6 @@
 #include "src/lib/simulator_util.h"
 #include "src/lib/simulator_settings.h"
 
-// whatever works man, cmake is kinda confusing
-#define SMC_DESKTOP
-#include "menu/alarm.cpp"
-#include "menu/menu.h"
-#include "menu/menu.cpp"
-#include "menu/lvgl_homescreen.h"
-#include "menu/lvgl_homescreen.cpp"
-
 #include "ui.h"
 
 static char * selected_backend;
@@ -69,11 +61,10 @@ int main(int argc, char ** argv)
         die("Failed to initialize evdev");
     }
 
-    test_menu();
+    smc_init_drivers();
 
     while(1) {
-        smc_internal_loop();
-        lv_timer_handler();
+        smc_loop();
     }
 
     return 0;
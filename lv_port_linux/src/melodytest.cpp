@@ -0,0 +1,159 @@
+/**
+ * smcmelody - plays the alarm melody on the device buzzer in virtual time.
+ *
+ * Buzzer (src/buzzer.cpp) runs as on the ESP32, on the esp_timer and LEDC of
+ * src/hal, and every tone it writes is recorded with the time. Checks that it
+ * plays MELODY_ALARM's notes and lengths back to back and over again, that
+ * playing it again while it plays doesn't restart it, that stopping silences
+ * it right away and for good, that another melody cuts in from its first
+ * step, and that the desktop buzzer (buzzer_linux.cpp) plays the same
+ * timeline. Exits with 1 if a check fails, so it can run as a regression test.
+ *
+ *   smcmelody
+ */
+#include <Arduino.h>
+#include <cstdio>
+
+#include "buzzer.h"
+#include "buzzer_linux.h"
+#include "ui.h"
+
+static int failed;
+
+// MELODY_ALARM, written out: E7 E7 E7 C7 G7 with rests, a sixteenth is 60ms.
+static const BuzzerEvent ALARM_STEPS[] = {
+    {0, 2637, 120},   {120, 0, 60},   {180, 2637, 120}, {300, 0, 60},  {360, 2637, 120},
+    {480, 0, 60},     {540, 2093, 240}, {780, 3136, 240}, {1020, 0, 960},
+};
+static const int ALARM_STEP_COUNT = sizeof(ALARM_STEPS) / sizeof(ALARM_STEPS[0]);
+static const uint32_t ALARM_MS = 1980;
+
+// A6 for 200ms, then 100ms of silence.
+static const uint8_t SHORT_TONES[] = {melody_step(A6, QUARTER), melody_step(REST, EIGHTH)};
+static const SMC_Melody SHORT_MELODY = {SHORT_TONES, 2, 50};
+
+// Every ledcWriteTone() on the buzzer's channel.
+struct Tone {
+    uint64_t at_us;
+    uint16_t freq;
+};
+
+static Tone tones[64];
+static size_t tones_len;
+
+static void on_tone(uint8_t channel, double freq)
+{
+    if(channel == BUZZER_LEDC_CHANNEL && tones_len < sizeof(tones) / sizeof(tones[0])) {
+        tones[tones_len++] = {micros(), (uint16_t)freq};
+    }
+}
+
+static void check(bool ok, const char * what)
+{
+    printf("%-48s %s\n", what, ok ? "ok" : "WRONG");
+    if(!ok) {
+        failed++;
+    }
+}
+
+// Whether the tones from first on are expected, each at_us after start_us.
+// Buzzer writes the first one on a 1us timer, so everything is 1us late.
+static bool tones_are(size_t first, const Tone * expected, size_t count, uint64_t start_us)
+{
+    if(tones_len != first + count) {
+        printf("  %zu tones written, expected %zu\n", tones_len, first + count);
+        return false;
+    }
+
+    for(size_t i = 0; i < count; i++) {
+        const Tone * got = &tones[first + i];
+        uint64_t at_us = start_us + 1 + expected[i].at_us;
+        if(got->at_us != at_us || got->freq != expected[i].freq) {
+            printf("  tone %zu: +%lluus %uHz, expected +%lluus %uHz\n", i,
+                   (unsigned long long)(got->at_us - start_us), got->freq,
+                   (unsigned long long)(at_us - start_us), expected[i].freq);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether the tones from first on are count steps of MELODY_ALARM from its
+// first one, played from start_us.
+static bool tones_are_alarm(size_t first, int count, uint64_t start_us)
+{
+    Tone expected[64];
+    for(int i = 0; i < count; i++) {
+        int step = i % ALARM_STEP_COUNT;
+        expected[i] = {(i / ALARM_STEP_COUNT * ALARM_MS + ALARM_STEPS[step].at_ms) * 1000ull, ALARM_STEPS[step].freq};
+    }
+    return tones_are(first, expected, count, start_us);
+}
+
+// Whether the desktop buzzer's timeline is count steps of MELODY_ALARM.
+static bool timeline_is_alarm(int count)
+{
+    if(buzzer_timeline_len != (size_t)count) {
+        printf("  %zu steps recorded, expected %d\n", buzzer_timeline_len, count);
+        return false;
+    }
+
+    for(int i = 0; i < count; i++) {
+        int step = i % ALARM_STEP_COUNT;
+        uint32_t at_ms = i / ALARM_STEP_COUNT * ALARM_MS + ALARM_STEPS[step].at_ms;
+        const BuzzerEvent * got = &buzzer_timeline[i];
+        if(got->at_ms != at_ms || got->freq != ALARM_STEPS[step].freq || got->ms != ALARM_STEPS[step].ms) {
+            printf("  step %d: +%ums %uHz for %ums, expected +%ums %uHz for %ums\n", i, got->at_ms, got->freq,
+                   got->ms, at_ms, ALARM_STEPS[step].freq, ALARM_STEPS[step].ms);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    hal_clock_warp();
+    hal_ledc_on_tone(on_tone);
+
+    Buzzer buzzer;
+    check(buzzer.setup() == 0 && tones_len == 1 && tones[0].freq == 0, "setup silences the buzzer");
+
+    // Up to the first step of the third time round, with the desktop buzzer
+    // alongside. Playing it again halfway must not write a tone.
+    tones_len = 0;
+    uint64_t start = micros();
+    buzzer.play(&MELODY_ALARM);
+    smc_alarm_buzzer_play(&MELODY_ALARM);
+    delay(ALARM_MS - 1);
+    buzzer.play(&MELODY_ALARM);
+    smc_alarm_buzzer_play(&MELODY_ALARM);
+    delay(ALARM_MS + 2);
+    smc_alarm_buzzer_off();
+    check(buzzer.is_playing() && tones_are_alarm(0, 2 * ALARM_STEP_COUNT + 1, start),
+          "plays the alarm melody over and over");
+    check(timeline_is_alarm(2 * ALARM_STEP_COUNT + 1), "the desktop buzzer plays the same");
+
+    size_t first = tones_len;
+    start = micros();
+    buzzer.stop();
+    delay(ALARM_MS);
+    static const Tone SILENCE[] = {{0, 0}};
+    check(!buzzer.is_playing() && tones_are(first, SILENCE, 1, start), "stopping silences it right away, for good");
+
+    first = tones_len;
+    start = micros();
+    buzzer.play(&MELODY_ALARM);
+    delay(ALARM_STEPS[3].at_ms + 1);
+    check(tones_are_alarm(first, 4, start), "playing it again starts over");
+
+    first = tones_len;
+    start = micros();
+    buzzer.play(&SHORT_MELODY);
+    delay(350);
+    static const Tone SHORT_STEPS[] = {{0, 1760}, {200000, 0}, {300000, 1760}};
+    check(tones_are(first, SHORT_STEPS, 3, start), "another melody cuts in from its first step");
+
+    buzzer.stop();
+    return failed == 0 ? 0 : 1;
+}
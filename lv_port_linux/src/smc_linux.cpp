@@ -0,0 +1,249 @@
+/**
+ * The smc_* interface of src/ui.h on the desktop. The same Alarms, Motor,
+ * SMS and preferences as the device run here on top of hal/, and the
+ * filesystem is a directory. The buzzer is in buzzer_linux.cpp.
+ */
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <Arduino.h>
+#include <cassert>
+#include <climits>
+#include <cstdlib>
+
+#include "log.h"
+#include "menu/alarm.h"
+#include "menu/menu.h"
+#include "menu/preferences.h"
+#include "motor.h"
+#include "sms.h"
+#include "ui.h"
+#include LVGL_INCLUDE
+
+static const char * TAG = "main";
+
+static DevicePreferences preferences;
+static Alarms alarms;
+static Motor motor;
+static SMS sms;
+
+// SMC_FS_DIR, or smc_fs in the working directory.
+static const char * fs_dir(void)
+{
+    const char * dir = getenv("SMC_FS_DIR");
+    return dir != NULL ? dir : "smc_fs";
+}
+
+static void fs_path(const char * path, char * dest, size_t size)
+{
+    snprintf(dest, size, "%s/%s", fs_dir(), path[0] == '/' ? path + 1 : path);
+}
+
+// Fills an empty alarm storage with a few alarms to look at.
+static void add_test_alarms(void)
+{
+    if(alarms.free_slots() != MAX_ALARMS) {
+        return;
+    }
+
+    for(int i = 0; i < 5; i++) {
+        Alarm alarm = {};
+        snprintf(alarm.name, sizeof(alarm.name), "Test %d", i);
+        alarm.days = 0xF;
+        alarm.secondMark = (8 + i * 3) * 60 * 60;
+        alarms.add(&alarm);
+    }
+    assert(alarms.save_into_fs() == 0);
+}
+
+int smc_init_drivers(void)
+{
+    mkdir(fs_dir(), 0755);
+
+    preferences.setup();
+    alarms.setup();
+    add_test_alarms();
+    motor.setup();
+    assert(sms.setup() == 0);
+
+    test_menu();
+
+    time_t now_sec = time(NULL);
+    struct tm now;
+    gmtime_r(&now_sec, &now);
+    alarms.refresh(&now);
+
+    SMC_LOGI(TAG, "took %ldms to boot", millis());
+    return 0;
+}
+
+void smc_loop(void)
+{
+    smc_internal_loop();
+    lv_timer_handler();
+    sms.loop();
+
+    static time_t last_sec;
+    time_t now_sec = time(NULL);
+    if(now_sec != last_sec) {
+        last_sec = now_sec;
+        struct tm now;
+        gmtime_r(&now_sec, &now);
+        alarms.loop(now_sec);
+        smc_internal_tick(&now);
+    }
+
+    static int last_compartment;
+    if(alarms.should_move() != last_compartment) {
+        smc_motor_move(alarms.should_move());
+        last_compartment = alarms.should_move();
+    }
+    motor.loop();
+}
+
+// The SDL window has no memory of its own to scroll, the screens slide as
+// LVGL draws them.
+int smc_display_scroll(int dx)
+{
+    LV_UNUSED(dx);
+    return -1;
+}
+
+int smc_motor_steps(void)
+{
+    return motor.steps();
+}
+
+int smc_motor_compartment(void)
+{
+    return motor.compartment();
+}
+
+void smc_motor_move(int compartment)
+{
+    motor.spin_to(compartment);
+}
+
+bool smc_motor_running(void)
+{
+    return motor.is_running();
+}
+
+int smc_sms_send(char * message, char * number)
+{
+    return sms.send(message, number);
+}
+
+int smc_sms_list(SMC_SMSMessage ** dest, int max_len)
+{
+    return sms.list(dest, max_len);
+}
+
+int smc_sms_signal(void)
+{
+    return sms.signal();
+}
+
+// There is no Wi-Fi on the desktop, this is a good signal.
+int smc_wifi_signal(void)
+{
+    return -60;
+}
+
+int smc_notify(const char * message)
+{
+    printf("SMC notify: %s\n", message);
+    return 0;
+}
+
+Alarms * smc_system_alarms(void)
+{
+    return &alarms;
+}
+
+DevicePreferences * smc_system_preferences(void)
+{
+    return &preferences;
+}
+
+time_t smc_time_get(void)
+{
+    return time(NULL);
+}
+
+int smc_battery_percentage(void)
+{
+    return 50;
+}
+
+int smc_battery_powermode(void)
+{
+    return 0;
+}
+
+int smc_fs_read(const char * path, void * dest, size_t len)
+{
+    char full[PATH_MAX];
+    fs_path(path, full, sizeof(full));
+
+    FILE * file = fopen(full, "rb");
+    if(file == NULL) {
+        SMC_LOGW(TAG, "no saved data at %s, ignoring", path);
+        return -1;
+    }
+
+    size_t res = fread(dest, 1, len, file);
+    fclose(file);
+    if(res != len) {
+        SMC_LOGE(TAG, "reading from %s, res %d, size %d", path, (int)res, (int)len);
+        return -2;
+    }
+
+    return 0;
+}
+
+int smc_fs_write(const char * path, const void * src, size_t len)
+{
+    char full[PATH_MAX];
+    fs_path(path, full, sizeof(full));
+
+    FILE * file = fopen(full, "wb");
+    assert(file != NULL);
+    assert(fwrite(src, 1, len, file) == len);
+    fclose(file);
+
+    return 0;
+}
+
+void smc_data_reset(void)
+{
+    DIR * dir = opendir(fs_dir());
+    if(dir == NULL) {
+        return;
+    }
+
+    while(struct dirent * entry = readdir(dir)) {
+        if(entry->d_name[0] == '.') {
+            continue;
+        }
+        char full[PATH_MAX];
+        fs_path(entry->d_name, full, sizeof(full));
+        unlink(full);
+    }
+    closedir(dir);
+}
+
+void smc_device_restart(void)
+{
+    esp_restart();
+}
+
+time_t smc_general_uptime(void)
+{
+    return millis();
+}
+
+const char * smc_general_sw_info(void)
+{
+    return "SMC on Desktop!";
+}
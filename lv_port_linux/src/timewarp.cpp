@@ -0,0 +1,415 @@
+/**
+ * smcwarp - runs the alarm schedule for weeks of virtual time in a moment.
+ *
+ * The real Alarms, Motor and stepper driver run on top of hal/ with the clock
+ * warped (see hal_clock_warp()), jumping straight to the next second anything
+ * can happen at, and in small steps while the motor turns. A simulated
+ * patient attends every ring after --attend-after seconds, or never for every
+ * --miss-every'th ring, which is then dismissed after --give-up seconds.
+ *
+ * Each ring is checked against a schedule computed here independently of
+ * Alarms. Alarms which were due while another one rang are never rung by the
+ * firmware, they are reported as skipped. Exits with 1 if a ring came at the
+ * wrong time or for the wrong alarm, so it can run as a regression test.
+ *
+ * The firmware keeps time in GMT+0, the trace does too. Running it with e.g.
+ * TZ=Europe/Berlin across the last Sunday of March checks that nothing
+ * depends on the local timezone or DST.
+ *
+ *   smcwarp [--days 28] [--start 1774224000] [--alarms MAX_ALARMS]
+ *           [--seed 1] [--attend-after 60] [--miss-every 0] [--give-up 3600]
+ *           [--load smc_fs/alarms] [--quiet]
+ */
+#include <Arduino.h>
+#include <cstdarg>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "log.h"
+#include "menu/alarm.h"
+#include "motor.h"
+#include "ui.h"
+
+static const char * TAG = "warp";
+
+static const time_t DAY_SECS = 24 * 60 * 60;
+
+static Alarms alarms;
+static Motor motor;
+
+struct WarpOptions {
+    int days = 28;
+    time_t start = 1774224000; // Monday 2026-03-23 00:00 GMT+0
+    int alarm_count = MAX_ALARMS;
+    uint32_t seed = 1;
+    int attend_after = 60;
+    int miss_every = 0;
+    int give_up = 60 * 60;
+    const char * load = NULL;
+    bool quiet = false;
+};
+
+struct WarpStats {
+    int rings;
+    int attends;
+    int misses;
+    int skips;
+    int moves;
+    int wrong;
+    uint64_t eval_ns;
+    int evals;
+};
+
+static WarpOptions opts;
+static WarpStats stats;
+
+// The smc_* the alarms and the motor need, the filesystem kept in memory.
+static std::map<std::string, std::vector<uint8_t>> files;
+
+int smc_fs_read(const char * path, void * dest, size_t len)
+{
+    auto file = files.find(path);
+    if(file == files.end()) {
+        return -1;
+    }
+    if(file->second.size() != len) {
+        return -2;
+    }
+    memcpy(dest, file->second.data(), len);
+    return 0;
+}
+
+int smc_fs_write(const char * path, const void * src, size_t len)
+{
+    files[path].assign((const uint8_t *)src, (const uint8_t *)src + len);
+    return 0;
+}
+
+void smc_data_reset(void)
+{
+    files.clear();
+}
+
+void smc_device_restart(void)
+{
+    esp_restart();
+}
+
+static time_t now_secs(void)
+{
+    return opts.start + micros() / 1000000;
+}
+
+// Moves the virtual clock to the start of second at.
+static void warp_to(time_t at)
+{
+    uint64_t target = (uint64_t)(at - opts.start) * 1000000;
+    if(target > micros()) {
+        hal_clock_advance(target - micros());
+    }
+}
+
+static uint64_t wall_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void trace(time_t at, const char * fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void trace(time_t at, const char * fmt, ...)
+{
+    if(opts.quiet) {
+        return;
+    }
+
+    struct tm tm;
+    gmtime_r(&at, &tm);
+    char when[24];
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm);
+    printf("%s ", when);
+
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    putchar('\n');
+}
+
+// When alarm is next due at or after from, from the days and second mark
+// alone. -1 if it never is.
+static time_t reference_due(const Alarm * alarm, time_t from)
+{
+    time_t midnight = from - from % DAY_SECS;
+    for(int i = 0; i < 8; i++) {
+        time_t day = midnight + i * DAY_SECS;
+        int wday = (day / DAY_SECS + 4) % 7; // 1970-01-01 was a Thursday
+        time_t due = day + alarm->secondMark;
+        if((alarm->days & (SUNDAY >> wday)) && due >= from) {
+            return due;
+        }
+    }
+    return -1;
+}
+
+// The alarm which should ring next counting from from, the lowest index on
+// ties like Alarms::earliest_alarm(). Returns its index, -1 if none.
+static int reference_next(time_t from, time_t * due_ptr)
+{
+    int best = -1;
+    time_t best_due = 0;
+    for(int i = 0; i < MAX_ALARMS; i++) {
+        Alarm alarm;
+        if(alarms.get(i, &alarm) != 0) {
+            continue;
+        }
+        time_t due = reference_due(&alarm, from);
+        if(due >= 0 && (best == -1 || due < best_due)) {
+            best = i;
+            best_due = due;
+        }
+    }
+    *due_ptr = best_due;
+    return best;
+}
+
+// Reports every alarm that was due in [from, until) besides the one that rang.
+static void report_skipped(time_t from, time_t until, int rang_idx, time_t rang_due)
+{
+    for(int i = 0; i < MAX_ALARMS; i++) {
+        Alarm alarm;
+        if(alarms.get(i, &alarm) != 0) {
+            continue;
+        }
+        for(time_t due = reference_due(&alarm, from); due >= 0 && due < until;
+            due = reference_due(&alarm, due + 1)) {
+            if(i == rang_idx && due == rang_due) {
+                continue;
+            }
+            stats.skips++;
+            trace(due, "skip   idx %d \"%s\", due while another alarm rang", i, alarm.name);
+        }
+    }
+}
+
+static uint32_t next_random(void)
+{
+    opts.seed = opts.seed * 1103515245 + 12345;
+    return opts.seed >> 8;
+}
+
+static void generate_alarms(void)
+{
+    for(int i = 0; i < opts.alarm_count && i < MAX_ALARMS; i++) {
+        Alarm alarm = {};
+        snprintf(alarm.name, sizeof(alarm.name), "Dose %d", i);
+        do {
+            alarm.days = next_random() & 127;
+        } while(alarm.days == 0);
+        // On the minute, as set from the menu.
+        alarm.secondMark = next_random() % (24 * 60) * 60;
+        alarm.compartment = next_random() % COMPARTMENTS;
+        assert(alarms.add(&alarm) >= 0);
+    }
+}
+
+static int load_alarms(const char * path)
+{
+    FILE * file = fopen(path, "rb");
+    if(file == NULL) {
+        perror(path);
+        return -1;
+    }
+    std::vector<uint8_t> data(sizeof(Alarms));
+    size_t res = fread(data.data(), 1, data.size(), file);
+    fclose(file);
+    if(res != data.size()) {
+        SMC_LOGE(TAG, "%s is %d bytes, expected %d", path, (int)res, (int)data.size());
+        return -1;
+    }
+    files[ALARMS_PATH] = data;
+    return 0;
+}
+
+static void refresh(time_t now)
+{
+    struct tm tm;
+    gmtime_r(&now, &tm);
+    uint64_t started = wall_ns();
+    alarms.refresh(&tm);
+    stats.eval_ns += wall_ns() - started;
+    stats.evals++;
+}
+
+static void attend(time_t now)
+{
+    uint64_t started = wall_ns();
+    assert(alarms.attend(now, 0x00) == 0);
+    stats.eval_ns += wall_ns() - started;
+    stats.evals++;
+}
+
+static int parse_args(int argc, char ** argv)
+{
+    for(int i = 1; i < argc; i++) {
+        const char * arg = argv[i];
+        const char * val = i + 1 < argc ? argv[i + 1] : NULL;
+        if(strcmp(arg, "--quiet") == 0) {
+            opts.quiet = true;
+            continue;
+        }
+        if(val == NULL) {
+            fprintf(stderr, "%s needs a value\n", arg);
+            return -1;
+        }
+        i++;
+
+        if(strcmp(arg, "--days") == 0) {
+            opts.days = atoi(val);
+        }
+        else if(strcmp(arg, "--start") == 0) {
+            opts.start = atoll(val);
+        }
+        else if(strcmp(arg, "--alarms") == 0) {
+            opts.alarm_count = atoi(val);
+        }
+        else if(strcmp(arg, "--seed") == 0) {
+            opts.seed = strtoul(val, NULL, 10);
+        }
+        else if(strcmp(arg, "--attend-after") == 0) {
+            opts.attend_after = atoi(val);
+        }
+        else if(strcmp(arg, "--miss-every") == 0) {
+            opts.miss_every = atoi(val);
+        }
+        else if(strcmp(arg, "--give-up") == 0) {
+            opts.give_up = atoi(val);
+        }
+        else if(strcmp(arg, "--load") == 0) {
+            opts.load = val;
+        }
+        else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return -1;
+        }
+    }
+
+    if(opts.attend_after < 1 || opts.give_up < 1 || opts.days < 1) {
+        fprintf(stderr, "--days, --attend-after and --give-up must be positive\n");
+        return -1;
+    }
+    if(opts.alarm_count > MAX_ALARMS) {
+        fprintf(stderr, "only %d alarms fit, see MAX_ALARMS in config.h\n", MAX_ALARMS);
+        opts.alarm_count = MAX_ALARMS;
+    }
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    if(parse_args(argc, argv) != 0) {
+        return 2;
+    }
+    tzset();
+    hal_clock_warp();
+    uint64_t wall_started = wall_ns();
+
+    if(opts.load != NULL && load_alarms(opts.load) != 0) {
+        return 2;
+    }
+    alarms.setup();
+    motor.setup();
+    if(opts.load == NULL) {
+        generate_alarms();
+    }
+
+    time_t end = opts.start + opts.days * DAY_SECS;
+    time_t from = opts.start;
+    refresh(from);
+
+    int ringing = -1;
+    bool missing = false;
+    time_t rang_at = 0;
+    time_t rang_due = 0;
+    int last_compartment = alarms.should_move();
+    bool moving = false;
+    unsigned long move_started = 0;
+
+    for(time_t now = now_secs(); now < end; now = now_secs()) {
+        alarms.loop(now);
+
+        if(ringing == -1 && alarms.is_ringing() != -1) {
+            ringing = alarms.is_ringing();
+            rang_at = now;
+            stats.rings++;
+            missing = opts.miss_every > 0 && stats.rings % opts.miss_every == 0;
+
+            Alarm alarm;
+            alarms.get(ringing, &alarm);
+            int expected = reference_next(from, &rang_due);
+            // Alarms::loop() rings in the first second after when_ring.
+            if(expected != ringing || now != rang_due + 1) {
+                stats.wrong++;
+                trace(now, "WRONG  idx %d rang, expected idx %d at +%lds", ringing, expected,
+                      (long)(rang_due + 1 - opts.start));
+            }
+            trace(now, "ring   idx %d \"%s\" compartment %d", ringing, alarm.name, alarm.compartment);
+        }
+
+        if(ringing != -1 && now - rang_at >= (missing ? opts.give_up : opts.attend_after)) {
+            attend(now);
+            if(missing) {
+                stats.misses++;
+                trace(now, "miss   idx %d, dismissed after %lds", ringing, (long)(now - rang_at));
+            }
+            else {
+                stats.attends++;
+                trace(now, "attend idx %d after %lds", ringing, (long)(now - rang_at));
+            }
+            report_skipped(from, now, ringing, rang_due);
+            from = now;
+            ringing = -1;
+        }
+
+        if(alarms.should_move() != last_compartment) {
+            last_compartment = alarms.should_move();
+            if(motor.spin_to(last_compartment) == 0) {
+                stats.moves++;
+                moving = true;
+                move_started = millis();
+                trace(now, "move   to compartment %d from step %d", last_compartment, motor.steps());
+            }
+        }
+        motor.loop();
+
+        if(motor.is_running()) {
+            hal_clock_advance(100);
+            continue;
+        }
+        if(moving) {
+            moving = false;
+            trace(now, "moved  to step %d in %lums", motor.steps(), millis() - move_started);
+        }
+
+        // Nothing changes until the next second something is due at.
+        time_t next = end;
+        if(ringing != -1) {
+            next = rang_at + (missing ? opts.give_up : opts.attend_after);
+        }
+        else if(alarms.earliest_idx != -1 && alarms.when_ring + 1 < next) {
+            next = alarms.when_ring + 1;
+        }
+        warp_to(next > now ? next : now + 1);
+    }
+
+    uint64_t wall = wall_ns() - wall_started;
+    printf("%d days: %d rings, %d attended, %d missed, %d skipped, %d moves, %d wrong\n", opts.days, stats.rings,
+           stats.attends, stats.misses, stats.skips, stats.moves, stats.wrong);
+    printf("%d schedule evaluations of %d alarms, avg %lluns, %llums wall\n", stats.evals,
+           MAX_ALARMS - alarms.free_slots(), (unsigned long long)(stats.evals ? stats.eval_ns / stats.evals : 0),
+           (unsigned long long)(wall / 1000000));
+
+    return stats.wrong == 0 ? 0 : 1;
+}
@@ -1,93 +0,0 @@
-#include "./menu/../ui.h"
-#include "./menu/alarm.h"
-#include "stdlib.h"
-
-int smc_init_drivers(void);
-void smc_loop(void);
-
-// interface
-int smc_motor_steps(void)
-{
-    return 67 * 7;
-};
-
-int smc_motor_compartment(void);
-void smc_motor_move(int compartment)
-{
-    printf("SMC motor moves to %d\n", compartment);
-};
-
-bool smc_motor_running(void);
-
-int smc_sms_send(char * message, char * number);
-int smc_sms_list(struct SMC_SMSMessage ** dest, int max_len);
-int smc_sms_signal(void);
-
-int smc_wifi_add(struct SMC_WifiConfig * cfg);
-int smc_wifi_remove(char * name);
-int smc_wifi_connect(char * name);
-int smc_wifi_disconnect(void);
-int smc_wifi_signal(void);
-int smc_wifi_scan(struct SMC_WifiConfig ** dest, int max_len);
-int smc_wifi_ap(bool state, char * pass);
-
-static bool buzzer_playing;
-void smc_alarm_buzzer_play(struct SMC_Melody)
-{
-    if(!buzzer_playing) {
-        printf("SMC buzzer started playing");
-        buzzer_playing = true;
-    }
-};
-void smc_alarm_buzzer_off(void)
-{
-    if(buzzer_playing) {
-        printf("SMC buzzer stopped playing");
-        buzzer_playing = false;
-    }
-};
-
-Alarms * smc_system_alarms(void)
-{
-    static Alarms alarms = Alarms();
-    Alarm alarm;
-    for(int i = 0; i < 5; i++) {
-        char name[20];
-        snprintf(name, sizeof(name), "Test %d", i);
-        strcpy(alarm.name, name);
-        alarm.days = 0xF;
-        alarms.add(&alarm);
-    }
-    return &alarms;
-};
-
-time_t smc_time_get(void)
-{
-    return time(NULL);
-};
-
-int smc_battery_percentage(void);
-int smc_battery_powermode(void);
-void smc_battery_set_powermode(int mode);
-
-int smc_fs_read(const char * path, void * dest, size_t len)
-{
-    return 0;
-};
-int smc_fs_write(const char * path, const void * src, size_t len)
-{
-    return 0;
-};
-
-void smc_data_reset(void);
-void smc_device_restart(void);
-
-time_t smc_general_uptime(void);
-const char * smc_general_sw_info(void)
-{
-    return "SMC on Desktop!";
-}
-
-// TODO webapp interface and better names
-int smc_webapp_local_toggle(bool state);
-int smc_webapp_external_endpoints_toggle(bool state);
@@ -0,0 +1,290 @@
+/**
+ * smcweb - runs requests through the firmware's web server without a socket.
+ *
+ * Webserver, the endpoints and the route metrics run as on the device, on top
+ * of the PsychicHttp in hal/. Requests go in with hal_http_request(), bodies
+ * of uploads arrive in small chunks, like over the network.
+ *
+ * Checks that the bulk alarm format survives an export and import, that bad
+ * batches are rejected with the line and error and leave the alarms as they
+ * were, and that /api/v1/state and /metrics answer. Exits with 1 if a check
+ * fails, so it can run as a regression test.
+ *
+ * Also prints the CPU time of a GET /alarms poll with a full store, with every
+ * row rendered, as every poll was before the fragment cache, and served from
+ * the cache.
+ *
+ *   smcweb [--verbose]
+ */
+#include <Arduino.h>
+#include <PsychicHttpServer.h>
+#include <time.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "clock.h"
+#include "http_metrics.h"
+#include "menu/alarm.h"
+#include "profiler.h"
+#include "ui.h"
+#include "webserver.h"
+
+static Alarms alarms;
+static Webserver webserver;
+static bool verbose;
+static int failed;
+
+// The smc_* the web server needs, the filesystem kept in memory.
+static std::map<std::string, std::vector<uint8_t>> files;
+
+int smc_fs_read(const char * path, void * dest, size_t len)
+{
+    auto file = files.find(path);
+    if(file == files.end()) {
+        return -1;
+    }
+    if(file->second.size() != len) {
+        return -2;
+    }
+    memcpy(dest, file->second.data(), len);
+    return 0;
+}
+
+int smc_fs_write(const char * path, const void * src, size_t len)
+{
+    files[path].assign((const uint8_t *)src, (const uint8_t *)src + len);
+    return 0;
+}
+
+void smc_data_reset(void)
+{
+    files.clear();
+}
+
+void smc_device_restart(void)
+{
+    esp_restart();
+}
+
+Alarms * smc_system_alarms(void)
+{
+    return &alarms;
+}
+
+int smc_motor_steps(void)
+{
+    return 0;
+}
+
+int smc_motor_compartment(void)
+{
+    return 0;
+}
+
+void smc_motor_move(int compartment)
+{
+    (void)compartment;
+}
+
+bool smc_motor_running(void)
+{
+    return false;
+}
+
+int smc_notify(const char * message)
+{
+    (void)message;
+    return 0;
+}
+
+int smc_wifi_signal(void)
+{
+    return -60;
+}
+
+time_t smc_general_uptime(void)
+{
+    return millis();
+}
+
+const char * smc_general_sw_info(void)
+{
+    return "SMC web test";
+}
+
+// Clock is the DS3231's, the system's time stands in for it.
+int Clock::get(struct tm * now)
+{
+    time_t now_sec = time(NULL);
+    gmtime_r(&now_sec, now);
+    return 0;
+}
+
+// /profile times the device's loop, there is none here.
+void register_endpoints_profile(MetricsHttpServer * server)
+{
+    (void)server;
+}
+
+static std::string request(int method, const char * uri, const char * body, size_t chunk, int * status)
+{
+    PsychicResponse res;
+    hal_http_request(method, uri, body, chunk, &res);
+    if(verbose) {
+        printf("%s %s: %d\n%s\n", http_method_str((http_method)method), uri, res.status, res.content.c_str());
+    }
+    *status = res.status;
+    return res.content;
+}
+
+static void check(bool ok, const char * what)
+{
+    printf("%-48s %s\n", what, ok ? "ok" : "WRONG");
+    if(!ok) {
+        failed++;
+    }
+}
+
+static std::string export_alarms(void)
+{
+    int status;
+    std::string csv = request(HTTP_GET, "/alarms/export", NULL, 0, &status);
+    return status == 200 ? csv : "";
+}
+
+// Posts body as a batch, chunk bytes at a time, and checks the reply.
+static void check_batch(const char * what, const char * uri, const char * body, int status,
+                        const char * reply)
+{
+    std::string before = export_alarms();
+    int got_status;
+    std::string got = request(HTTP_POST, uri, body, 7, &got_status);
+    bool ok = got_status == status && got == reply;
+    // Nothing is stored unless the whole batch is.
+    if(status != 200) {
+        ok = ok && export_alarms() == before;
+    }
+    if(!ok) {
+        printf("  got %d \"%s\", expected %d \"%s\"\n", got_status, got.c_str(), status, reply);
+    }
+    check(ok, what);
+}
+
+static uint64_t cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Average CPU time of polling /alarms, in ns. With rerender, every row is
+// stale on each poll.
+static uint64_t alarms_poll_ns(bool rerender)
+{
+    const int polls = 2000;
+    uint64_t total = 0;
+    for(int i = 0; i < polls; i++) {
+        if(rerender) {
+            Alarms::generation++;
+            for(int idx = 0; idx < MAX_ALARMS; idx++) {
+                Alarms::versions[idx]++;
+            }
+        }
+        PsychicResponse res;
+        uint64_t start = cpu_ns();
+        hal_http_request(HTTP_GET, "/alarms", NULL, 0, &res);
+        total += cpu_ns() - start;
+    }
+    return total / polls;
+}
+
+static const char * BATCH =
+    "# name,description,compartment,category,flags,days,icon,color,second\r\n"
+    "Morning,\"Two pills, with water\",0,1,0,127,3,65535,28800\r\n"
+    "\r\n"
+    "\"Say \"\"hi\"\"\",\"line one\nline two\",1,0,0,62,0,0,43200\r\n"
+    "\"#3\",,7,255,255,255,255,0,86399";
+
+static const char * EXPORTED =
+    "# name,description,compartment,category,flags,days,icon,color,second\n"
+    "Morning,\"Two pills, with water\",0,1,0,127,3,65535,28800\n"
+    "\"Say \"\"hi\"\"\",\"line one\nline two\",1,0,0,62,0,0,43200\n"
+    "\"#3\",,7,255,255,255,255,0,86399\n";
+
+int main(int argc, char ** argv)
+{
+    verbose = argc > 1 && strcmp(argv[1], "--verbose") == 0;
+
+    alarms.setup();
+    assert(webserver.setup(&alarms) == 0);
+
+    check_batch("batch with quotes, CRLF and comments", "/alarms/batch", BATCH, 200, "3");
+    std::string csv = export_alarms();
+    check(csv == EXPORTED, "export quotes what needs it");
+    check_batch("export imports as is", "/alarms/batch?replace=1", csv.c_str(), 200, "3");
+    check(export_alarms() == EXPORTED, "and exports the same again");
+
+    check_batch("compartment out of range", "/alarms/batch", "a,,8,0,0,1,0,0,0\n", 400, "line 1: error -3");
+    check_batch("category out of range", "/alarms/batch", "a,,0,256,0,1,0,0,0\n", 400, "line 1: error -3");
+    check_batch("second out of range", "/alarms/batch", "a,,0,0,0,1,0,0,86400\n", 400, "line 1: error -3");
+    check_batch("no days", "/alarms/batch", "a,,0,0,0,0,0,0,0\n", 400, "line 1: error -3");
+    check_batch("too few fields", "/alarms/batch", "#\nok,,0,0,0,1,0,0,0\na,b,1\n", 400, "line 3: error -1");
+    check_batch("too many fields", "/alarms/batch", "a,,0,0,0,1,0,0,0,0\n", 400, "line 1: error -1");
+    check_batch("quote inside a field", "/alarms/batch", "a\"b,,0,0,0,1,0,0,0\n", 400, "line 1: error -2");
+    check_batch("unterminated quote", "/alarms/batch", "\"a,,0,0,0,1,0,0,0\n", 400, "line 1: error -2");
+    check_batch("number too long", "/alarms/batch", "a,,0000000000001,0,0,1,0,0,0\n", 400,
+                "line 1: error -2");
+    check_batch("not a number", "/alarms/batch", "a,,1x,0,0,1,0,0,0\n", 400, "line 1: error -2");
+
+    std::string long_name(sizeof(Alarm::name), 'n');
+    std::string body = long_name + ",,0,0,0,1,0,0,0\n";
+    check_batch("name too long", "/alarms/batch", body.c_str(), 400, "line 1: error -2");
+
+    body = std::string(1000, 'x') + "\n";
+    check_batch("line too long", "/alarms/batch", body.c_str(), 400, "line 1: error -5");
+
+    body = "";
+    for(int i = 0; i < MAX_ALARMS + 1; i++) {
+        body += "a,,0,0,0,1,0,0,0\n";
+    }
+    char reply[40];
+    snprintf(reply, sizeof(reply), "more than %d alarms", MAX_ALARMS);
+    check_batch("more than the store holds", "/alarms/batch?replace=1", body.c_str(), 409, reply);
+
+    body = "";
+    for(int i = 0; i < MAX_ALARMS - 2; i++) {
+        body += "a,,0,0,0,1,0,0,0\n";
+    }
+    snprintf(reply, sizeof(reply), "%d alarms, %d free", MAX_ALARMS - 2, MAX_ALARMS - 3);
+    check_batch("more than there is room for", "/alarms/batch", body.c_str(), 409, reply);
+
+    int status;
+    std::string state = request(HTTP_GET, "/api/v1/state", NULL, 0, &status);
+    check(status == 200 && state.find("\"version\":1") != std::string::npos &&
+          state.find("\"name\":\"Say \\\"hi\\\"\"") != std::string::npos,
+          "/api/v1/state");
+
+    std::string metrics = request(HTTP_GET, "/metrics", NULL, 0, &status);
+    check(status == 200 &&
+          metrics.find("smc_http_requests_total{route=\"/alarms/batch\",method=\"POST\"} 16\n") !=
+          std::string::npos,
+          "/metrics counts the batches");
+
+    request(HTTP_GET, "/nothing", NULL, 0, &status);
+    check(status == 404, "unknown routes are 404");
+
+    body = "";
+    for(int i = 0; i < MAX_ALARMS; i++) {
+        body += "\"Alarm " + std::to_string(i) + "\",Take it with water,0,0,0,127,0,0," +
+                std::to_string(i * 2000) + "\n";
+    }
+    request(HTTP_POST, "/alarms/batch?replace=1", body.c_str(), 0, &status);
+    uint64_t rendered_ns = alarms_poll_ns(true);
+    uint64_t cached_ns = alarms_poll_ns(false);
+    printf("GET /alarms, %d alarms, every row rendered: %.1fus/poll\n", MAX_ALARMS, rendered_ns / 1000.0);
+    printf("GET /alarms, %d alarms, from the cache: %.1fus/poll\n", MAX_ALARMS, cached_ns / 1000.0);
+    check(status == 200 && cached_ns < rendered_ns, "the cache is cheaper than rendering");
+
+    return failed == 0 ? 0 : 1;
+}
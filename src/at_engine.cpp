@@ -0,0 +1,262 @@
+#include "at_engine.h"
+#include <cstdio>
+#include <cstring>
+
+static const uint8_t AT_CTRL_Z = 0x1A;
+static const uint8_t AT_ESC = 0x1B;
+
+AtEngine::AtEngine(AtWriteFn write, void* write_ctx)
+    : write_fn(write), write_ctx(write_ctx) {}
+
+int AtEngine::command(const char* cmd, AtResponseFn fn, void* ctx,
+                      unsigned long timeout_ms, const char* payload) {
+  if (queue_len == AT_QUEUE_LEN) {
+    return -1;
+  }
+
+  Command* c = &queue[(queue_head + queue_len) % AT_QUEUE_LEN];
+  strncpy(c->cmd, cmd, sizeof(c->cmd) - 1);
+  c->cmd[sizeof(c->cmd) - 1] = 0x00;
+  c->has_payload = payload != NULL;
+  if (payload != NULL) {
+    strncpy(c->payload, payload, sizeof(c->payload) - 1);
+    c->payload[sizeof(c->payload) - 1] = 0x00;
+  }
+  c->timeout_ms = timeout_ms;
+  c->fn = fn;
+  c->ctx = ctx;
+  queue_len++;
+
+  // Sent by the next poll(), which knows the current time for the timeout.
+  return 0;
+}
+
+int AtEngine::on_urc(const char* prefix, AtUrcFn fn, void* ctx) {
+  if (urcs_len == AT_MAX_URCS) {
+    return -1;
+  }
+
+  urcs[urcs_len++] = {.prefix = prefix, .fn = fn, .ctx = ctx};
+  return 0;
+}
+
+void AtEngine::take_next_line(AtUrcFn fn, void* ctx) {
+  next_line = {.prefix = NULL, .fn = fn, .ctx = ctx};
+}
+
+int AtEngine::cancel(AtResponseFn fn) {
+  // Finished commands are out of the queue before their callback runs, see
+  // finish(), so only a command still waiting on the modem is in flight.
+  int first = state == AT_WAIT_PROMPT || state == AT_WAIT_RESPONSE ? 1 : 0;
+  int kept = first;
+  for (int i = first; i < queue_len; i++) {
+    Command* c = &queue[(queue_head + i) % AT_QUEUE_LEN];
+    if (c->fn == fn) {
+      continue;
+    }
+    if (kept != i) {
+      queue[(queue_head + kept) % AT_QUEUE_LEN] = *c;
+    }
+    kept++;
+  }
+
+  int dropped = queue_len - kept;
+  queue_len = kept;
+  return dropped;
+}
+
+int AtEngine::queued(void) {
+  return queue_len;
+}
+
+int AtEngine::free_slots(void) {
+  return AT_QUEUE_LEN - queue_len;
+}
+
+void AtEngine::write(const char* data, size_t len) {
+  write_fn(write_ctx, (const uint8_t*)data, len);
+}
+
+void AtEngine::send_next(void) {
+  if (queue_len == 0) {
+    state = AT_IDLE;
+    return;
+  }
+
+  Command* c = &queue[queue_head];
+  response_len = 0;
+  response[0] = 0x00;
+  sent_at = now;
+  state = c->has_payload ? AT_WAIT_PROMPT : AT_WAIT_RESPONSE;
+
+  write(c->cmd, strlen(c->cmd));
+  write("\r", 1);
+}
+
+void AtEngine::finish(int result) {
+  Command c = queue[queue_head];
+  queue_head = (queue_head + 1) % AT_QUEUE_LEN;
+  queue_len--;
+  // Whatever was half received belonged to the command which timed out.
+  if (result == AT_TIMEOUT) {
+    state = AT_RESYNC_QUIET;
+    received_at = now;
+    line_len = 0;
+  } else {
+    state = AT_IDLE;
+  }
+
+  // The callback may queue more commands, so the engine has to be idle and the
+  // finished command out of the queue before calling it.
+  if (c.fn != NULL) {
+    c.fn(c.ctx, result, response);
+  }
+
+  if (state == AT_IDLE) {
+    send_next();
+  }
+}
+
+// Whether line is the information response of the command in flight, like
+// "+CSQ: 17,0" for AT+CSQ, as opposed to an unsolicited code which happens to
+// arrive in the middle of it.
+bool AtEngine::is_own_response(const char* line) {
+  const char* cmd = queue[queue_head].cmd;
+  if (strncmp(cmd, "AT+", 3) != 0) {
+    return false;
+  }
+
+  size_t name_len = strcspn(cmd + 2, "=?");
+  return strncmp(line, cmd + 2, name_len) == 0 && line[name_len] == ':';
+}
+
+void AtEngine::handle_line(void) {
+  if (next_line.fn != NULL) {
+    Urc urc = next_line;
+    next_line = {};
+    urc.fn(urc.ctx, line);
+    return;
+  }
+
+  if (state == AT_RESYNC && strcmp(line, "OK") == 0) {
+    send_next();
+    return;
+  }
+
+  bool in_flight = state == AT_WAIT_PROMPT || state == AT_WAIT_RESPONSE;
+
+  // Echo of the command, if echo was not turned off yet.
+  if (in_flight && strcmp(line, queue[queue_head].cmd) == 0) {
+    return;
+  }
+
+  if (in_flight) {
+    if (strcmp(line, "OK") == 0) {
+      finish(AT_OK);
+      return;
+    }
+
+    if (strcmp(line, "ERROR") == 0 || strncmp(line, "+CME ERROR", 10) == 0 ||
+        strncmp(line, "+CMS ERROR", 10) == 0) {
+      // Kept in the response so the caller can see the error code.
+      snprintf(response + response_len, sizeof(response) - response_len, "%s",
+               line);
+      finish(AT_ERROR);
+      return;
+    }
+  }
+
+  if (!in_flight || line[0] != '+' || !is_own_response(line)) {
+    for (int i = 0; i < urcs_len; i++) {
+      if (strncmp(line, urcs[i].prefix, strlen(urcs[i].prefix)) == 0) {
+        urcs[i].fn(urcs[i].ctx, line);
+        return;
+      }
+    }
+  }
+
+  if (!in_flight) {
+    return;  // Unknown unsolicited line.
+  }
+
+  int res = snprintf(response + response_len, sizeof(response) - response_len,
+                     "%s\n", line);
+  if (res > 0) {
+    response_len += res;
+    if (response_len >= sizeof(response)) {
+      response_len = sizeof(response) - 1;
+    }
+  }
+}
+
+void AtEngine::feed(const uint8_t* data, size_t len, unsigned long now_ms) {
+  now = now_ms;
+  if (len > 0) {
+    received_at = now_ms;
+  }
+
+  for (size_t i = 0; i < len; i++) {
+    char ch = (char)data[i];
+
+    if (ch == '\r' || ch == '\n') {
+      if (line_len > 0) {
+        line[line_len] = 0x00;
+        handle_line();
+        line_len = 0;
+      }
+      continue;
+    }
+
+    if (line_len < sizeof(line) - 1) {
+      line[line_len++] = ch;
+    }
+
+    // The prompt is not terminated by a newline.
+    if (state == AT_WAIT_PROMPT && line_len == 2 && line[0] == '>' &&
+        line[1] == ' ') {
+      line_len = 0;
+      state = AT_WAIT_RESPONSE;
+      const char* payload = queue[queue_head].payload;
+      write(payload, strlen(payload));
+      write((const char*)&AT_CTRL_Z, 1);
+    }
+  }
+}
+
+void AtEngine::poll(unsigned long now_ms) {
+  now = now_ms;
+
+  if (state == AT_IDLE) {
+    send_next();
+    return;
+  }
+
+  // Lines until now were dropped, or handed to the URC handlers. If the "AT"
+  // goes unanswered too, the modem is waited on again.
+  if (state == AT_RESYNC_QUIET) {
+    if (now - received_at >= AT_RESYNC_QUIET_MS) {
+      state = AT_RESYNC;
+      sent_at = now;
+      write("AT\r", 3);
+    }
+    return;
+  }
+  if (state == AT_RESYNC) {
+    if (now - sent_at >= AT_DEFAULT_TIMEOUT_MS) {
+      state = AT_RESYNC_QUIET;
+      received_at = now;
+    }
+    return;
+  }
+
+  if (now - sent_at < queue[queue_head].timeout_ms) {
+    return;
+  }
+
+  // Leaves the text entry mode, otherwise the modem would swallow the next
+  // commands as message text.
+  if (state == AT_WAIT_PROMPT) {
+    write((const char*)&AT_ESC, 1);
+  }
+  finish(AT_TIMEOUT);
+}
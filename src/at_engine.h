@@ -0,0 +1,125 @@
+#ifndef SMC_AT_ENGINE_H
+#define SMC_AT_ENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+
+static const int AT_QUEUE_LEN = 12;
+static const int AT_CMD_SIZE = 48;
+static const int AT_PAYLOAD_SIZE = 2 * 160 + 1;  // A whole SMS PDU in hex
+static const int AT_LINE_SIZE = 256;
+static const int AT_RESPONSE_SIZE = 512;
+static const int AT_MAX_URCS = 4;
+
+static const unsigned long AT_DEFAULT_TIMEOUT_MS = 5000;
+// After a timeout, how long the modem has to stay quiet before the engine
+// checks it answers again, see AtEngine::poll().
+static const unsigned long AT_RESYNC_QUIET_MS = 500;
+
+enum AtResult {
+  AT_OK = 0,
+  AT_ERROR = -1,  // ERROR, +CME ERROR or +CMS ERROR
+  AT_TIMEOUT = -2,
+};
+
+// Called once a command completes. lines holds every response line before the
+// final result code (and the code itself on errors), separated by '\n'.
+typedef void (*AtResponseFn)(void* ctx, int result, const char* lines);
+// Called for every unsolicited result code line starting with the registered
+// prefix.
+typedef void (*AtUrcFn)(void* ctx, const char* line);
+// Writes raw bytes to the modem.
+typedef size_t (*AtWriteFn)(void* ctx, const uint8_t* data, size_t len);
+
+// Event driven AT command engine. Received bytes are pushed in with feed(), it
+// never reads or waits on its own, and commands are queued and sent one at a
+// time from poll() or as the previous one completes. Knows nothing about the
+// UART, so it can be driven from anywhere, including a pty on the desktop.
+//
+// A command which times out may still be answered later. Before the next
+// command is sent, the engine waits for the modem to go quiet and then for the
+// OK of a bare "AT", so a late OK or ERROR can't complete the wrong command.
+class AtEngine {
+ public:
+  AtEngine(AtWriteFn write, void* write_ctx);
+
+  // Queues cmd (without the trailing "\r"). If payload is set, it is sent
+  // after the modem's "> " prompt, followed by Ctrl-Z, as AT+CMGS wants.
+  // Returns 0, or -1 if the queue is full.
+  int command(const char* cmd, AtResponseFn fn, void* ctx,
+              unsigned long timeout_ms = AT_DEFAULT_TIMEOUT_MS,
+              const char* payload = NULL);
+
+  // Registers fn for unsolicited lines starting with prefix, such as "+CMTI".
+  // prefix must outlive the engine. Returns 0, or -1 if there is no room.
+  int on_urc(const char* prefix, AtUrcFn fn, void* ctx);
+
+  // Routes the next received line to fn, for URCs followed by a body, like
+  // +CDS in PDU mode. Meant to be called from the URC handler.
+  void take_next_line(AtUrcFn fn, void* ctx);
+
+  // Drops the commands waiting in the queue which would call fn, without
+  // calling it, for when they must not run after all. The one in flight
+  // stays. Returns how many were dropped.
+  int cancel(AtResponseFn fn);
+
+  void feed(const uint8_t* data, size_t len, unsigned long now_ms);
+  // Sends the next command and handles timeouts, call it regularly.
+  void poll(unsigned long now_ms);
+
+  int queued(void);
+  int free_slots(void);
+
+ private:
+  enum State {
+    AT_IDLE,
+    AT_WAIT_PROMPT,
+    AT_WAIT_RESPONSE,
+    AT_RESYNC_QUIET,  // Dropping lines until nothing came for a while
+    AT_RESYNC,        // Waiting for the OK of a bare "AT"
+  };
+
+  struct Command {
+    char cmd[AT_CMD_SIZE];
+    char payload[AT_PAYLOAD_SIZE];
+    bool has_payload;
+    unsigned long timeout_ms;
+    AtResponseFn fn;
+    void* ctx;
+  };
+
+  struct Urc {
+    const char* prefix;
+    AtUrcFn fn;
+    void* ctx;
+  };
+
+  void send_next(void);
+  void finish(int result);
+  void handle_line(void);
+  bool is_own_response(const char* line);
+  void write(const char* data, size_t len);
+
+  AtWriteFn write_fn;
+  void* write_ctx;
+
+  Command queue[AT_QUEUE_LEN];
+  int queue_head = 0;
+  int queue_len = 0;
+
+  State state = AT_IDLE;
+  unsigned long now = 0;
+  unsigned long sent_at = 0;
+  unsigned long received_at = 0;
+
+  char line[AT_LINE_SIZE];
+  size_t line_len = 0;
+  char response[AT_RESPONSE_SIZE];
+  size_t response_len = 0;
+
+  Urc urcs[AT_MAX_URCS];
+  int urcs_len = 0;
+  Urc next_line = {};
+};
+
+#endif
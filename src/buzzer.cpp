@@ -0,0 +1,94 @@
+#include "buzzer.h"
+#include <Arduino.h>
+#include "log.h"
+#include "pins.h"
+
+static const char* TAG = "buzzer";
+
+// Guards requested and idle between play()/stop() and the timer.
+static portMUX_TYPE buzzer_mux = portMUX_INITIALIZER_UNLOCKED;
+
+int Buzzer::setup(void) {
+  ledcSetup(BUZZER_LEDC_CHANNEL, 2000, 8);
+  ledcAttachPin(BUZZER_PIN, BUZZER_LEDC_CHANNEL);
+  ledcWriteTone(BUZZER_LEDC_CHANNEL, 0);
+
+  esp_timer_create_args_t args = {};
+  args.callback = on_step;
+  args.arg = this;
+  args.name = "buzzer";
+  if (esp_timer_create(&args, &timer) != ESP_OK) {
+    SMC_LOGE(TAG, "failed creating the timer");
+    return -1;
+  }
+
+  return 0;
+}
+
+// Runs on the esp_timer task for every step, and right away when what to play
+// changes.
+void Buzzer::on_step(void* arg) {
+  Buzzer* buzzer = (Buzzer*)arg;
+
+  portENTER_CRITICAL(&buzzer_mux);
+  const SMC_Melody* melody = buzzer->requested;
+  uint16_t freq;
+  uint32_t ms;
+  bool playing = buzzer->cursor.next(melody, &freq, &ms);
+  if (!playing) {
+    buzzer->idle = true;
+  }
+  portEXIT_CRITICAL(&buzzer_mux);
+
+  if (!playing) {
+    ledcWriteTone(BUZZER_LEDC_CHANNEL, 0);
+    return;
+  }
+
+  ledcWriteTone(BUZZER_LEDC_CHANNEL, freq);
+  // Fails if request() already restarted it, which is what it wants anyway.
+  esp_timer_start_once(buzzer->timer, ms * 1000);
+}
+
+void Buzzer::request(const SMC_Melody* melody) {
+  assert(timer != NULL);
+
+  portENTER_CRITICAL(&buzzer_mux);
+  requested = melody;
+  bool was_idle = idle;
+  if (melody != NULL) {
+    idle = false;
+  }
+  portEXIT_CRITICAL(&buzzer_mux);
+
+  // Cut the current step short so the change is heard right away.
+  if (!was_idle) {
+    esp_timer_stop(timer);
+  }
+  if (!was_idle || melody != NULL) {
+    esp_timer_start_once(timer, 1);
+  }
+}
+
+void Buzzer::play(const SMC_Melody* melody) {
+  // Called every loop while an alarm rings, so this stays a compare.
+  if (melody == requested) {
+    return;
+  }
+
+  SMC_LOGD(TAG, "playing %u steps", (unsigned)melody->tones_len);
+  request(melody);
+}
+
+void Buzzer::stop(void) {
+  if (requested == NULL) {
+    return;
+  }
+
+  SMC_LOGD(TAG, "stopping");
+  request(NULL);
+}
+
+bool Buzzer::is_playing(void) {
+  return requested != NULL;
+}
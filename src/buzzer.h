@@ -0,0 +1,34 @@
+#ifndef SMC_BUZZER_H
+#define SMC_BUZZER_H
+
+#include <esp_timer.h>
+#include "./menu/melody.h"
+
+static const int BUZZER_LEDC_CHANNEL = 0;
+
+// Plays melodies on BUZZER_PIN with LEDC, stepped by an esp_timer so the main
+// loop is never involved once playing starts.
+class Buzzer {
+ public:
+  int setup(void);
+
+  // Starts melody from the beginning, or does nothing if it is already
+  // playing. melody must stay valid until stopped.
+  void play(const SMC_Melody* melody);
+  void stop(void);
+
+  bool is_playing(void);
+
+ private:
+  static void on_step(void* arg);
+  void request(const SMC_Melody* melody);
+
+  esp_timer_handle_t timer = NULL;
+  // What play() asked for, read by the timer.
+  const SMC_Melody* volatile requested = NULL;
+  bool idle = true;
+  // Only touched from the timer.
+  MelodyCursor cursor;
+};
+
+#endif
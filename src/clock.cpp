@@ -1,47 +1,245 @@
 #include "./clock.h"
+#include <Arduino.h>
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <sys/time.h>
 #include <thirdparty/uRTCLib.h>
+#include "./log.h"
 #include "./menu/config.h"
-#include "WiFi.h"
+#include "./pins.h"
+#include "./utils.h"
 
 static const char* TAG = "clock";
 
-int Clock::sync_ntp(void) {
-  int gmt_offset = DEFAULT_GMT_OFFSET_SECS;
-  int daylight_offset = DEFAULT_DAYLIGHT_OFFSET_SECS;
+// Set from the lwIP task, handled in Clock::loop().
+static volatile bool sntp_synced = false;
 
-  if (WiFi.status() != WL_CONNECTED) {
-    ESP_LOGE(TAG, "no wifi for ntp");
-    return 1;
+// Counted in the RTC_SQW interrupt, consumed by Clock::tick().
+static volatile uint32_t sqw_edges = 0;
+static volatile uint32_t sqw_ignored = 0;
+static int64_t sqw_last_us = -CLOCK_SQW_MIN_GAP_US;
+
+// The time kept by Clock::tick(). Written from the main loop only, read from
+// the web server's task too.
+static portMUX_TYPE ticking_mux = portMUX_INITIALIZER_UNLOCKED;
+static struct tm ticking_tm;
+static time_t ticking_sec = -1;
+// The ticking time minus the RTC's, constant between reloads while every
+// edge is counted once. Learned at the first check after a reload.
+static bool rtc_skew_known = false;
+static time_t rtc_skew = 0;
+// See Clock::stepped(), only touched from the main loop.
+static bool time_stepped = false;
+
+void Clock::on_sntp_sync(struct timeval* tv) {
+  sntp_synced = true;
+}
+
+// The DS3231 increments its seconds on the falling edge.
+void IRAM_ATTR Clock::on_sqw(void) {
+  int64_t now_us = esp_timer_get_time();
+  if (now_us - sqw_last_us < CLOCK_SQW_MIN_GAP_US) {
+    sqw_ignored++;
+    return;
   }
+  sqw_last_us = now_us;
+  sqw_edges++;
+}
 
-  struct tm now;
-  for (int i = 5; i > 0; i--) {
-    // TODO FIXME make the system GMT+0 internally
-    configTime(gmt_offset, daylight_offset, NTP_SERVER_PRI, NTP_SERVER_SEC,
-               NTP_SERVER_TRI);
+void Clock::reload(int passed) {
+  time_t now = time(NULL);
+  struct tm now_tm;
+  gmtime_r(&now, &now_tm);
 
-    delay(5000);
+  if (now_tm.tm_year < 126) {
+    now = -1;
+  }
 
-    get(&now);
+  time_t moved = now - (ticking_sec + passed);
+  if (now != -1 && (ticking_sec == -1 || moved > CLOCK_STEP_SECS ||
+                    moved < -CLOCK_STEP_SECS)) {
+    time_stepped = true;
+  }
+
+  portENTER_CRITICAL(&ticking_mux);
+  ticking_sec = now;
+  ticking_tm = now_tm;
+  portEXIT_CRITICAL(&ticking_mux);
+  rtc_skew_known = false;
+}
 
-    if (now.tm_year < 126) {
-      ESP_LOGE(TAG, "year is not 2026 and onwards (got %d)", now.tm_year);
-    } else {
-      break;
+int Clock::tick(void) {
+  unsigned long now_ms = millis();
+  int elapsed;
+
+  if (use_sqw) {
+    uint32_t edges = sqw_edges;
+    elapsed = edges - seen_edges;
+    seen_edges = edges;
+
+    static uint32_t seen_ignored = 0;
+    if (sqw_ignored != seen_ignored) {
+      seen_ignored = sqw_ignored;
+      SMC_LOGW(TAG, "%u edges from the rtc came too early, is RTC_SQW "
+               "pulled up?", seen_ignored);
     }
+
+    if (elapsed > 0) {
+      last_edge_at = now_ms;
+    } else if (now_ms - last_edge_at > CLOCK_SQW_TIMEOUT_MS) {
+      SMC_LOGE(TAG, "no square wave from the rtc, ticking from millis");
+      use_sqw = false;
+      last_tick_at = now_ms;
+    }
+  } else {
+    elapsed = (now_ms - last_tick_at) / 1000;
+    last_tick_at += elapsed * 1000;
   }
 
-  if (now.tm_year < 126) {
-    ESP_LOGE(TAG, "sync from ntp failed entirely!");
-    return -1;
+  if (elapsed <= 0) {
+    return 0;
+  }
+
+  // Carrying into the minutes by hand is enough, the tick into a new hour goes
+  // through gmtime_r(), which also picks up changes to the system's time once
+  // an hour.
+  struct tm next = ticking_tm;
+  if (ticking_sec == -1 || elapsed > 1 ||
+      (next.tm_min == 59 && next.tm_sec == 59)) {
+    reload(elapsed);
+    return elapsed;
+  }
+
+  if (++next.tm_sec == 60) {
+    next.tm_sec = 0;
+    next.tm_min++;
+  }
+
+  portENTER_CRITICAL(&ticking_mux);
+  ticking_sec++;
+  ticking_tm = next;
+  portEXIT_CRITICAL(&ticking_mux);
+
+  // Once a minute, right after the edge, so the RTC already shows the second
+  // just ticked and isn't about to change. The hourly reload alone would leave
+  // a bad count for up to an hour.
+  if (use_sqw && next.tm_sec == 30) {
+    check_rtc();
+  }
+
+  return elapsed;
+}
+
+void Clock::check_rtc(void) {
+  time_t rtc_sec = read_rtc();
+  if (rtc.lostPower()) {
+    return;
+  }
+
+  time_t skew = ticking_sec - rtc_sec;
+  if (!rtc_skew_known) {
+    rtc_skew = skew;
+    rtc_skew_known = true;
+  } else if (skew != rtc_skew) {
+    SMC_LOGW(TAG, "ticking time moved by %lds against the rtc, reloading",
+             (long)(skew - rtc_skew));
+    reload(0);
+  }
+}
+
+time_t Clock::read_rtc(void) {
+  assert(rtc.refresh());
+
+  struct tm now = {};
+  now.tm_sec = rtc.second();
+  now.tm_min = rtc.minute();
+  now.tm_hour = rtc.hour();
+  now.tm_mday = rtc.day();
+  now.tm_mon = rtc.month();
+  now.tm_year = rtc.year() + 100;
+
+  return tm_to_utc(&now);
+}
+
+void Clock::write_rtc(time_t now_sec) {
+  struct tm now;
+  gmtime_r(&now_sec, &now);
+
+  rtc.set(now.tm_sec, now.tm_min, now.tm_hour, now.tm_wday, now.tm_mday,
+          now.tm_mon, now.tm_year - 100);
+
+  assert(rtc.refresh() == true);
+
+  rtc.lostPowerClear();
+}
+
+void Clock::handle_sync(void) {
+  struct timeval ntp;
+  gettimeofday(&ntp, NULL);
+  time_t rtc_sec = read_rtc();
+  long offset_ms = (rtc_sec - ntp.tv_sec) * 1000 - ntp.tv_usec / 1000;
+
+  bool lost_power = rtc.lostPower();
+  if (drift.record(ntp.tv_sec, offset_ms) || lost_power) {
+    // The RTC restarts its second when written, so it ends up behind by
+    // however far into the current second the write happens.
+    gettimeofday(&ntp, NULL);
+    write_rtc(ntp.tv_sec);
+    drift.corrected(ntp.tv_sec, -(ntp.tv_usec / 1000));
+    SMC_LOGI(TAG, "rtc was off by %ldms%s, corrected", offset_ms,
+             lost_power ? " (lost power)" : "");
   }
 
+  long interval = drift.next_interval_secs();
+  next_sync_at = millis() + interval * 1000UL;
+
+  struct tm now;
+  gmtime_r(&ntp.tv_sec, &now);
   char buf[20];
   strftime(buf, 20, "%Y-%m-%d %H:%M:%S", &now);
+  SMC_LOGI(TAG, "ntp time %s, rtc off by %ldms, drift %.2fppm, next in %lds",
+           buf, offset_ms, drift.drift_ppm(), interval);
 
-  ESP_LOGI(TAG, "current time from ntp: %s", buf);
+  reload(0);
+}
 
-  return 0;
+void Clock::loop(bool online) {
+  if (sntp_synced) {
+    sntp_synced = false;
+    if (syncing) {
+      syncing = false;
+      // Only sync when asked to, SNTP would poll on its own schedule.
+      sntp_stop();
+      handle_sync();
+    }
+  }
+
+  if (syncing && millis() - sync_started > CLOCK_SYNC_TIMEOUT_MS) {
+    SMC_LOGW(TAG, "no answer from ntp, retrying in %lums",
+             CLOCK_SYNC_RETRY_MS);
+    sntp_stop();
+    syncing = false;
+    next_sync_at = millis() + CLOCK_SYNC_RETRY_MS;
+  }
+
+  if (syncing || !online || (long)(millis() - next_sync_at) < 0) {
+    return;
+  }
+
+  if (!sntp_configured) {
+    sntp_set_sync_mode(SNTP_SYNC_MODE_IMMED);
+    sntp_set_time_sync_notification_cb(on_sntp_sync);
+    // TODO FIXME make the system GMT+0 internally
+    configTime(DEFAULT_GMT_OFFSET_SECS, DEFAULT_DAYLIGHT_OFFSET_SECS,
+               NTP_SERVER_PRI, NTP_SERVER_SEC, NTP_SERVER_TRI);
+    sntp_configured = true;
+  } else {
+    sntp_restart();
+  }
+
+  SMC_LOGD(TAG, "syncing from ntp");
+  syncing = true;
+  sync_started = millis();
 }
 
 int Clock::setup(void) {
@@ -53,59 +251,81 @@ int Clock::setup(void) {
   assert(rtc.enableBattery());
   assert(!rtc.getEOSCFlag());
 
+  if (RTC_SQW >= 0) {
+    assert(rtc.sqwgSetMode(URTCLIB_SQWG_1H));
+    pinMode(RTC_SQW, INPUT);
+    attachInterrupt(digitalPinToInterrupt(RTC_SQW), on_sqw, FALLING);
+    use_sqw = true;
+  } else {
+    SMC_LOGW(TAG, "no RTC_SQW, ticking from millis");
+  }
+  last_edge_at = last_tick_at = millis();
+
   if (rtc.lostPower()) {
-    ESP_LOGW(TAG, "rtc module lost power");
-    assert(sync_ntp() == 0);
+    SMC_LOGW(TAG, "rtc module lost power, time stays unset until ntp");
+    return 0;
+  }
 
-    struct tm now;
-    assert(get(&now) == 0);
+  struct timeval val = {.tv_sec = read_rtc()};
+  struct timezone tz = {.tz_minuteswest = DEFAULT_GMT_OFFSET_SECS / 60};
+  assert(settimeofday(&val, &tz) == 0);
 
-    rtc.set(now.tm_sec, now.tm_min, now.tm_hour, now.tm_wday, now.tm_mday,
-            now.tm_mon, now.tm_year - 100);
+  struct tm test;
 
-    assert(rtc.refresh() == true);
+  assert(get(&test) == 0);
+  assert(test.tm_year >= 126);
 
-    rtc.lostPowerClear();
-  } else {
-    struct tm now;
-    now.tm_sec = rtc.second();
-    now.tm_min = rtc.minute();
-    now.tm_hour = rtc.hour();
-    now.tm_mday = rtc.day();
-    now.tm_mon = rtc.month();
-    now.tm_year = rtc.year() + 100;
+  char buf[20];
 
-    time_t now_sec = mktime(&now);
-    struct timeval val = {.tv_sec = now_sec};
-    struct timezone tz = {.tz_minuteswest = DEFAULT_GMT_OFFSET_SECS / 60};
-    assert(settimeofday(&val, &tz) == 0);
+  strftime(buf, 20, "%Y-%m-%d %H:%M:%S", &test);
+  SMC_LOGI(TAG, "current time from rtc: %s", buf);
 
-    struct tm test;
+  reload(0);
+
+  return 0;
+}
+
+int Clock::get(struct tm* dest_tm) {
+  portENTER_CRITICAL(&ticking_mux);
+  bool ticking = ticking_sec != -1;
+  if (ticking) {
+    *dest_tm = ticking_tm;
+  }
+  portEXIT_CRITICAL(&ticking_mux);
 
-    assert(get(&test) == 0);
-    assert(test.tm_year >= 126);
+  if (ticking) {
+    return 0;
+  }
 
-    char buf[20];
+  time_t now = time(NULL);
+  gmtime_r(&now, dest_tm);
 
-    strftime(buf, 20, "%Y-%m-%d %H:%M:%S", &test);
-    ESP_LOGI(TAG, "current time from rtc: %s", buf);
+  if (dest_tm->tm_year < 126) {
+    SMC_LOGE(TAG, "year is not 2026 and onwards (got %d)", dest_tm->tm_year);
+    return -1;
   }
 
   return 0;
 }
 
-int Clock::get(struct tm* dest_tm) {
-  for (int i = 5; i > 0; i--) {
-    time_t now = time(NULL);
-    gmtime_r(&now, dest_tm);
-
-    if (dest_tm->tm_year < 126) {
-      ESP_LOGE(TAG, "year is not 2026 and onwards (got %d)", dest_tm->tm_year);
-    } else {
-      return 0;
-    }
+bool Clock::stepped(void) {
+  bool stepped = time_stepped;
+  time_stepped = false;
+  return stepped;
+}
+
+time_t Clock::now(void) {
+  portENTER_CRITICAL(&ticking_mux);
+  time_t now = ticking_sec;
+  portEXIT_CRITICAL(&ticking_mux);
+
+  if (now != -1) {
+    return now;
   }
 
-  ESP_LOGE(TAG, "failed getting local time entirely");
-  return -1;
+  struct tm test;
+  if (get(&test) != 0) {
+    return -1;
+  }
+  return time(NULL);
 }
@@ -2,20 +2,72 @@
 #define CLOCK_H
 
 #include <thirdparty/uRTCLib.h>
+#include <cstdint>
 #include <ctime>
+#include "drift.h"
+
+static const unsigned long CLOCK_SYNC_TIMEOUT_MS = 60 * 1000;
+static const unsigned long CLOCK_SYNC_RETRY_MS = 5 * 60 * 1000;
+// Without an edge from RTC_SQW for this long, ticks come from millis().
+static const unsigned long CLOCK_SQW_TIMEOUT_MS = 2500;
+// Edges from RTC_SQW closer than this to the last one are noise.
+static const int64_t CLOCK_SQW_MIN_GAP_US = 900 * 1000;
+// A reload moving the time by more than this is a step, see Clock::stepped().
+static const time_t CLOCK_STEP_SECS = 5;
 
 class Clock {
  public:
+  // Sets the system's time from the RTC module right away, unless it lost
+  // power. NTP corrects it later, see Clock::loop().
   int setup(void);
 
-  // Fetches the updated time from a set of NTP servers, and sets the system's
-  // time and the RTC module to it. Returns -1 if it cannot fetch the time.
-  static int sync_ntp(void);
+  // Runs an SNTP sync in the background when one is due and online, then
+  // compares the RTC against it and corrects the RTC if needed. The interval
+  // between syncs adapts to how well the RTC keeps time. Never waits on the
+  // network.
+  void loop(bool online);
+
+  // Returns how many seconds passed since the last call, from the RTC's 1Hz
+  // square wave, and advances the time get() returns. Cheap, call it every
+  // loop and do once a second work only when it returns more than 0.
+  int tick(void);
 
-  // Returns time in GMT+0, also checks for correctness.
+  // Returns time in GMT+0, also checks for correctness. Once ticking, this is
+  // a copy of the time kept by Clock::tick().
   static int get(struct tm* now);
+  // Same as get(), in seconds since the UNIX epoch. -1 if not set yet.
+  static time_t now(void);
+
+  // Whether the time was set for the first time, or stepped by more than
+  // CLOCK_STEP_SECS, since the last call. Anything scheduled against the old
+  // time, like the next alarm, needs to be worked out again.
+  static bool stepped(void);
 
  private:
+  static void on_sntp_sync(struct timeval* tv);
+  static void on_sqw(void);
+  // Reloads the ticking time from the system's, after it is set. passed is
+  // how many seconds went by since the ticking time was last advanced.
+  static void reload(int passed);
+
+  time_t read_rtc(void);
+  void write_rtc(time_t now_sec);
+  // Reloads the ticking time if it moved against the RTC since the last
+  // reload, an edge from RTC_SQW having been missed or taken twice.
+  void check_rtc(void);
+  void handle_sync(void);
+
   uRTCLib rtc;
+  DriftTracker drift;
+
+  bool sntp_configured = false;
+  bool syncing = false;
+  unsigned long sync_started = 0;
+  unsigned long next_sync_at = 0;
+
+  bool use_sqw = false;
+  uint32_t seen_edges = 0;
+  unsigned long last_edge_at = 0;
+  unsigned long last_tick_at = 0;
 };
 #endif
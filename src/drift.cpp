@@ -0,0 +1,70 @@
+#include "drift.h"
+#include <cstdlib>
+
+// Reading whole seconds, the measured offset is between the real one minus
+// the resolution and the real one. Only true if it is surely out of tolerance.
+static bool out_of_tolerance(long offset_ms) {
+  return offset_ms > DRIFT_TOLERANCE_MS ||
+         offset_ms + DRIFT_RESOLUTION_MS < -DRIFT_TOLERANCE_MS;
+}
+
+bool DriftTracker::record(time_t ntp_sec, long offset_ms) {
+  if (!has_base) {
+    interval_secs = DRIFT_MIN_INTERVAL_SECS;
+    if (out_of_tolerance(offset_ms)) {
+      return true;
+    }
+    corrected(ntp_sec, offset_ms);
+    return false;
+  }
+
+  long elapsed = ntp_sec - base_sec;
+  long drifted_ms = offset_ms - base_offset_ms;
+  if (elapsed > 0) {
+    ppm = drifted_ms * 1000.0f / elapsed;
+  }
+
+  if (out_of_tolerance(offset_ms)) {
+    return true;
+  }
+
+  // Worst case drift per second given the resolution, then how long until it
+  // could add up to what is left of the tolerance. The real offset is up to
+  // the resolution above offset_ms, and corrections only happen past the
+  // tolerance plus the resolution.
+  long real_ms = labs(offset_ms);
+  if (labs(offset_ms + DRIFT_RESOLUTION_MS) > real_ms) {
+    real_ms = labs(offset_ms + DRIFT_RESOLUTION_MS);
+  }
+  long left_ms = DRIFT_TOLERANCE_MS + DRIFT_RESOLUTION_MS - real_ms;
+  if (elapsed <= 0 || left_ms <= 0) {
+    interval_secs = DRIFT_MIN_INTERVAL_SECS;
+  } else {
+    long long worst_ms = labs(drifted_ms) + DRIFT_RESOLUTION_MS;
+    long long next = (long long)left_ms * elapsed / worst_ms;
+    if (next < DRIFT_MIN_INTERVAL_SECS) {
+      next = DRIFT_MIN_INTERVAL_SECS;
+    } else if (next > DRIFT_MAX_INTERVAL_SECS) {
+      next = DRIFT_MAX_INTERVAL_SECS;
+    }
+    interval_secs = next;
+  }
+
+  return false;
+}
+
+void DriftTracker::corrected(time_t ntp_sec, long residual_ms) {
+  has_base = true;
+  base_sec = ntp_sec;
+  base_offset_ms = residual_ms;
+  // The drift is known to be small enough only after the next sample.
+  interval_secs = DRIFT_MIN_INTERVAL_SECS;
+}
+
+long DriftTracker::next_interval_secs(void) {
+  return interval_secs;
+}
+
+float DriftTracker::drift_ppm(void) {
+  return ppm;
+}
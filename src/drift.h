@@ -0,0 +1,39 @@
+#ifndef SMC_DRIFT_H
+#define SMC_DRIFT_H
+
+#include <ctime>
+
+static const long DRIFT_MIN_INTERVAL_SECS = 60 * 60;
+static const long DRIFT_MAX_INTERVAL_SECS = 24 * 60 * 60;
+// How far the RTC may wander before it is corrected, and what the resync
+// interval is sized for.
+static const long DRIFT_TOLERANCE_MS = 1000;
+// The DS3231 only reads whole seconds.
+static const long DRIFT_RESOLUTION_MS = 1000;
+
+// Tracks how far the RTC runs from NTP between syncs to pick the next sync
+// interval. Rather than trusting a drift rate measured through a 1s resolution,
+// it sizes the interval for the worst drift the samples allow, so it grows
+// about twofold per sync while the RTC keeps up, up to a day.
+class DriftTracker {
+ public:
+  // Records offset_ms, the RTC minus NTP, measured at ntp_sec. Returns true if
+  // the RTC is off by more than the tolerance and should be set.
+  bool record(time_t ntp_sec, long offset_ms);
+
+  // Call after setting the RTC, residual_ms being what it is still off by.
+  void corrected(time_t ntp_sec, long residual_ms);
+
+  long next_interval_secs(void);
+  // Drift since the last correction in ppm, 0 until there are two samples.
+  float drift_ppm(void);
+
+ private:
+  bool has_base = false;
+  time_t base_sec = 0;
+  long base_offset_ms = 0;
+  float ppm = 0;
+  long interval_secs = DRIFT_MIN_INTERVAL_SECS;
+};
+
+#endif
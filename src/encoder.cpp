@@ -0,0 +1,249 @@
+#include "encoder.h"
+#include <cstdio>
+#include <cstring>
+
+StreamEncoder::StreamEncoder(EncoderFormat format, FlushFn flush, void* ctx)
+    : format(format), flush(flush), ctx(ctx) {}
+
+void StreamEncoder::write(const void* data, size_t data_len) {
+  const uint8_t* src = (const uint8_t*)data;
+  while (data_len > 0 && err == 0) {
+    if (len == sizeof(buf)) {
+      err = flush(ctx, buf, len);
+      len = 0;
+    }
+
+    size_t n = sizeof(buf) - len;
+    if (n > data_len) {
+      n = data_len;
+    }
+    memcpy(buf + len, src, n);
+    len += n;
+    src += n;
+    data_len -= n;
+  }
+}
+
+void StreamEncoder::put(uint8_t byte) {
+  write(&byte, 1);
+}
+
+void StreamEncoder::separate(void) {
+  if (after_key) {
+    after_key = false;
+    return;
+  }
+
+  if (depth > 0) {
+    if (format == ENCODER_JSON && has_elem[depth - 1]) {
+      put(',');
+    }
+    has_elem[depth - 1] = true;
+  }
+}
+
+void StreamEncoder::cbor_head(uint8_t major, uint64_t arg) {
+  uint8_t head[9];
+  head[0] = major << 5;
+
+  size_t size;
+  if (arg < 24) {
+    head[0] |= arg;
+    size = 0;
+  } else if (arg <= 0xFF) {
+    head[0] |= 24;
+    size = 1;
+  } else if (arg <= 0xFFFF) {
+    head[0] |= 25;
+    size = 2;
+  } else if (arg <= 0xFFFFFFFF) {
+    head[0] |= 26;
+    size = 4;
+  } else {
+    head[0] |= 27;
+    size = 8;
+  }
+
+  // Big endian.
+  for (size_t i = 0; i < size; i++) {
+    head[size - i] = (arg >> (8 * i)) & 0xFF;
+  }
+
+  write(head, size + 1);
+}
+
+void StreamEncoder::json_string(const char* str) {
+  put('"');
+
+  const char* run = str;
+  for (const char* c = str; *c; c++) {
+    unsigned char ch = *c;
+    if (ch != '"' && ch != '\\' && ch >= 0x20) {
+      continue;
+    }
+
+    write(run, c - run);
+    run = c + 1;
+
+    char esc[7];
+    if (ch == '"' || ch == '\\') {
+      esc[0] = '\\';
+      esc[1] = ch;
+      write(esc, 2);
+    } else {
+      snprintf(esc, sizeof(esc), "\\u%04x", ch);
+      write(esc, 6);
+    }
+  }
+  write(run, strlen(run));
+
+  put('"');
+}
+
+void StreamEncoder::begin_map(void) {
+  separate();
+  if (depth == MAX_DEPTH) {
+    err = -1;
+    return;
+  }
+  has_elem[depth++] = false;
+
+  if (format == ENCODER_JSON) {
+    put('{');
+  } else {
+    put(0xBF);
+  }
+}
+
+void StreamEncoder::end_map(void) {
+  if (depth == 0) {
+    err = -1;
+    return;
+  }
+  depth--;
+
+  put(format == ENCODER_JSON ? '}' : 0xFF);
+}
+
+void StreamEncoder::begin_array(void) {
+  separate();
+  if (depth == MAX_DEPTH) {
+    err = -1;
+    return;
+  }
+  has_elem[depth++] = false;
+
+  if (format == ENCODER_JSON) {
+    put('[');
+  } else {
+    put(0x9F);
+  }
+}
+
+void StreamEncoder::end_array(void) {
+  if (depth == 0) {
+    err = -1;
+    return;
+  }
+  depth--;
+
+  put(format == ENCODER_JSON ? ']' : 0xFF);
+}
+
+void StreamEncoder::key(const char* name) {
+  separate();
+
+  if (format == ENCODER_JSON) {
+    json_string(name);
+    put(':');
+  } else {
+    size_t name_len = strlen(name);
+    cbor_head(3, name_len);
+    write(name, name_len);
+  }
+
+  after_key = true;
+}
+
+void StreamEncoder::value_int(long long num) {
+  separate();
+
+  if (format == ENCODER_JSON) {
+    char str[21];
+    int str_len = snprintf(str, sizeof(str), "%lld", num);
+    write(str, str_len);
+  } else if (num >= 0) {
+    cbor_head(0, num);
+  } else {
+    cbor_head(1, -1 - num);
+  }
+}
+
+void StreamEncoder::value_str(const char* str) {
+  if (str == NULL) {
+    value_null();
+    return;
+  }
+
+  separate();
+
+  if (format == ENCODER_JSON) {
+    json_string(str);
+  } else {
+    size_t str_len = strlen(str);
+    cbor_head(3, str_len);
+    write(str, str_len);
+  }
+}
+
+void StreamEncoder::value_bool(bool b) {
+  separate();
+
+  if (format == ENCODER_JSON) {
+    if (b) {
+      write("true", 4);
+    } else {
+      write("false", 5);
+    }
+  } else {
+    put(b ? 0xF5 : 0xF4);
+  }
+}
+
+void StreamEncoder::value_null(void) {
+  separate();
+
+  if (format == ENCODER_JSON) {
+    write("null", 4);
+  } else {
+    put(0xF6);
+  }
+}
+
+void StreamEncoder::field_int(const char* name, long long num) {
+  key(name);
+  value_int(num);
+}
+
+void StreamEncoder::field_str(const char* name, const char* str) {
+  key(name);
+  value_str(str);
+}
+
+void StreamEncoder::field_bool(const char* name, bool b) {
+  key(name);
+  value_bool(b);
+}
+
+int StreamEncoder::finish(void) {
+  if (err == 0 && depth != 0) {
+    err = -1;
+  }
+
+  if (err == 0 && len > 0) {
+    err = flush(ctx, buf, len);
+    len = 0;
+  }
+
+  return err;
+}
@@ -0,0 +1,72 @@
+#ifndef SMC_ENCODER_H
+#define SMC_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+
+enum EncoderFormat {
+  ENCODER_JSON,
+  ENCODER_CBOR,
+};
+
+// Writes JSON or CBOR into a small fixed buffer, handing it to flush whenever
+// it fills up, so arbitrarily large documents can be streamed without any
+// allocation. Maps and arrays are written as CBOR indefinite-length items, so
+// their sizes don't need to be known up front.
+//
+// Errors are sticky: once flush fails, everything else is ignored and
+// StreamEncoder::finish() returns the error.
+class StreamEncoder {
+ public:
+  // Should return 0 on success.
+  typedef int (*FlushFn)(void* ctx, const uint8_t* data, size_t len);
+
+  StreamEncoder(EncoderFormat format, FlushFn flush, void* ctx);
+
+  void begin_map(void);
+  void end_map(void);
+  void begin_array(void);
+  void end_array(void);
+
+  // Inside a map, every value must be preceded by its key.
+  void key(const char* name);
+
+  void value_int(long long num);
+  void value_str(const char* str);
+  void value_bool(bool b);
+  void value_null(void);
+
+  // Shorthands for key() followed by the matching value_*().
+  void field_int(const char* name, long long num);
+  void field_str(const char* name, const char* str);
+  void field_bool(const char* name, bool b);
+
+  // Flushes whatever is left in the buffer. Returns the first error returned by
+  // flush, -1 if the nesting was unbalanced, or 0.
+  int finish(void);
+
+ private:
+  static const int MAX_DEPTH = 8;
+
+  void write(const void* data, size_t len);
+  void put(uint8_t byte);
+  void separate(void);
+  void cbor_head(uint8_t major, uint64_t arg);
+  void json_string(const char* str);
+
+  EncoderFormat format;
+  FlushFn flush;
+  void* ctx;
+  int err = 0;
+
+  uint8_t buf[128];
+  size_t len = 0;
+
+  int depth = 0;
+  // Whether the container at each depth already has an element, for JSON
+  // commas.
+  bool has_elem[MAX_DEPTH];
+  bool after_key = false;
+};
+
+#endif
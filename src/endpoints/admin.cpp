@@ -1,14 +1,15 @@
 #include "LittleFS.h"
 #include "PsychicHttpServer.h"
+#include "http_metrics.h"
 #include "utils.h"
 
 static const char* TAG = "endpoint_admin";
 
-int register_endpoints_admin(PsychicHttpServer* server) {
+int register_endpoints_admin(MetricsHttpServer* server) {
   server->on("/upload/index.html", HTTP_POST,
              [](PsychicRequest* req, PsychicResponse* res) {
                assert(req->loadBody() == 0);
-               ESP_LOGD(TAG, "body: %d, %s", req->body().length(),
+               SMC_LOGD(TAG, "body: %d, %s", req->body().length(),
                         req->body().c_str());
                fs_mutex.lock();
                File file = LittleFS.open("/index.html", FILE_WRITE);
@@ -0,0 +1,465 @@
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include "PsychicHttpServer.h"
+#include "clock.h"
+#include "encoder.h"
+#include "endpoints.h"
+#include "menu/alarm.h"
+#include "motor.h"
+#include "ui.h"
+#include "utils.h"
+
+static const char* TAG = "endpoint_data";
+
+static const int STATE_API_VERSION = 1;
+
+// Bulk alarm format, one alarm per line, fields separated by commas:
+//
+//   name,description,compartment,category,flags,days,icon,color,second
+//
+// A name or description with a comma, a quote or a newline in it, or one
+// starting with '#', is quoted as "...", with "" for a quote. category,
+// flags, days and icon are 0 to 255, color 0 to 65535 and second 0 to 86399.
+// Empty lines and lines starting with '#' are ignored.
+static const int ALARM_CSV_FIELDS = 9;
+// The longest line, a name and description quoted with nothing but quotes
+// in them and the numbers.
+static const size_t ALARM_CSV_LINE_SIZE =
+    2 * (sizeof(Alarm::name) + sizeof(Alarm::description)) + 64;
+
+// Copies the field at *cur into dest, unquoting it, and moves *cur past its
+// comma. Returns 0 if a field follows, 1 if the line ended, -1 if the field
+// doesn't fit into size or its quotes are malformed.
+static int csv_field(const char** cur, const char* end, char* dest,
+                     size_t size) {
+  const char* src = *cur;
+  size_t len = 0;
+
+  if (src < end && *src == '"') {
+    src++;
+    for (;;) {
+      if (src == end) {
+        return -1;
+      }
+      if (*src == '"') {
+        src++;
+        if (src == end || *src != '"') {
+          break;
+        }
+      }
+      if (len + 1 >= size) {
+        return -1;
+      }
+      dest[len++] = *src++;
+    }
+  } else {
+    while (src < end && *src != ',') {
+      if (*src == '"' || len + 1 >= size) {
+        return -1;
+      }
+      dest[len++] = *src++;
+    }
+  }
+  dest[len] = 0x00;
+
+  if (src == end) {
+    *cur = src;
+    return 1;
+  }
+  if (*src != ',') {
+    return -1;
+  }
+  *cur = src + 1;
+  return 0;
+}
+
+// Writes src into dest as a field of the bulk format, quoted if need be.
+// Returns the length, the field being cut at size - 1.
+static size_t csv_quote(char* dest, size_t size, const char* src) {
+  bool quote = src[0] == '#' || strpbrk(src, ",\"\r\n") != NULL;
+  size_t len = 0;
+  if (quote && len + 1 < size) {
+    dest[len++] = '"';
+  }
+  for (const char* c = src; *c; c++) {
+    if (*c == '"' && len + 1 < size) {
+      dest[len++] = '"';
+    }
+    if (len + 1 < size) {
+      dest[len++] = *c;
+    }
+  }
+  if (quote && len + 1 < size) {
+    dest[len++] = '"';
+  }
+  dest[len] = 0x00;
+  return len;
+}
+
+// Parses one line of the bulk format into alarm. Returns 0 on success, -1 if
+// the line has the wrong amount of fields, -2 if a field is malformed or too
+// long, -3 if a number is out of range or Alarms::set() rejects the alarm.
+static int parse_alarm_line(const char* line, const char* end,
+                            struct Alarm* alarm) {
+  static const long MIN[ALARM_CSV_FIELDS - 2] = {0, 0, 0, 0, 0, 0, 0};
+  static const long MAX[ALARM_CSV_FIELDS - 2] = {
+      COMPARTMENTS - 1, 255, 255, 255, 255, 65535, 24 * 60 * 60 - 1,
+  };
+
+  memset(alarm, 0, sizeof(Alarm));
+
+  long values[ALARM_CSV_FIELDS - 2];
+  const char* cur = line;
+
+  int res = csv_field(&cur, end, alarm->name, sizeof(alarm->name));
+  if (res == 0) {
+    res = csv_field(&cur, end, alarm->description, sizeof(alarm->description));
+  }
+
+  for (int i = 0; i < ALARM_CSV_FIELDS - 2; i++) {
+    if (res != 0) {
+      return res == 1 ? -1 : -2;
+    }
+    // Long enough for any number in range, anything longer is malformed
+    char num[12];
+    res = csv_field(&cur, end, num, sizeof(num));
+    if (res == -1) {
+      return -2;
+    }
+    char* num_end;
+    values[i] = strtol(num, &num_end, 10);
+    if (num_end == num || *num_end != 0x00) {
+      return -2;
+    }
+    if (values[i] < MIN[i] || values[i] > MAX[i]) {
+      return -3;
+    }
+  }
+
+  if (res != 1) {
+    return -1;
+  }
+
+  alarm->compartment = (char)values[0];
+  alarm->category = (char)values[1];
+  alarm->flags = (char)values[2];
+  alarm->days = (char)values[3];
+  alarm->icon = (char)values[4];
+  alarm->color = (short)values[5];
+  alarm->secondMark = (int)values[6];
+
+  Alarms* alarms = smc_system_alarms();
+  if (alarms->set(-1, alarm) != 0) {
+    return -3;
+  }
+
+  return 0;
+}
+
+// A POST /alarms/batch being received. The body is parsed a line at a time as
+// it arrives, into alarms, so nothing is stored unless all of it is valid.
+struct AlarmBatch {
+  Alarm alarms[MAX_ALARMS];
+  int count;
+  int lineno;  // 1-based, of the line in line
+  int err;     // Of the first bad line, see parse_alarm_line(), 0 if none
+  int bad_line;
+  bool done;    // The whole body arrived
+  bool quoted;  // In a quoted field, where a newline doesn't end the line
+  size_t len;
+  char line[ALARM_CSV_LINE_SIZE];
+};
+
+// Only while a batch is being received, PsychicHttp handles one request at a
+// time. Left for the next batch if the client goes away halfway.
+static AlarmBatch* batch = NULL;
+
+// Too many alarms for the store, a 409 rather than a 400.
+static const int BATCH_TOO_MANY = -4;
+// A line longer than ALARM_CSV_LINE_SIZE.
+static const int BATCH_LINE_TOO_LONG = -5;
+
+static void batch_line_end(void) {
+  batch->lineno++;
+  size_t len = batch->len;
+  batch->len = 0;
+  batch->quoted = false;
+
+  // Tolerate CRLF bodies.
+  if (len > 0 && batch->line[len - 1] == '\r') {
+    len--;
+  }
+  if (batch->err != 0 || len == 0 || batch->line[0] == '#') {
+    return;
+  }
+
+  int err = BATCH_TOO_MANY;
+  if (batch->count < MAX_ALARMS) {
+    err = parse_alarm_line(batch->line, batch->line + len,
+                           &batch->alarms[batch->count]);
+  }
+  if (err != 0) {
+    batch->err = err;
+    batch->bad_line = batch->lineno;
+    return;
+  }
+  batch->count++;
+}
+
+static void batch_feed(const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len && batch->err == 0; i++) {
+    char c = (char)data[i];
+    if (c == '\n' && !batch->quoted) {
+      batch_line_end();
+      continue;
+    }
+    if (c == '"') {
+      batch->quoted = !batch->quoted;
+    }
+    if (batch->len == sizeof(batch->line)) {
+      batch->err = BATCH_LINE_TOO_LONG;
+      batch->bad_line = batch->lineno + 1;
+      return;
+    }
+    batch->line[batch->len++] = c;
+  }
+}
+
+static int encoder_flush_chunk(void* ctx, const uint8_t* data, size_t len) {
+  return metrics_send_chunk((PsychicResponse*)ctx, data, len);
+}
+
+// Writes the whole device state as one map; see /api/v1/state.
+static void encode_state(StreamEncoder* enc) {
+  Alarms* alarms = smc_system_alarms();
+
+  struct tm now;
+  Clock::get(&now);
+  time_t now_sec = time(NULL);
+  int today_sec = (now.tm_hour * 60 * 60) + (now.tm_min * 60) + now.tm_sec;
+
+  enc->begin_map();
+  enc->field_int("version", STATE_API_VERSION);
+  enc->field_int("time", now_sec);
+  enc->field_int("uptime_ms", smc_general_uptime());
+
+  enc->key("firmware");
+  enc->begin_map();
+  enc->field_str("info", smc_general_sw_info());
+  enc->field_str("build", __DATE__ " " __TIME__);
+  enc->end_map();
+
+  enc->key("wifi");
+  enc->begin_map();
+  enc->field_int("rssi", smc_wifi_signal());
+  enc->end_map();
+
+  enc->key("motor");
+  enc->begin_map();
+  enc->field_int("steps", smc_motor_steps());
+  enc->field_int("compartment", smc_motor_compartment());
+  enc->field_bool("running", smc_motor_running());
+  enc->end_map();
+
+  int ring_idx;
+  time_t when_ring = alarms->ring_in(&ring_idx);
+  enc->key("next_ring");
+  if (ring_idx == -1) {
+    enc->value_null();
+  } else {
+    enc->begin_map();
+    enc->field_int("idx", ring_idx);
+    enc->field_int("when", when_ring);
+    enc->end_map();
+  }
+  enc->field_int("ringing", alarms->is_ringing());
+
+  enc->key("alarms");
+  enc->begin_array();
+  for (int i = 0; i < MAX_ALARMS; i++) {
+    Alarm alarm;
+    if (alarms->get(i, &alarm) < 0) {
+      continue;
+    }
+
+    enc->begin_map();
+    enc->field_int("idx", i);
+    enc->field_str("name", alarm.name);
+    enc->field_str("description", alarm.description);
+    enc->field_int("compartment", alarm.compartment);
+    enc->field_int("category", alarm.category);
+    enc->field_int("flags", alarm.flags);
+    enc->field_int("days", alarm.days);
+    enc->field_int("icon", alarm.icon);
+    enc->field_int("color", alarm.color);
+    enc->field_int("second", alarm.secondMark);
+    enc->field_int("last_reminded", alarm.lastReminded);
+    enc->field_int("next", now_sec + Alarms::next_schedule(&alarm, now.tm_wday,
+                                                           today_sec));
+    enc->end_map();
+  }
+  enc->end_array();
+
+  enc->end_map();
+}
+
+void register_endpoints_data(MetricsHttpServer* server) {
+  // Everything a client needs to show the device in one response. JSON by
+  // default, CBOR with format=cbor or an Accept header asking for it.
+  server->on(
+      "/api/v1/state", HTTP_GET, [](PsychicRequest* req, PsychicResponse* res) {
+        EncoderFormat format = ENCODER_JSON;
+        if (req->hasParam("format")) {
+          if (req->getParam("format")->value() == "cbor") {
+            format = ENCODER_CBOR;
+          }
+        } else if (req->hasHeader("Accept") &&
+                   strstr(req->header("Accept").c_str(), "application/cbor")) {
+          format = ENCODER_CBOR;
+        }
+
+        res->setContentType(format == ENCODER_CBOR ? "application/cbor"
+                                                   : "application/json");
+        res->addHeader("Cache-Control", "no-cache");
+
+        StreamEncoder enc(format, encoder_flush_chunk, res);
+        encode_state(&enc);
+        if (int err = enc.finish(); err != 0) {
+          SMC_LOGE(TAG, "encoding state failed with %d", err);
+          return err;
+        }
+
+        return res->finishChunking();
+      });
+
+  // Parses the body as it arrives and adds its alarms only if all of them are
+  // valid, with a single refresh and a single write to the filesystem. With
+  // replace=1, all existing alarms are cleared first.
+  PsychicUploadHandler* batch_upload = new PsychicUploadHandler();
+  batch_upload->onUpload([](PsychicRequest*, const String&, uint64_t index,
+                            uint8_t* data, size_t len, bool last) {
+    if (index == 0) {
+      if (batch == NULL) {
+        batch = (AlarmBatch*)malloc(sizeof(AlarmBatch));
+        if (batch == NULL) {
+          return ESP_ERR_NO_MEM;
+        }
+      }
+      memset(batch, 0, offsetof(AlarmBatch, line));
+    }
+    if (batch == NULL) {
+      return ESP_FAIL;
+    }
+
+    batch_feed(data, len);
+    if (last) {
+      if (batch->len > 0 && batch->err == 0) {
+        batch_line_end();
+      }
+      batch->done = true;
+    }
+    return ESP_OK;
+  });
+
+  server->on(
+      "/alarms/batch", HTTP_POST, batch_upload,
+      [](PsychicRequest* req, PsychicResponse* res) {
+        // An empty body never got to onUpload
+        if (batch == NULL || !batch->done) {
+          return res->send(400);
+        }
+
+        Alarms* alarms = smc_system_alarms();
+        bool replace = req->hasParam("replace") &&
+                       req->getParam("replace")->value() == "1";
+        char reply[40];
+        int status = 200;
+        {
+          // free_slots() must still hold when the batch is added. The reply
+          // is sent once the store is let go of.
+          std::lock_guard<std::recursive_mutex> lock(Alarms::mutex);
+          int room = replace ? MAX_ALARMS : alarms->free_slots();
+          if (batch->err == BATCH_TOO_MANY) {
+            snprintf(reply, sizeof(reply), "more than %d alarms", MAX_ALARMS);
+            status = 409;
+          } else if (batch->err == 0 && batch->count > room) {
+            snprintf(reply, sizeof(reply), "%d alarms, %d free", batch->count,
+                     room);
+            status = 409;
+          } else if (batch->err != 0) {
+            snprintf(reply, sizeof(reply), "line %d: error %d",
+                     batch->bad_line, batch->err);
+            status = 400;
+          } else {
+            if (replace) {
+              for (int i = 0; i < MAX_ALARMS; i++) {
+                alarms->set(i, NULL);
+              }
+            }
+            for (int i = 0; i < batch->count; i++) {
+              int idx = alarms->add(&batch->alarms[i]);
+              assert(idx >= 0);
+            }
+
+            struct tm now;
+            Clock::get(&now);
+            alarms->refresh(&now);
+            assert(alarms->save_into_fs() == 0);
+
+            snprintf(reply, sizeof(reply), "%d", batch->count);
+          }
+        }
+        if (status == 200) {
+          SMC_LOGI(TAG, "batch added %d alarms (replace %d)", batch->count,
+                   replace);
+        }
+
+        free(batch);
+        batch = NULL;
+        return res->send(status, "text/plain", reply);
+      });
+
+  // Streams every valid alarm in the bulk format, one chunk per alarm.
+  server->on(
+      "/alarms/export", HTTP_GET,
+      [](PsychicRequest* req, PsychicResponse* res) {
+        Alarms* alarms = smc_system_alarms();
+
+        res->setContentType("text/csv");
+
+        static const char* header =
+            "# name,description,compartment,category,flags,days,icon,color,"
+            "second\n";
+        if (int err =
+                metrics_send_chunk(res, (uint8_t*)header, strlen(header));
+            err != 0) {
+          SMC_LOGE(TAG, "sendChunk returned %d", err);
+          return err;
+        }
+
+        for (int i = 0; i < MAX_ALARMS; i++) {
+          Alarm alarm;
+          if (alarms->get(i, &alarm) < 0) {
+            continue;
+          }
+
+          char line[ALARM_CSV_LINE_SIZE];
+          size_t len = csv_quote(line, sizeof(line), alarm.name);
+          line[len++] = ',';
+          len += csv_quote(line + len, sizeof(line) - len, alarm.description);
+          len += snprintf(line + len, sizeof(line) - len,
+                          ",%d,%d,%d,%d,%d,%d,%d\n", alarm.compartment,
+                          (uint8_t)alarm.category, (uint8_t)alarm.flags,
+                          (uint8_t)alarm.days, (uint8_t)alarm.icon,
+                          (uint16_t)alarm.color, alarm.secondMark);
+          if (int err = metrics_send_chunk(res, (uint8_t*)line, len);
+              err != 0) {
+            SMC_LOGE(TAG, "sendChunk returned %d", err);
+            return err;
+          }
+        }
+
+        return res->finishChunking();
+      });
+}
@@ -1,11 +1,11 @@
 #ifndef SMC_ENDPOINTS_H
 #define SMC_ENDPOINTS_H
 
-#include "PsychicHttpServer.h"
+#include "http_metrics.h"
 
-void register_endpoints_static(PsychicHttpServer* server);
-void register_endpoints_admin(PsychicHttpServer* server);
-void register_endpoints_htmx(PsychicHttpServer* server);
-void regitser_endpoints_data(PsychicHttpServer* server);
+void register_endpoints_static(MetricsHttpServer* server);
+void register_endpoints_admin(MetricsHttpServer* server);
+void register_endpoints_htmx(MetricsHttpServer* server);
+void register_endpoints_data(MetricsHttpServer* server);
 
 #endif
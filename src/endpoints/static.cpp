@@ -1,20 +1,21 @@
 #include "LittleFS.h"
 #include "PsychicHttpServer.h"
+#include "http_metrics.h"
 #include "embed.h"
 #include "utils.h"
 
 static const char* TAG = "endpoint_static";
 
-int register_endpoints_static(PsychicHttpServer* server) {
+int register_endpoints_static(MetricsHttpServer* server) {
   server->on("/", HTTP_GET, [=](PsychicRequest* req, PsychicResponse* res) {
     if (LittleFS.exists("/index.html")) {
-      ESP_LOGD(TAG, "exists");
+      SMC_LOGD(TAG, "exists");
       fs_mutex.lock();
       File file = LittleFS.open("/index.html", FILE_READ);
       if (!file) {
         file.close();
         fs_mutex.unlock();
-        ESP_LOGE(TAG, "what?");
+        SMC_LOGE(TAG, "what?");
         return res->send(200, "text/html", EMBED_INDEX_HTML_DATA);
       }
       char buf[256];
@@ -25,7 +26,7 @@ int register_endpoints_static(PsychicHttpServer* server) {
         if (bytes == 0) {
           break;
         }
-        assert(res->sendChunk((uint8_t*)buf, bytes) == 0);
+        assert(metrics_send_chunk(res, (uint8_t*)buf, bytes) == 0);
         memset(buf, 0, sizeof(buf));
       }
       file.close();
@@ -33,7 +34,7 @@ int register_endpoints_static(PsychicHttpServer* server) {
 
       return res->finishChunking();
     } else {
-      ESP_LOGD(TAG, "not exist");
+      SMC_LOGD(TAG, "not exist");
       return res->send(200, "text/html", EMBED_INDEX_HTML_DATA);
     }
     return 0;
@@ -0,0 +1,180 @@
+#include "http_metrics.h"
+#include <cstdarg>
+#include <cstring>
+#include "utils.h"
+
+static const char* TAG = "http_metrics";
+
+static RouteMetrics routes[HTTP_METRICS_MAX_ROUTES];
+static int routes_len = 0;
+
+// The route whose handler is running. PsychicHttp handles requests one at a
+// time on the httpd task, so a single pointer is enough.
+static RouteMetrics* current_route = NULL;
+
+static RouteMetrics* add_route(const char* uri, int method) {
+  if (routes_len == HTTP_METRICS_MAX_ROUTES) {
+    SMC_LOGW(TAG, "no room to record %s, registering it as is", uri);
+    return NULL;
+  }
+
+  RouteMetrics* route = &routes[routes_len++];
+  memset(route, 0, sizeof(RouteMetrics));
+  route->uri = uri;
+  route->method = method;
+  return route;
+}
+
+// fn, recording every call against route.
+static PsychicHttpRequestCallback recorded(RouteMetrics* route,
+                                           PsychicHttpRequestCallback fn) {
+  return [route, fn](PsychicRequest* req, PsychicResponse* res) {
+    unsigned long start = micros();
+    route->in_flight++;
+    current_route = route;
+
+    esp_err_t err = fn(req, res);
+
+    current_route = NULL;
+    route->in_flight--;
+    route->requests++;
+    route->bytes_out += res->getContentLength();
+
+    uint32_t elapsed = micros() - start;
+    route->latency_sum_us += elapsed;
+    int bucket = 0;
+    while (bucket < HTTP_METRICS_BUCKETS - 1 &&
+           elapsed > HTTP_METRICS_BUCKETS_US[bucket]) {
+      bucket++;
+    }
+    route->latency_buckets[bucket]++;
+
+    return err;
+  };
+}
+
+PsychicEndpoint* MetricsHttpServer::on(const char* uri, int method,
+                                       PsychicHttpRequestCallback fn) {
+  RouteMetrics* route = add_route(uri, method);
+  return PsychicHttpServer::on(uri, method,
+                               route != NULL ? recorded(route, fn) : fn);
+}
+
+PsychicEndpoint* MetricsHttpServer::on(const char* uri, int method,
+                                       PsychicUploadHandler* upload,
+                                       PsychicHttpRequestCallback fn) {
+  RouteMetrics* route = add_route(uri, method);
+  upload->onRequest(route != NULL ? recorded(route, fn) : fn);
+  return PsychicHttpServer::on(uri, method, upload);
+}
+
+esp_err_t metrics_send_chunk(PsychicResponse* res, const uint8_t* data,
+                             size_t len) {
+  if (current_route != NULL) {
+    current_route->bytes_out += len;
+  }
+  return res->sendChunk((uint8_t*)data, len);
+}
+
+void MetricsWriter::append(const char* fmt, ...) {
+  char line[160];
+  va_list args;
+  va_start(args, fmt);
+  int line_len = vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+
+  if (line_len < 0 || err != 0) {
+    return;
+  }
+  if ((size_t)line_len >= sizeof(line)) {
+    line_len = sizeof(line) - 1;
+  }
+
+  if (len + line_len > sizeof(buf)) {
+    flush();
+  }
+  memcpy(buf + len, line, line_len);
+  len += line_len;
+}
+
+void MetricsWriter::flush(void) {
+  if (len > 0 && err == 0) {
+    err = metrics_send_chunk(res, (const uint8_t*)buf, len);
+  }
+  len = 0;
+}
+
+static void write_metrics(MetricsWriter* w) {
+  w->append("# HELP smc_http_requests_total Handled HTTP requests.\n");
+  w->append("# TYPE smc_http_requests_total counter\n");
+  for (int i = 0; i < routes_len; i++) {
+    w->append("smc_http_requests_total{route=\"%s\",method=\"%s\"} %u\n",
+              routes[i].uri, http_method_str((http_method)routes[i].method),
+              routes[i].requests);
+  }
+
+  w->append("# HELP smc_http_in_flight Requests currently being handled.\n");
+  w->append("# TYPE smc_http_in_flight gauge\n");
+  for (int i = 0; i < routes_len; i++) {
+    w->append("smc_http_in_flight{route=\"%s\",method=\"%s\"} %d\n",
+              routes[i].uri, http_method_str((http_method)routes[i].method),
+              routes[i].in_flight);
+  }
+
+  w->append("# HELP smc_http_response_bytes_total Response body bytes.\n");
+  w->append("# TYPE smc_http_response_bytes_total counter\n");
+  for (int i = 0; i < routes_len; i++) {
+    w->append(
+        "smc_http_response_bytes_total{route=\"%s\",method=\"%s\"} %llu\n",
+        routes[i].uri, http_method_str((http_method)routes[i].method),
+        (unsigned long long)routes[i].bytes_out);
+  }
+
+  w->append("# HELP smc_http_request_duration_seconds Handler latency.\n");
+  w->append("# TYPE smc_http_request_duration_seconds histogram\n");
+  for (int i = 0; i < routes_len; i++) {
+    const RouteMetrics* r = &routes[i];
+    const char* method = http_method_str((http_method)r->method);
+
+    uint32_t cumulative = 0;
+    for (int b = 0; b < HTTP_METRICS_BUCKETS; b++) {
+      cumulative += r->latency_buckets[b];
+      if (b < HTTP_METRICS_BUCKETS - 1) {
+        w->append(
+            "smc_http_request_duration_seconds_bucket{route=\"%s\","
+            "method=\"%s\",le=\"%g\"} %u\n",
+            r->uri, method, HTTP_METRICS_BUCKETS_US[b] / 1e6, cumulative);
+      } else {
+        w->append(
+            "smc_http_request_duration_seconds_bucket{route=\"%s\","
+            "method=\"%s\",le=\"+Inf\"} %u\n",
+            r->uri, method, cumulative);
+      }
+    }
+    w->append(
+        "smc_http_request_duration_seconds_sum{route=\"%s\",method=\"%s\"} "
+        "%.6f\n",
+        r->uri, method, r->latency_sum_us / 1e6);
+    w->append(
+        "smc_http_request_duration_seconds_count{route=\"%s\",method=\"%s\"} "
+        "%u\n",
+        r->uri, method, r->requests);
+  }
+}
+
+void register_endpoints_metrics(MetricsHttpServer* server) {
+  server->on("/metrics", HTTP_GET,
+             [](PsychicRequest* req, PsychicResponse* res) {
+               res->setContentType("text/plain; version=0.0.4");
+
+               MetricsWriter w = {.res = res, .len = 0, .err = 0};
+               write_metrics(&w);
+               w.flush();
+               if (w.err != 0) {
+                 SMC_LOGE(TAG, "sendChunk returned %d", w.err);
+                 return w.err;
+               }
+
+               return res->finishChunking();
+             });
+}
@@ -0,0 +1,62 @@
+#ifndef SMC_HTTP_METRICS_H
+#define SMC_HTTP_METRICS_H
+
+#include "PsychicHttpServer.h"
+#include "PsychicUploadHandler.h"
+
+static const int HTTP_METRICS_MAX_ROUTES = 48;
+
+// Upper bounds of the latency histogram buckets in microseconds, an implicit
+// +Inf bucket follows.
+static const uint32_t HTTP_METRICS_BUCKETS_US[] = {
+    1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000,
+};
+static const int HTTP_METRICS_BUCKETS =
+    sizeof(HTTP_METRICS_BUCKETS_US) / sizeof(HTTP_METRICS_BUCKETS_US[0]) + 1;
+
+struct RouteMetrics {
+  const char* uri;
+  int method;
+  uint32_t requests;
+  int32_t in_flight;
+  uint64_t bytes_out;
+  uint64_t latency_sum_us;
+  uint32_t latency_buckets[HTTP_METRICS_BUCKETS];
+};
+
+// A PsychicHttpServer which records the request count, in-flight requests,
+// response bytes and latency of every route registered through on(). uri must
+// outlive the server, string literals are fine.
+class MetricsHttpServer : public PsychicHttpServer {
+ public:
+  using PsychicHttpServer::on;
+  PsychicEndpoint* on(const char* uri, int method,
+                      PsychicHttpRequestCallback fn);
+  // Registers upload, which hands fn's route the body in chunks as it
+  // arrives instead of buffering it, then calls fn. Only fn is timed.
+  PsychicEndpoint* on(const char* uri, int method,
+                      PsychicUploadHandler* upload,
+                      PsychicHttpRequestCallback fn);
+};
+
+// PsychicResponse::sendChunk(), also counting the bytes against the route
+// currently being handled. Use this for chunked responses, as only the body of
+// non-chunked ones can be seen by MetricsHttpServer.
+esp_err_t metrics_send_chunk(PsychicResponse* res, const uint8_t* data,
+                             size_t len);
+
+// Buffers text and sends it in chunks with metrics_send_chunk().
+struct MetricsWriter {
+  PsychicResponse* res;
+  char buf[512];
+  size_t len;
+  esp_err_t err;
+
+  void append(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  void flush(void);
+};
+
+// Registers /metrics, which exports everything in the Prometheus text format.
+void register_endpoints_metrics(MetricsHttpServer* server);
+
+#endif
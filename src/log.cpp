@@ -0,0 +1,196 @@
+#include "log.h"
+#include <Arduino.h>
+#ifndef SMC_DESKTOP
+#include <freertos/ringbuf.h>
+
+static RingbufHandle_t ring = NULL;
+static uint32_t dropped = 0;
+#endif
+
+static const char LEVEL_CHARS[] = "NEWIDV";
+
+void smc_log_write(SmcLogRecord* record) {
+  record->header.ms = millis();
+
+#ifndef SMC_DESKTOP
+  if (ring != NULL) {
+    size_t len = sizeof(SmcLogHeader) + record->header.args_len;
+    if (xRingbufferSend(ring, record, len, 0) != pdTRUE) {
+      __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+    }
+    return;
+  }
+#endif
+
+  char line[256];
+  smc_log_format(record, line, sizeof(line));
+  fputs(line, stdout);
+}
+
+// Appends one conversion, spec being e.g. "%-4lu", with the argument at arg.
+// Returns how many bytes of arguments it used.
+static size_t format_arg(char* dest, size_t size, const char* spec,
+                         const uint8_t* arg, const uint8_t* end) {
+  char conv = spec[strlen(spec) - 1];
+  if (arg >= end) {
+    snprintf(dest, size, "?");
+    return 0;
+  }
+
+  uint8_t type = arg[0];
+  const uint8_t* val = arg + 1;
+  long long num = 0;
+  double real = 0;
+  size_t used = 1;
+
+  switch (type) {
+    case SMC_LOG_ARG_INT:
+    case SMC_LOG_ARG_PTR: {
+      int32_t narrow;
+      memcpy(&narrow, val, 4);
+      num = type == SMC_LOG_ARG_PTR ? (long long)(uint32_t)narrow : narrow;
+      real = num;
+      used += 4;
+      break;
+    }
+    case SMC_LOG_ARG_LONG_LONG:
+      memcpy(&num, val, 8);
+      real = num;
+      used += 8;
+      break;
+    case SMC_LOG_ARG_DOUBLE:
+      memcpy(&real, val, 8);
+      num = real;
+      used += 8;
+      break;
+    case SMC_LOG_ARG_STR: {
+      char str[SMC_LOG_STR_MAX + 1];
+      memcpy(str, val + 1, val[0]);
+      str[val[0]] = 0x00;
+      if (conv == 's') {
+        snprintf(dest, size, spec, str);
+      } else {
+        snprintf(dest, size, "?");
+      }
+      return used + 1 + val[0];
+    }
+    default:
+      snprintf(dest, size, "?");
+      return end - arg;
+  }
+
+  if (strchr("fFeEgGaA", conv)) {
+    snprintf(dest, size, spec, real);
+  } else if (conv == 'p') {
+    snprintf(dest, size, spec, (void*)(uintptr_t)num);
+  } else if (conv == 's') {
+    snprintf(dest, size, "?");
+  } else if (strstr(spec, "ll") || strchr(spec, 'j')) {
+    snprintf(dest, size, spec, num);
+  } else if (strchr(spec, 'l')) {
+    snprintf(dest, size, spec, (long)num);
+  } else {
+    snprintf(dest, size, spec, (int)num);
+  }
+
+  return used;
+}
+
+size_t smc_log_format(const SmcLogRecord* record, char* dest, size_t size) {
+  const SmcLogHeader* header = &record->header;
+  size_t len = snprintf(dest, size, "%c (%lu) %s: ",
+                        LEVEL_CHARS[header->level % 6],
+                        (unsigned long)header->ms, header->tag);
+
+  const uint8_t* arg = record->args;
+  const uint8_t* end = record->args + header->args_len;
+  const char* fmt = header->fmt;
+
+  while (*fmt != 0x00 && len + 2 < size) {
+    if (*fmt != '%') {
+      dest[len++] = *fmt++;
+      continue;
+    }
+    if (fmt[1] == '%') {
+      dest[len++] = '%';
+      fmt += 2;
+      continue;
+    }
+
+    // Flags, width, precision and length, then the conversion. * is not
+    // supported.
+    size_t spec_len = 1 + strspn(fmt + 1, "-+ #0123456789.hljztL");
+    if (fmt[spec_len] == 0x00) {
+      break;
+    }
+    spec_len++;
+
+    char spec[16];
+    if (spec_len >= sizeof(spec)) {
+      break;
+    }
+    memcpy(spec, fmt, spec_len);
+    spec[spec_len] = 0x00;
+    fmt += spec_len;
+
+    arg += format_arg(dest + len, size - len - 1, spec, arg, end);
+    len += strlen(dest + len);
+  }
+
+  dest[len++] = '\n';
+  dest[len] = 0x00;
+  return len;
+}
+
+#ifndef SMC_DESKTOP
+static void log_task(void* arg) {
+  static char line[256];
+
+  for (;;) {
+    size_t len;
+    SmcLogRecord* record =
+        (SmcLogRecord*)xRingbufferReceive(ring, &len, portMAX_DELAY);
+    if (record == NULL) {
+      continue;
+    }
+
+#ifdef SMC_LOG_BINARY
+    uint8_t frame_len = len;
+    fwrite(SMC_LOG_FRAME_MAGIC, 1, sizeof(SMC_LOG_FRAME_MAGIC), stdout);
+    fwrite(&frame_len, 1, 1, stdout);
+    fwrite(record, 1, len, stdout);
+#else
+    smc_log_format(record, line, sizeof(line));
+    fputs(line, stdout);
+#endif
+    vRingbufferReturnItem(ring, record);
+
+    uint32_t lost = __atomic_exchange_n(&dropped, 0, __ATOMIC_RELAXED);
+    if (lost > 0) {
+      fprintf(stdout, "W (%lu) log: %lu records dropped\n", millis(),
+              (unsigned long)lost);
+    }
+  }
+}
+#endif
+
+// On the desktop records are always formatted right away.
+int smc_log_setup(void) {
+#ifndef SMC_DESKTOP
+  RingbufHandle_t created =
+      xRingbufferCreate(SMC_LOG_RING_SIZE, RINGBUF_TYPE_NOSPLIT);
+  if (created == NULL) {
+    return -1;
+  }
+  ring = created;
+
+  if (xTaskCreate(log_task, "log", 3072, NULL, tskIDLE_PRIORITY + 1, NULL) !=
+      pdPASS) {
+    ring = NULL;
+    vRingbufferDelete(created);
+    return -1;
+  }
+#endif
+
+  return 0;
+}
@@ -0,0 +1,178 @@
+#ifndef SMC_LOG_H
+#define SMC_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+#define SMC_LOG_NONE 0
+#define SMC_LOG_ERROR 1
+#define SMC_LOG_WARN 2
+#define SMC_LOG_INFO 3
+#define SMC_LOG_DEBUG 4
+#define SMC_LOG_VERBOSE 5
+
+// Anything above this level is compiled out, arguments included. Set it in
+// platformio.ini.
+#ifndef SMC_LOG_LEVEL
+#define SMC_LOG_LEVEL SMC_LOG_INFO
+#endif
+
+static const size_t SMC_LOG_RING_SIZE = 8 * 1024;
+static const size_t SMC_LOG_RECORD_SIZE = 192;
+// Longer %s arguments are cut.
+static const size_t SMC_LOG_STR_MAX = 64;
+static const uint8_t SMC_LOG_FRAME_MAGIC[2] = {0xA5, 0x5A};
+
+enum SmcLogArgType : uint8_t {
+  SMC_LOG_ARG_INT = 'i',        // 4 bytes
+  SMC_LOG_ARG_LONG_LONG = 'l',  // 8 bytes
+  SMC_LOG_ARG_DOUBLE = 'd',     // 8 bytes
+  SMC_LOG_ARG_PTR = 'p',        // 4 bytes
+  SMC_LOG_ARG_STR = 's',        // 1 byte length, then the bytes
+};
+
+struct SmcLogHeader {
+  uint32_t ms;
+  const char* tag;
+  // Points into flash, so it stands in for the message until formatted.
+  const char* fmt;
+  uint8_t level;
+  uint8_t args_len;
+};
+
+// One log call, the format string and its arguments as they were passed,
+// each prefixed with its SmcLogArgType.
+struct SmcLogRecord {
+  SmcLogHeader header;
+  uint8_t args[SMC_LOG_RECORD_SIZE - sizeof(SmcLogHeader)];
+
+  void put(uint8_t type, const void* src, size_t len) {
+    if (header.args_len + 1 + len > sizeof(args)) {
+      return;  // Formatted as "?"
+    }
+    args[header.args_len++] = type;
+    memcpy(args + header.args_len, src, len);
+    header.args_len += len;
+  }
+};
+
+inline void smc_log_add(SmcLogRecord* record, const char* str) {
+  if (str == NULL) {
+    str = "(null)";
+  }
+  uint8_t buf[1 + SMC_LOG_STR_MAX];
+  buf[0] = strnlen(str, SMC_LOG_STR_MAX);
+  memcpy(buf + 1, str, buf[0]);
+  record->put(SMC_LOG_ARG_STR, buf, 1 + buf[0]);
+}
+
+inline void smc_log_add(SmcLogRecord* record, double val) {
+  record->put(SMC_LOG_ARG_DOUBLE, &val, sizeof(val));
+}
+
+inline void smc_log_add(SmcLogRecord* record, const void* ptr) {
+  uint32_t val = (uintptr_t)ptr;
+  record->put(SMC_LOG_ARG_PTR, &val, sizeof(val));
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value ||
+                               std::is_enum<T>::value>::type
+smc_log_add(SmcLogRecord* record, T val) {
+  if (sizeof(T) > 4) {
+    long long wide = (long long)val;
+    record->put(SMC_LOG_ARG_LONG_LONG, &wide, sizeof(wide));
+  } else {
+    int32_t narrow = (int32_t)val;
+    record->put(SMC_LOG_ARG_INT, &narrow, sizeof(narrow));
+  }
+}
+
+// The end of the arguments.
+inline void smc_log_add_all(SmcLogRecord*) {}
+
+template <typename T, typename... Rest>
+inline void smc_log_add_all(SmcLogRecord* record, T first, Rest... rest) {
+  smc_log_add(record, first);
+  smc_log_add_all(record, rest...);
+}
+
+// Queues the record for the log task, or formats it right away before
+// smc_log_setup().
+void smc_log_write(SmcLogRecord* record);
+
+// Copying the arguments is all a log call costs, formatting happens later on
+// the log task.
+template <typename... Args>
+inline void smc_log(uint8_t level, const char* tag, const char* fmt,
+                    Args... args) {
+  SmcLogRecord record;
+  record.header = {0, tag, fmt, level, 0};
+  smc_log_add_all(&record, args...);
+  smc_log_write(&record);
+}
+
+// Starts the low priority task printing the records on serial, as text or as
+// binary frames for tools/log_decode.py with SMC_LOG_BINARY. Returns -1 if it
+// could not be started.
+int smc_log_setup(void);
+
+// Formats record as "I (1234) tag: message\n" into dest. Returns the length.
+size_t smc_log_format(const SmcLogRecord* record, char* dest, size_t size);
+
+// The printf() is never run, it is there for the compiler's format checks.
+#define SMC_LOG_AT(level, tag, fmt, ...)  \
+  do {                                    \
+    if (0) {                              \
+      printf(fmt, ##__VA_ARGS__);         \
+    }                                     \
+    smc_log(level, tag, fmt, ##__VA_ARGS__); \
+  } while (0)
+
+#if SMC_LOG_LEVEL >= SMC_LOG_ERROR
+#define SMC_LOGE(tag, fmt, ...) \
+  SMC_LOG_AT(SMC_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#else
+#define SMC_LOGE(tag, fmt, ...) \
+  do {                          \
+  } while (0)
+#endif
+
+#if SMC_LOG_LEVEL >= SMC_LOG_WARN
+#define SMC_LOGW(tag, fmt, ...) SMC_LOG_AT(SMC_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#else
+#define SMC_LOGW(tag, fmt, ...) \
+  do {                          \
+  } while (0)
+#endif
+
+#if SMC_LOG_LEVEL >= SMC_LOG_INFO
+#define SMC_LOGI(tag, fmt, ...) SMC_LOG_AT(SMC_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#else
+#define SMC_LOGI(tag, fmt, ...) \
+  do {                          \
+  } while (0)
+#endif
+
+#if SMC_LOG_LEVEL >= SMC_LOG_DEBUG
+#define SMC_LOGD(tag, fmt, ...) \
+  SMC_LOG_AT(SMC_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+#else
+#define SMC_LOGD(tag, fmt, ...) \
+  do {                          \
+  } while (0)
+#endif
+
+#if SMC_LOG_LEVEL >= SMC_LOG_VERBOSE
+#define SMC_LOGV(tag, fmt, ...) \
+  SMC_LOG_AT(SMC_LOG_VERBOSE, tag, fmt, ##__VA_ARGS__)
+#else
+#define SMC_LOGV(tag, fmt, ...) \
+  do {                          \
+  } while (0)
+#endif
+
+#endif
@@ -1,5 +1,6 @@
 #include <./ui.h>
 #include <Arduino.h>
+#include "./log.h"
 
 static const char* TAG = "main";
 
@@ -7,7 +8,7 @@ void setup() {
   Serial.begin(115200);
   while (!Serial) {}
   Serial.setDebugOutput(true);
-  esp_log_level_set("*", ESP_LOG_DEBUG);
+  assert(smc_log_setup() == 0);
 
   smc_init_drivers();
 }
@@ -32,7 +33,7 @@ void loop() {
   //   int idx;
   //   time_t when_ring = alarms.ring_in(&idx);
   //   if (when_ring > 0) {
-  //     ESP_LOGD(TAG, "idx %d ringing in %lds", idx, when_ring - time(NULL));
+  //     SMC_LOGD(TAG, "idx %d ringing in %lds", idx, when_ring - time(NULL));
   //   }
   // }
 
@@ -40,7 +41,7 @@ void loop() {
   // if (digitalRead(SEC_BUTTON_PIN) == HIGH) {
   //   if (bounce(&current_ringing_tk, 200, true)) {
   //     if (alarms.is_ringing() == -1) {
-  //       ESP_LOGI(TAG, "no currently ringing alarm");
+  //       SMC_LOGI(TAG, "no currently ringing alarm");
   //     } else {
   //       alarms.attend(time(NULL), 0x00, &motor);
   //     }
@@ -54,7 +55,7 @@ void loop() {
   //     static int counter;
   //     sprintf(message, "Hello world! (%d)", counter++);
   //
-  //     ESP_LOGD(TAG, "sending test notification");
+  //     SMC_LOGD(TAG, "sending test notification");
   //
   //     if (webserver.test_notify(message) == 200) {
   //       digitalWrite(LED_PIN, HIGH);
@@ -1,4 +1,5 @@
 #include "./alarm.h"
+#include <cassert>
 #include <cstddef>
 #include <cstdio>
 #include <cstring>
@@ -6,18 +7,58 @@
 #include "../ui.h"
 #include "config.h"
 #include "time.h"
+#include "utils.h"
 
 static const char* TAG = "alarm";
 
+#define ALARMS_MAX_SUBSCRIBERS 4
+
+unsigned int Alarms::generation = 0;
+unsigned int Alarms::versions[MAX_ALARMS];
+std::recursive_mutex Alarms::mutex;
+
+static struct {
+  Alarms::ChangedCb cb;
+  void* user_data;
+} subscribers[ALARMS_MAX_SUBSCRIBERS];
+static int subscriber_count = 0;
+
+int Alarms::subscribe(ChangedCb cb, void* user_data) {
+  if (subscriber_count >= ALARMS_MAX_SUBSCRIBERS) {
+    return -1;
+  }
+  subscribers[subscriber_count].cb = cb;
+  subscribers[subscriber_count].user_data = user_data;
+  subscriber_count++;
+  return 0;
+}
+
+void Alarms::changed(int idx) {
+  generation++;
+  if (idx == -1) {
+    for (int i = 0; i < MAX_ALARMS; i++) {
+      versions[i]++;
+    }
+  } else {
+    versions[idx]++;
+  }
+
+  for (int i = 0; i < subscriber_count; i++) {
+    subscribers[i].cb(idx, subscribers[i].user_data);
+  }
+}
+
 int Alarms::load_from_fs(void) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   int code = smc_fs_read(ALARMS_PATH, this, sizeof(Alarms));
+  changed(-1);
 
   // fs_mutex.lock();
   // File file = LittleFS.open(ALARMS_PATH, FILE_READ);
   // if (!file) {
   //   file.close();
   //   fs_mutex.unlock();
-  //   ESP_LOGW(TAG, "no saved data at %s, ignoring", ALARMS_PATH);
+  //   SMC_LOGW(TAG, "no saved data at %s, ignoring", ALARMS_PATH);
   //   return -1;
   // }
   // assert(!file.isDirectory());
@@ -48,6 +89,7 @@ int Alarms::load_from_fs(void) {
 }
 
 int Alarms::save_into_fs(void) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   return smc_fs_write(ALARMS_PATH, this, sizeof(Alarms));
   // fs_mutex.lock();
   // File file = LittleFS.open(ALARMS_PATH, FILE_WRITE);
@@ -68,18 +110,20 @@ int Alarms::save_into_fs(void) {
   // return 0;
 }
 
-void Alarms::loop(void) {
+void Alarms::loop(time_t now) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   if (earliest_idx == -1) {
     return;
   }
 
-  if (time(NULL) > when_ring) {
-    // SMC_LOGD(TAG, "%ld, %ld", time(NULL), when_ring);
+  if (now > when_ring) {
+    // SMC_LOGD(TAG, "%ld, %ld", now, when_ring);
     ring(earliest_idx);
   }
 }
 
 int Alarms::ring(int idx) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   if (ringing_idx != -1) {
     // There is another alarm ringing.
     return -1;
@@ -91,6 +135,7 @@ int Alarms::ring(int idx) {
 }
 
 int Alarms::attend(time_t when, char flags) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   if (ringing_flags & 1) {
     ringing_flags = !ringing_flags;
     ringing_flags |= 3;
@@ -115,6 +160,7 @@ int Alarms::attend(time_t when, char flags) {
 }
 
 int Alarms::attend_idx(int idx, time_t when, char flags) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   if (idx < 0 || idx >= MAX_ALARMS) {
     return -1;
   }
@@ -129,6 +175,7 @@ int Alarms::attend_idx(int idx, time_t when, char flags) {
   int err = append_log(idx, &log);
   // SMC_LOGD(TAG, "append_log err is %d", err);
   assert(err >= 0);
+  changed(idx);
 
   earliest_idx = -1;
   ringing_idx = -1;
@@ -145,6 +192,7 @@ int Alarms::is_ringing(void) {
 }
 
 int Alarms::refresh(const struct tm* now) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   if (ringing_flags & 2) {
     return 1;
   }
@@ -163,6 +211,7 @@ int Alarms::refresh(const struct tm* now) {
 }
 
 time_t Alarms::ring_in(int* idx_ptr) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   if (when_ring == 0) {
     if (idx_ptr != NULL) {
       *idx_ptr = -1;
@@ -183,6 +232,7 @@ time_t Alarms::ring_in(int* idx_ptr) {
 }
 
 int Alarms::one_off_ring(time_t when) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   if (ringing_idx != -1) {
     return -1;
   }
@@ -193,9 +243,10 @@ int Alarms::one_off_ring(time_t when) {
 }
 
 int Alarms::add(const struct Alarm* alarm) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   // FIXME?
   int err = set(-1, alarm);
-  // ESP_LOGW(TAG, "err add is %d", err);
+  // SMC_LOGW(TAG, "err add is %d", err);
   if (err == -3) {
     return -2;
   }
@@ -209,7 +260,19 @@ int Alarms::add(const struct Alarm* alarm) {
   return -1;
 };
 
+int Alarms::free_slots(void) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
+  int count = 0;
+  for (int i = 0; i < MAX_ALARMS; i++) {
+    if (get(i, NULL) == -2) {
+      count++;
+    }
+  }
+  return count;
+}
+
 int Alarms::set(int idx, const struct Alarm* alarm) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   // FIXME not returning -3 if the alarm invalid
   //
   if (idx < -1 || idx >= MAX_ALARMS) {
@@ -222,6 +285,7 @@ int Alarms::set(int idx, const struct Alarm* alarm) {
 
   if (alarm == NULL) {
     memset(&list[idx], 0, sizeof(list[0]));
+    changed(idx);
     return 0;
   }
 
@@ -234,10 +298,12 @@ int Alarms::set(int idx, const struct Alarm* alarm) {
   }
 
   memcpy(&list[idx], alarm, sizeof(Alarm));
+  changed(idx);
   return 0;
 }
 
 int Alarms::get(int idx, struct Alarm* alarm) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   if (idx < 0 || idx >= MAX_ALARMS) {
     return -1;
   }
@@ -255,6 +321,7 @@ int Alarms::get(int idx, struct Alarm* alarm) {
 }
 
 int Alarms::append_log(int idx, const struct AlarmLog* log) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   if (idx < 0 || idx >= MAX_ALARMS) {
     return -1;
   }
@@ -319,6 +386,7 @@ int Alarms::next_schedule(const struct Alarm* alarm, char today,
 
 time_t Alarms::earliest_alarm(const struct tm* now, struct Alarm* alarm,
                               int* idx_ptr) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   if (now == NULL) {
     return -2;
   }
@@ -363,12 +431,7 @@ time_t Alarms::earliest_alarm(const struct tm* now, struct Alarm* alarm,
       *idx_ptr = earliest_idx;
     }
 
-    struct tm now_copy;
-    memcpy(&now_copy, now, sizeof(tm));
-
-    time_t epoch = mktime(&now_copy);
-
-    return epoch + earliest_second;
+    return tm_to_utc(now) + earliest_second;
   }
 }
 
@@ -2,6 +2,7 @@
 #define ALARM_H
 
 #include <ctime>
+#include <mutex>
 #include "./config.h"
 
 static const char ALARM_VERSION = 0x00;
@@ -44,8 +45,9 @@ class Alarms {
   int load_from_fs(void);
   int save_into_fs(void);
 
-  // Call in the loop to monitor ringing alarms.
-  void loop(void);
+  // Call once a second, see Clock::tick(), to monitor ringing alarms. now is
+  // in seconds since the UNIX epoch, GMT+0.
+  void loop(time_t now);
 
   // Reevaluates the earliest alarm to be monitored. Returns -1 on error.
   // Returns 1 if refreshing is disabled.
@@ -89,6 +91,10 @@ class Alarms {
   // index where there is an empty or invalid alarm.
   int add(const struct Alarm* alarm);
 
+  // Returns how many slots in the storage are empty or invalid, i.e. how many
+  // alarms Alarms::add() could still take.
+  int free_slots(void);
+
   // Adds the log into the alarm in the storage with specified index. If there
   // is no room for new logs, clears the oldest log and place the new log there
   // instead. Returns -1 if the index is out of bounds. Returns 0 if the log was
@@ -117,6 +123,28 @@ class Alarms {
   static time_t epoch(const struct Alarm* alarm, const struct tm* now,
                       int secs);
 
+  // Called after list[idx] changed, or with -1 if any of them might have, e.g.
+  // after loading. It runs on whatever task made the change, which need not
+  // be the one the subscriber draws on.
+  typedef void (*ChangedCb)(int idx, void* user_data);
+
+  // Calls cb on every change from now on, see ChangedCb. Returns -1 if there
+  // are too many subscribers already.
+  static int subscribe(ChangedCb cb, void* user_data);
+
+  // Bumped whenever the contents of list change, for caches that render the
+  // alarms. Not persisted, like versions.
+  static unsigned int generation;
+  // Bumped whenever list[idx] changes, so a cache of each alarm (see the
+  // /alarms fragment in webserver.cpp) can redo only what changed.
+  static unsigned int versions[MAX_ALARMS];
+  // The UI edits the alarms on the loop task and the web server on its own,
+  // every method holds this while it runs. Hold it too around an add() or
+  // set() and the refresh() and save_into_fs() after it, so another task
+  // can't change the list in between. Recursive so the methods can take it
+  // again, and static as the object itself is what gets saved.
+  static std::recursive_mutex mutex;
+
   char version = ALARM_VERSION;
   Alarm list[MAX_ALARMS];
 
@@ -134,6 +162,10 @@ class Alarms {
   char ringing_flags;
   // Last ringed alarm's compartment.
   char last_compartment;
+
+ private:
+  // Bumps the counters of idx (all with -1) and calls the subscribers.
+  static void changed(int idx);
 };
 
 #endif
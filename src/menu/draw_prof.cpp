@@ -0,0 +1,357 @@
+#include "draw_prof.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include LVGL_PRIVATE_INCLUDE
+#ifdef SMC_DESKTOP
+#include <ctime>
+#else
+#include <Arduino.h>
+#endif
+
+// Indexed by lv_draw_task_type_t.
+static const char* const TYPE_NAMES[] = {
+    "none",  "fill",     "border",    "shadow",    "letter", "label",
+    "image", "layer",    "line",      "arc",       "triangle",
+    "mask rect", "mask bitmap", "blur", "vector", "3d",
+};
+static const int TYPES = sizeof(TYPE_NAMES) / sizeof(TYPE_NAMES[0]);
+
+struct DrawProfStats {
+  uint32_t tasks;
+  uint64_t cycles;
+  uint64_t pixels;
+};
+
+struct DrawProfObj {
+  lv_obj_t* obj;  // NULL once deleted, the entry stays for the report
+  char desc[32];
+  DrawProfStats stats;
+  uint32_t frames;  // Frames it was drawn in
+  uint32_t frame_cycles;
+  uint32_t max_frame_cycles;
+};
+
+static lv_display_t* prof_disp = NULL;
+static lv_draw_unit_t* prof_unit = NULL;
+static int32_t (*unit_dispatch_cb)(lv_draw_unit_t*, lv_layer_t*) = NULL;
+static uint32_t cycles_per_us = 1000;
+
+static DrawProfStats types[TYPES];
+// Allocated while on. Widgets beyond DRAW_PROF_OBJS go to others, tasks
+// without one (e.g. the display's background) to no_obj.
+static DrawProfObj* objs = NULL;
+static int obj_count = 0;
+static DrawProfObj no_obj;
+static DrawProfObj others;
+
+static uint32_t frames = 0;
+static uint64_t total_cycles = 0;
+static uint32_t frame_cycles = 0;
+static uint32_t worst_frame_cycles = 0;
+static uint32_t worst_frame_ms = 0;
+
+// Nanoseconds on the desktop, so cycles_per_us stays 1000 there.
+static uint32_t now_cycles(void) {
+#ifdef SMC_DESKTOP
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+#else
+  return ESP.getCycleCount();
+#endif
+}
+
+static void describe(lv_obj_t* obj, char* dest, size_t size) {
+  const char* name = lv_obj_get_class(obj)->name;
+  if (name == NULL) {
+    name = "?";
+  } else if (strncmp(name, "lv_", 3) == 0) {
+    name += 3;
+  }
+
+  if (lv_obj_check_type(obj, &lv_label_class)) {
+    // Without the symbols and the spaces after them, which upset the columns
+    char text[24];
+    size_t len = 0;
+    for (const char* c = lv_label_get_text(obj); *c && len + 1 < sizeof(text);
+         c++) {
+      if ((uint8_t)*c < 0x80 && (len > 0 || *c != ' ')) {
+        text[len++] = *c;
+      }
+    }
+    text[len] = 0x00;
+    snprintf(dest, size, "%s \"%s\"", name, text);
+    return;
+  }
+
+  lv_area_t coords;
+  lv_obj_get_coords(obj, &coords);
+  snprintf(dest, size, "%s %dx%d+%d+%d", name, (int)lv_area_get_width(&coords),
+           (int)lv_area_get_height(&coords), (int)coords.x1, (int)coords.y1);
+}
+
+static void obj_deleted_cb(lv_event_t* e) {
+  auto* entry = static_cast<DrawProfObj*>(lv_event_get_user_data(e));
+  entry->obj = NULL;
+}
+
+static DrawProfObj* obj_entry(lv_obj_t* obj) {
+  if (obj == NULL) {
+    return &no_obj;
+  }
+  for (int i = 0; i < obj_count; i++) {
+    if (objs[i].obj == obj) {
+      return &objs[i];
+    }
+  }
+
+  // A screen built again on every visit goes on with the entry of the last
+  // one, otherwise each visit would take entries.
+  char desc[sizeof(objs[0].desc)];
+  describe(obj, desc, sizeof(desc));
+  DrawProfObj* entry = NULL;
+  for (int i = 0; i < obj_count && entry == NULL; i++) {
+    if (objs[i].obj == NULL && strcmp(objs[i].desc, desc) == 0) {
+      entry = &objs[i];
+    }
+  }
+  if (entry == NULL) {
+    if (obj_count == DRAW_PROF_OBJS) {
+      return &others;
+    }
+    entry = &objs[obj_count++];
+    memset(entry, 0, sizeof(DrawProfObj));
+    strcpy(entry->desc, desc);
+  }
+
+  // Followed while it exists, addresses get reused for other widgets.
+  entry->obj = obj;
+  lv_obj_add_event_cb(obj, obj_deleted_cb, LV_EVENT_DELETE, entry);
+  return entry;
+}
+
+static void add_stats(DrawProfStats* stats, uint32_t cycles, uint32_t pixels) {
+  stats->tasks++;
+  stats->cycles += cycles;
+  stats->pixels += pixels;
+}
+
+static void record(lv_draw_task_t* t, uint32_t cycles) {
+  lv_area_t drawn;
+  uint32_t pixels = 0;
+  if (lv_area_intersect(&drawn, &t->area, &t->clip_area)) {
+    pixels = lv_area_get_size(&drawn);
+  }
+
+  if (t->type < TYPES) {
+    add_stats(&types[t->type], cycles, pixels);
+  }
+
+  // Every draw descriptor starts with lv_draw_dsc_base_t.
+  auto* base = static_cast<lv_draw_dsc_base_t*>(t->draw_dsc);
+  DrawProfObj* entry = obj_entry(base != NULL ? base->obj : NULL);
+  add_stats(&entry->stats, cycles, pixels);
+  entry->frame_cycles += cycles;
+
+  frame_cycles += cycles;
+}
+
+// The software unit takes the first task it can, the same one this finds.
+// Only a task which then finished is recorded.
+static int32_t dispatch_cb(lv_draw_unit_t* unit, lv_layer_t* layer) {
+  lv_draw_task_t* t = lv_draw_get_available_task(layer, NULL, unit->idx);
+
+  uint32_t started = now_cycles();
+  int32_t res = unit_dispatch_cb(unit, layer);
+  uint32_t cycles = now_cycles() - started;
+
+  if (t != NULL && t->state == LV_DRAW_TASK_STATE_FINISHED) {
+    record(t, cycles);
+  }
+  return res;
+}
+
+static void frame_end(DrawProfObj* entry) {
+  if (entry->frame_cycles == 0) {
+    return;
+  }
+  entry->frames++;
+  if (entry->frame_cycles > entry->max_frame_cycles) {
+    entry->max_frame_cycles = entry->frame_cycles;
+  }
+  entry->frame_cycles = 0;
+}
+
+static void refr_ready_cb(lv_event_t* e) {
+  LV_UNUSED(e);
+  if (frame_cycles == 0) {
+    return;
+  }
+
+  frames++;
+  total_cycles += frame_cycles;
+  if (frame_cycles > worst_frame_cycles) {
+    worst_frame_cycles = frame_cycles;
+    worst_frame_ms = lv_tick_get();
+  }
+  frame_cycles = 0;
+
+  for (int i = 0; i < obj_count; i++) {
+    frame_end(&objs[i]);
+  }
+  frame_end(&no_obj);
+  frame_end(&others);
+}
+
+void smc_draw_prof_reset(void) {
+  for (int i = 0; i < obj_count; i++) {
+    if (objs[i].obj != NULL) {
+      lv_obj_remove_event_cb_with_user_data(objs[i].obj, obj_deleted_cb,
+                                            &objs[i]);
+    }
+  }
+  obj_count = 0;
+
+  memset(types, 0, sizeof(types));
+  memset(&no_obj, 0, sizeof(no_obj));
+  strcpy(no_obj.desc, "(no widget)");
+  memset(&others, 0, sizeof(others));
+  strcpy(others.desc, "(others)");
+
+  frames = 0;
+  total_cycles = 0;
+  frame_cycles = 0;
+  worst_frame_cycles = 0;
+  worst_frame_ms = 0;
+}
+
+void smc_draw_prof_start(lv_display_t* disp) {
+#if LV_USE_OS != LV_OS_NONE
+  LV_UNUSED(disp);
+  LV_LOG_WARN("the draw profiler needs LV_USE_OS LV_OS_NONE");
+#else
+  if (prof_unit != NULL) {
+    return;
+  }
+
+  // The software renderer, the only unit on the device and the desktop
+  lv_draw_unit_t* unit = LV_GLOBAL_DEFAULT()->draw_info.unit_head;
+  while (unit != NULL && strcmp(unit->name, "SW") != 0) {
+    unit = unit->next;
+  }
+  if (unit == NULL) {
+    LV_LOG_WARN("the draw profiler found no software renderer");
+    return;
+  }
+
+#ifndef SMC_DESKTOP
+  cycles_per_us = getCpuFrequencyMhz();
+#endif
+  objs = static_cast<DrawProfObj*>(lv_malloc(sizeof(DrawProfObj) *
+                                             DRAW_PROF_OBJS));
+  LV_ASSERT_MALLOC(objs);
+  smc_draw_prof_reset();
+
+  prof_unit = unit;
+  unit_dispatch_cb = unit->dispatch_cb;
+  unit->dispatch_cb = dispatch_cb;
+  prof_disp = disp;
+  lv_display_add_event_cb(disp, refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+#endif
+}
+
+void smc_draw_prof_stop(void) {
+  if (prof_unit == NULL) {
+    return;
+  }
+
+  smc_draw_prof_reset();
+  lv_free(objs);
+  objs = NULL;
+
+  prof_unit->dispatch_cb = unit_dispatch_cb;
+  prof_unit = NULL;
+  lv_display_remove_event_cb_with_user_data(prof_disp, refr_ready_cb, NULL);
+  prof_disp = NULL;
+}
+
+static void append(char* dest, size_t size, size_t* len, const char* fmt,
+                   ...) {
+  if (*len + 1 >= size) {
+    return;
+  }
+  va_list args;
+  va_start(args, fmt);
+  int res = vsnprintf(dest + *len, size - *len, fmt, args);
+  va_end(args);
+  if (res > 0) {
+    *len += (size_t)res < size - *len ? (size_t)res : size - *len - 1;
+  }
+}
+
+static unsigned long us(uint64_t cycles) {
+  return (unsigned long)(cycles / cycles_per_us);
+}
+
+static int by_cycles(const void* a, const void* b) {
+  uint64_t ca = (*(const DrawProfObj* const*)a)->stats.cycles;
+  uint64_t cb = (*(const DrawProfObj* const*)b)->stats.cycles;
+  return ca < cb ? 1 : ca > cb ? -1 : 0;
+}
+
+size_t smc_draw_prof_report(char* dest, size_t size) {
+  size_t len = 0;
+  dest[0] = 0x00;
+
+  append(dest, size, &len,
+         "draw: %lu frames, %luus drawing, worst %luus at %lums\n",
+         (unsigned long)frames, us(total_cycles), us(worst_frame_cycles),
+         (unsigned long)worst_frame_ms);
+
+  append(dest, size, &len, "%-12s %6s %8s %9s\n", "type", "tasks", "us",
+         "px");
+  bool shown[TYPES] = {};
+  for (;;) {
+    int top = -1;
+    for (int i = 0; i < TYPES; i++) {
+      if (!shown[i] && types[i].tasks > 0 &&
+          (top == -1 || types[i].cycles > types[top].cycles)) {
+        top = i;
+      }
+    }
+    if (top == -1) {
+      break;
+    }
+    shown[top] = true;
+    append(dest, size, &len, "%-12s %6lu %8lu %9llu\n", TYPE_NAMES[top],
+           (unsigned long)types[top].tasks, us(types[top].cycles),
+           (unsigned long long)types[top].pixels);
+  }
+
+  DrawProfObj* ranked[DRAW_PROF_OBJS + 2];
+  int count = 0;
+  for (int i = 0; i < obj_count; i++) {
+    ranked[count++] = &objs[i];
+  }
+  ranked[count++] = &no_obj;
+  ranked[count++] = &others;
+  qsort(ranked, count, sizeof(ranked[0]), by_cycles);
+
+  append(dest, size, &len, "%-31s %6s %6s %8s %8s %9s\n", "widget", "tasks",
+         "frames", "us", "max us/f", "px");
+  for (int i = 0; i < count && i < DRAW_PROF_TOP; i++) {
+    const DrawProfObj* entry = ranked[i];
+    if (entry->stats.tasks == 0) {
+      break;
+    }
+    append(dest, size, &len, "%-31.31s %6lu %6lu %8lu %8lu %9llu\n",
+           entry->desc, (unsigned long)entry->stats.tasks,
+           (unsigned long)entry->frames, us(entry->stats.cycles),
+           us(entry->max_frame_cycles),
+           (unsigned long long)entry->stats.pixels);
+  }
+
+  return len;
+}
@@ -0,0 +1,31 @@
+#ifndef SMC_DRAW_PROF_H
+#define SMC_DRAW_PROF_H
+
+#include <cstddef>
+#include "menu.h"
+#include LVGL_INCLUDE
+
+// Widgets told apart in the report, the rest are counted as "(others)".
+static const int DRAW_PROF_OBJS = 96;
+// Rows of the widget table in the report.
+static const int DRAW_PROF_TOP = 16;
+
+// Attributes the software renderer's time and pixels to the widget each draw
+// task was made for (a fill of a button, the letters of a label...) and to the
+// type of the task, per frame of disp.
+//
+// It stands in for the renderer's dispatch, runs it and times what it drew.
+// That only works while LVGL draws on the calling task, LV_USE_OS being
+// LV_OS_NONE, as on the device and the desktop. Costs a few microseconds per
+// task while on and nothing while off.
+void smc_draw_prof_start(lv_display_t* disp);
+void smc_draw_prof_stop(void);
+// Forgets what was recorded, e.g. after a report.
+void smc_draw_prof_reset(void);
+
+// Writes the frames and their draw time, then the task types and the
+// DRAW_PROF_TOP widgets which took longest, into dest as lines of text.
+// Returns the length, which is cut at size - 1.
+size_t smc_draw_prof_report(char* dest, size_t size);
+
+#endif
@@ -12,7 +12,13 @@
 #include <cmath>
 #include <cstdio>
 #include <cstring>
-#include "../thirdparty/lvgl/lvgl.h"
+#include "../ui.h"
+#include "alarm.h"
+#include "lvgl_homescreen.h"
+#include "menu.h"
+#include "theme.h"
+#include "vlist.h"
+#include LVGL_INCLUDE
 
 /* ─── Screen & layout ─────────────────────────────────────────────── */
 #define SCREEN_W 320
@@ -28,18 +34,18 @@
 
 #define TRANSITION_MS 220
 
-static void alarm_list_rebuild(void);
+/* App screens kept after going back home, see app_screens_evict() */
+#define APP_SCREEN_CACHE 3
 
-/* ─── Colour helpers ──────────────────────────────────────────────── */
-static inline lv_color_t col(uint8_t r, uint8_t g, uint8_t b) {
-  return lv_color_make(r, g, b);
-}
+static void alarm_list_refresh(uint32_t dirty);
 
 /* ─── App descriptor ──────────────────────────────────────────────── */
 struct AppInfo {
   const char* icon_label;
   const char* name;
+  /* Builds the app in content, once, see open_app_screen() */
   void (*on_open)(lv_obj_t* content);
+  /* Called when the app's screen is deleted */
   void (*on_close)(lv_obj_t* content);
 };
 
@@ -71,6 +77,7 @@ static const AppInfo apps[8] = {
     {"ALM", "Alarms", open_alarms, close_alarms},
     {"SET", "Settings", open_settings, close_settings},
 };
+static const int APP_ALARMS = 6;
 
 /* ═══════════════════════════════════════════════════════════════════
  * FULLSCREEN KEYBOARD OVERLAY
@@ -108,11 +115,8 @@ static void kb_overlay_show(lv_obj_t* ta) {
     s_kb_overlay = lv_obj_create(lv_layer_top());
     lv_obj_set_size(s_kb_overlay, SCREEN_W, SCREEN_H);
     lv_obj_set_pos(s_kb_overlay, 0, 0);
-    lv_obj_set_style_bg_color(s_kb_overlay, lv_color_black(), 0);
+    lv_obj_add_style(s_kb_overlay, &smc_styles.dim, 0);
     lv_obj_set_style_bg_opa(s_kb_overlay, LV_OPA_50, 0);
-    lv_obj_set_style_border_width(s_kb_overlay, 0, 0);
-    lv_obj_set_style_radius(s_kb_overlay, 0, 0);
-    lv_obj_set_style_pad_all(s_kb_overlay, 0, 0);
     lv_obj_clear_flag(s_kb_overlay, LV_OBJ_FLAG_SCROLLABLE);
     /* Tap outside keyboard closes it */
     lv_obj_add_flag(s_kb_overlay, LV_OBJ_FLAG_CLICKABLE);
@@ -128,8 +132,7 @@ static void kb_overlay_show(lv_obj_t* ta) {
     s_kb_widget = lv_keyboard_create(s_kb_overlay);
     lv_obj_set_size(s_kb_widget, SCREEN_W, 130);
     lv_obj_align(s_kb_widget, LV_ALIGN_BOTTOM_MID, 0, 0);
-    lv_obj_set_style_bg_color(s_kb_widget, col(20, 20, 40), 0);
-    lv_obj_set_style_text_color(s_kb_widget, lv_color_white(), 0);
+    lv_obj_add_style(s_kb_widget, &smc_styles.keyboard, 0);
     /* Prevent taps on the kb itself from closing the overlay */
     lv_obj_add_event_cb(
         s_kb_widget, [](lv_event_t* ev) { lv_event_stop_bubbling(ev); },
@@ -171,59 +174,47 @@ void msgbox_show(const char* header, const char* body, const char* btn_label,
   lv_obj_t* overlay = lv_obj_create(lv_layer_top());
   lv_obj_set_size(overlay, SCREEN_W, SCREEN_H);
   lv_obj_set_pos(overlay, 0, 0);
-  lv_obj_set_style_bg_color(overlay, lv_color_black(), 0);
+  lv_obj_add_style(overlay, &smc_styles.dim, 0);
   lv_obj_set_style_bg_opa(overlay, LV_OPA_60, 0);
-  lv_obj_set_style_border_width(overlay, 0, 0);
-  lv_obj_set_style_radius(overlay, 0, 0);
-  lv_obj_set_style_pad_all(overlay, 0, 0);
   lv_obj_clear_flag(overlay, LV_OBJ_FLAG_SCROLLABLE);
   lv_obj_add_flag(overlay, LV_OBJ_FLAG_CLICKABLE);
 
   lv_obj_t* box = lv_obj_create(overlay);
   lv_obj_set_size(box, 260, 160);
   lv_obj_align(box, LV_ALIGN_CENTER, 0, 0);
-  lv_obj_set_style_bg_color(box, col(30, 30, 55), 0);
-  lv_obj_set_style_border_color(box, col(100, 100, 160), 0);
-  lv_obj_set_style_border_width(box, 1, 0);
-  lv_obj_set_style_radius(box, 12, 0);
+  lv_obj_add_style(box, &smc_styles.panel, 0);
   lv_obj_set_style_pad_all(box, 12, 0);
   lv_obj_clear_flag(box, LV_OBJ_FLAG_SCROLLABLE);
 
   lv_obj_t* hdr = lv_label_create(box);
   lv_label_set_text(hdr, header);
   lv_obj_set_width(hdr, 236);
-  lv_obj_set_style_text_color(hdr, lv_color_white(), 0);
-  lv_obj_set_style_text_font(hdr, &lv_font_montserrat_14, 0);
+  lv_obj_add_style(hdr, &smc_styles.text_big, 0);
   lv_label_set_long_mode(hdr, LV_LABEL_LONG_WRAP);
   lv_obj_align(hdr, LV_ALIGN_TOP_MID, 0, 0);
 
   lv_obj_t* div = lv_obj_create(box);
   lv_obj_set_size(div, 236, 1);
-  lv_obj_set_style_bg_color(div, col(100, 100, 160), 0);
-  lv_obj_set_style_border_width(div, 0, 0);
-  lv_obj_set_style_radius(div, 0, 0);
+  lv_obj_add_style(div, &smc_styles.divider, 0);
   lv_obj_align_to(div, hdr, LV_ALIGN_OUT_BOTTOM_MID, 0, 5);
 
   lv_obj_t* txt = lv_label_create(box);
   lv_label_set_text(txt, body);
   lv_obj_set_width(txt, 236);
-  lv_obj_set_style_text_color(txt, col(200, 200, 220), 0);
-  lv_obj_set_style_text_font(txt, &lv_font_montserrat_12, 0);
+  lv_obj_add_style(txt, &smc_styles.text_body, 0);
   lv_label_set_long_mode(txt, LV_LABEL_LONG_WRAP);
   lv_obj_align_to(txt, div, LV_ALIGN_OUT_BOTTOM_MID, 0, 6);
 
   lv_obj_t* btn = lv_btn_create(box);
   lv_obj_set_size(btn, 236, 36);
   lv_obj_align(btn, LV_ALIGN_BOTTOM_MID, 0, 0);
-  lv_obj_set_style_bg_color(btn, col(70, 70, 180), 0);
-  lv_obj_set_style_bg_color(btn, col(90, 90, 210), LV_STATE_PRESSED);
-  lv_obj_set_style_radius(btn, 8, 0);
-  lv_obj_set_style_border_width(btn, 0, 0);
+  lv_obj_add_style(btn, &smc_styles.btn, 0);
+  lv_obj_add_style(btn, &smc_styles.btn_primary, 0);
+  lv_obj_add_style(btn, &smc_styles.btn_primary_pressed, LV_STATE_PRESSED);
 
   lv_obj_t* blbl = lv_label_create(btn);
   lv_label_set_text(blbl, btn_label);
-  lv_obj_set_style_text_color(blbl, lv_color_white(), 0);
-  lv_obj_set_style_text_font(blbl, &lv_font_montserrat_12, 0);
+  lv_obj_add_style(blbl, &smc_styles.text, 0);
   lv_obj_center(blbl);
 
   auto* ctx = new MsgBoxCtx{overlay, on_close};
@@ -233,49 +224,95 @@ void msgbox_show(const char* header, const char* body, const char* btn_label,
 /* ═══════════════════════════════════════════════════════════════════
  * ALARM APP
  * ═══════════════════════════════════════════════════════════════════ */
-#define MAX_ALARMS 16
 #define DAY_COUNT 7
 static const char* DAY_NAMES[DAY_COUNT] = {"Su", "Mo", "Tu", "We",
                                            "Th", "Fr", "Sa"};
 
-struct AlarmEntry {
-  char name[32];
-  char desc[64];
-  uint8_t hour;   /* 1-12 */
-  uint8_t minute; /* 0-59 */
-  bool is_pm;
-  bool days[DAY_COUNT];
-};
+/* The list shows the valid alarms of the store in slot order, row i being
+ * slot alarm_slots[i]. */
+static Alarms* alarm_store = nullptr;
+static int alarm_slots[MAX_ALARMS];
+static int alarm_slot_count = 0;
+
+/* Slots changed since the last homescreen_alarms_sync(), one bit each */
+static uint32_t alarm_dirty = 0;
+static_assert(MAX_ALARMS <= 32, "alarm_dirty has a bit per slot");
 
-static AlarmEntry alarm_list[MAX_ALARMS];
-static int alarm_count = 0;
-static lv_obj_t* alarm_list_container = nullptr;
+static VList* alarm_vlist = nullptr;
+static lv_obj_t* alarm_list_empty = nullptr;
 
-/* ── Clock face canvas ────────────────────────────────────────────── */
+/* ── Clock face ───────────────────────────────────────────────────── */
 #define CLOCK_CANVAS_SIZE 90
 #define CLOCK_CX (CLOCK_CANVAS_SIZE / 2)
 #define CLOCK_CY (CLOCK_CANVAS_SIZE / 2)
 #define CLOCK_R 42      /* outer circle radius   */
 #define CLOCK_HAND_H 28 /* hour hand length      */
 #define CLOCK_HAND_M 36 /* minute hand length    */
+#define CLOCK_DOT 6     /* centre dot diameter   */
+
+/* The dial without hands, drawn into this once and then only shown. The hands
+ * are line objects on top, so moving one redraws its old and new area only. */
+static LV_ATTRIBUTE_MEM_ALIGN uint8_t
+    s_dial_buf[LV_CANVAS_BUF_SIZE(CLOCK_CANVAS_SIZE, CLOCK_CANVAS_SIZE, 16,
+                                  LV_DRAW_BUF_STRIDE_ALIGN)];
+static bool s_dial_drawn = false;
+
+/* sin() of 0 to 90 degrees in half degrees, times 16384 */
+static constexpr int16_t CLOCK_SIN_Q14[181] = {
+    0,     143,   286,   429,   572,   715,   857,   1000,  1143,  1285,
+    1428,  1570,  1713,  1855,  1997,  2139,  2280,  2422,  2563,  2704,
+    2845,  2986,  3126,  3266,  3406,  3546,  3686,  3825,  3964,  4102,
+    4240,  4378,  4516,  4653,  4790,  4927,  5063,  5199,  5334,  5469,
+    5604,  5738,  5872,  6005,  6138,  6270,  6402,  6533,  6664,  6794,
+    6924,  7053,  7182,  7311,  7438,  7565,  7692,  7818,  7943,  8068,
+    8192,  8316,  8438,  8561,  8682,  8803,  8923,  9043,  9162,  9280,
+    9397,  9514,  9630,  9746,  9860,  9974,  10087, 10199, 10311, 10422,
+    10531, 10641, 10749, 10856, 10963, 11069, 11174, 11278, 11381, 11484,
+    11585, 11686, 11786, 11885, 11982, 12080, 12176, 12271, 12365, 12458,
+    12551, 12642, 12733, 12822, 12911, 12998, 13085, 13170, 13255, 13338,
+    13421, 13502, 13583, 13662, 13741, 13818, 13894, 13970, 14044, 14117,
+    14189, 14260, 14330, 14399, 14466, 14533, 14598, 14663, 14726, 14788,
+    14849, 14909, 14968, 15025, 15082, 15137, 15191, 15244, 15296, 15346,
+    15396, 15444, 15491, 15537, 15582, 15626, 15668, 15709, 15749, 15788,
+    15826, 15862, 15897, 15931, 15964, 15996, 16026, 16055, 16083, 16110,
+    16135, 16159, 16182, 16204, 16225, 16244, 16262, 16279, 16294, 16309,
+    16322, 16333, 16344, 16353, 16362, 16368, 16374, 16378, 16382, 16383,
+    16384,
+};
+
+/* sin() of a half degrees, 0-719 */
+static int32_t clock_sin(int a) {
+  if (a < 180)
+    return CLOCK_SIN_Q14[a];
+  if (a < 360)
+    return CLOCK_SIN_Q14[360 - a];
+  if (a < 540)
+    return -CLOCK_SIN_Q14[a - 360];
+  return -CLOCK_SIN_Q14[720 - a];
+}
 
-static lv_color_t s_clock_buf[CLOCK_CANVAS_SIZE * CLOCK_CANVAS_SIZE];
+/* The point len from the centre at a half degrees clockwise from 12 */
+static lv_point_t clock_point(int a, int len) {
+  int32_t x = (len * clock_sin(a) + 8192) >> 14;
+  int32_t y = (len * clock_sin((a + 180) % 720) + 8192) >> 14;
+  return {CLOCK_CX + x, CLOCK_CY - y};
+}
 
 struct ClockCtx {
   lv_obj_t* canvas;
+  lv_obj_t* hand_h;
+  lv_obj_t* hand_m;
+  lv_point_precise_t hand_h_pts[2]; /* lv_line keeps a pointer to these */
+  lv_point_precise_t hand_m_pts[2];
   lv_obj_t* slider_h; /* hour   0-11 */
   lv_obj_t* slider_m; /* minute 0-59 */
   lv_obj_t* ampm_btn;
   lv_obj_t* time_label; /* "12:00 AM" display on face */
 };
 
-static void clock_redraw(ClockCtx* ctx) {
-  int h = (int)lv_slider_get_value(ctx->slider_h); /* 0-11 */
-  int m = (int)lv_slider_get_value(ctx->slider_m); /* 0-59 */
-
-  /* ── Begin drawing layer on the canvas ── */
+static void clock_dial_draw(lv_obj_t* canvas) {
   lv_layer_t layer;
-  lv_canvas_init_layer(ctx->canvas, &layer);
+  lv_canvas_init_layer(canvas, &layer);
 
   /* ── Fill background ── */
   lv_draw_fill_dsc_t fill_dsc;
@@ -305,60 +342,36 @@ static void clock_redraw(ClockCtx* ctx) {
   tick_dsc.width = 1;
   tick_dsc.opa = LV_OPA_COVER;
   for (int i = 0; i < 12; i++) {
-    float ang = (float)i / 12.0f * 2.0f * (float)M_PI - (float)M_PI / 2.0f;
-    tick_dsc.p1.x = (int32_t)(CLOCK_CX + (CLOCK_R - 5) * cosf(ang));
-    tick_dsc.p1.y = (int32_t)(CLOCK_CY + (CLOCK_R - 5) * sinf(ang));
-    tick_dsc.p2.x = (int32_t)(CLOCK_CX + (CLOCK_R - 1) * cosf(ang));
-    tick_dsc.p2.y = (int32_t)(CLOCK_CY + (CLOCK_R - 1) * sinf(ang));
+    lv_point_t p1 = clock_point(i * 60, CLOCK_R - 5);
+    lv_point_t p2 = clock_point(i * 60, CLOCK_R - 1);
+    tick_dsc.p1 = {p1.x, p1.y};
+    tick_dsc.p2 = {p2.x, p2.y};
     lv_draw_line(&layer, &tick_dsc);
   }
 
-  /* ── Minute hand (thin, long, green) ── */
-  lv_draw_line_dsc_t hand_m_dsc;
-  lv_draw_line_dsc_init(&hand_m_dsc);
-  hand_m_dsc.color = col(60, 200, 110);
-  hand_m_dsc.width = 2;
-  hand_m_dsc.opa = LV_OPA_COVER;
-  {
-    float ang = (float)m / 60.0f * 2.0f * (float)M_PI - (float)M_PI / 2.0f;
-    hand_m_dsc.p1.x = CLOCK_CX;
-    hand_m_dsc.p1.y = CLOCK_CY;
-    hand_m_dsc.p2.x = (int32_t)(CLOCK_CX + CLOCK_HAND_M * cosf(ang));
-    hand_m_dsc.p2.y = (int32_t)(CLOCK_CY + CLOCK_HAND_M * sinf(ang));
-    lv_draw_line(&layer, &hand_m_dsc);
-  }
+  lv_canvas_finish_layer(canvas, &layer);
+}
 
-  /* ── Hour hand (thick, short, blue) ── */
-  lv_draw_line_dsc_t hand_h_dsc;
-  lv_draw_line_dsc_init(&hand_h_dsc);
-  hand_h_dsc.color = col(80, 130, 255);
-  hand_h_dsc.width = 3;
-  hand_h_dsc.opa = LV_OPA_COVER;
-  {
-    float ang = ((float)h + (float)m / 60.0f) / 12.0f * 2.0f * (float)M_PI -
-                (float)M_PI / 2.0f;
-    hand_h_dsc.p1.x = CLOCK_CX;
-    hand_h_dsc.p1.y = CLOCK_CY;
-    hand_h_dsc.p2.x = (int32_t)(CLOCK_CX + CLOCK_HAND_H * cosf(ang));
-    hand_h_dsc.p2.y = (int32_t)(CLOCK_CY + CLOCK_HAND_H * sinf(ang));
-    lv_draw_line(&layer, &hand_h_dsc);
-  }
+/* Moves hand to the point len from the centre at a half degrees. The line is
+ * placed at its bounding box so LVGL only redraws where it was and is. */
+static void clock_hand_set(lv_obj_t* hand, lv_point_precise_t* pts, int a,
+                           int len) {
+  lv_point_t tip = clock_point(a, len);
+  int32_t x = LV_MIN(tip.x, CLOCK_CX);
+  int32_t y = LV_MIN(tip.y, CLOCK_CY);
+
+  lv_obj_set_pos(hand, x, y);
+  pts[0] = {CLOCK_CX - x, CLOCK_CY - y};
+  pts[1] = {tip.x - x, tip.y - y};
+  lv_line_set_points(hand, pts, 2);
+}
 
-  /* ── Centre dot ── */
-  lv_draw_arc_dsc_t dot_dsc;
-  lv_draw_arc_dsc_init(&dot_dsc);
-  dot_dsc.color = lv_color_white();
-  dot_dsc.width = 3;
-  dot_dsc.opa = LV_OPA_COVER;
-  dot_dsc.center.x = CLOCK_CX;
-  dot_dsc.center.y = CLOCK_CY;
-  dot_dsc.radius = 3;
-  dot_dsc.start_angle = 0;
-  dot_dsc.end_angle = 360;
-  lv_draw_arc(&layer, &dot_dsc);
-
-  /* ── Finish drawing ── */
-  lv_canvas_finish_layer(ctx->canvas, &layer);
+static void clock_redraw(ClockCtx* ctx) {
+  int h = (int)lv_slider_get_value(ctx->slider_h); /* 0-11 */
+  int m = (int)lv_slider_get_value(ctx->slider_m); /* 0-59 */
+
+  clock_hand_set(ctx->hand_m, ctx->hand_m_pts, m * 12, CLOCK_HAND_M);
+  clock_hand_set(ctx->hand_h, ctx->hand_h_pts, h * 60 + m, CLOCK_HAND_H);
 
   /* ── Update time label ── */
   int disp_h = h == 0 ? 12 : h; /* 0-indexed slider, display 1-12 */
@@ -381,12 +394,10 @@ static void clock_ampm_cb(lv_event_t* e) {
   lv_obj_t* lbl = lv_obj_get_child(ctx->ampm_btn, 0);
   if (strcmp(lv_label_get_text(lbl), "AM") == 0) {
     lv_label_set_text(lbl, "PM");
-    lv_obj_set_style_bg_color(ctx->ampm_btn, col(140, 40, 80),
-                              LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_add_state(ctx->ampm_btn, LV_STATE_CHECKED);
   } else {
     lv_label_set_text(lbl, "AM");
-    lv_obj_set_style_bg_color(ctx->ampm_btn, col(60, 40, 130),
-                              LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_remove_state(ctx->ampm_btn, LV_STATE_CHECKED);
   }
   clock_redraw(ctx);
 }
@@ -405,19 +416,33 @@ static void clock_ampm_cb(lv_event_t* e) {
 static ClockCtx* clock_widget_create(lv_obj_t* parent, int parent_w) {
   auto* ctx = new ClockCtx{};
 
-  /* Canvas */
+  /* Canvas, the hands and the dot are its children */
   lv_obj_t* canvas = lv_canvas_create(parent);
-  lv_canvas_set_buffer(canvas, s_clock_buf, CLOCK_CANVAS_SIZE,
-                       CLOCK_CANVAS_SIZE, LV_COLOR_FORMAT_RGB888);
+  lv_canvas_set_buffer(canvas, s_dial_buf, CLOCK_CANVAS_SIZE,
+                       CLOCK_CANVAS_SIZE, LV_COLOR_FORMAT_RGB565);
   lv_obj_set_size(canvas, CLOCK_CANVAS_SIZE, CLOCK_CANVAS_SIZE);
   lv_obj_align(canvas, LV_ALIGN_TOP_MID, 0, 0);
+  if (!s_dial_drawn) {
+    clock_dial_draw(canvas);
+    s_dial_drawn = true;
+  }
   ctx->canvas = canvas;
 
+  ctx->hand_m = lv_line_create(canvas);
+  lv_obj_add_style(ctx->hand_m, &smc_styles.clock_hand_m, 0);
+  ctx->hand_h = lv_line_create(canvas);
+  lv_obj_add_style(ctx->hand_h, &smc_styles.clock_hand_h, 0);
+
+  lv_obj_t* dot = lv_obj_create(canvas);
+  lv_obj_set_size(dot, CLOCK_DOT, CLOCK_DOT);
+  lv_obj_set_pos(dot, CLOCK_CX - CLOCK_DOT / 2, CLOCK_CY - CLOCK_DOT / 2);
+  lv_obj_add_style(dot, &smc_styles.clock_dot, 0);
+  lv_obj_remove_flag(dot, LV_OBJ_FLAG_CLICKABLE);
+
   /* Time label below canvas */
   lv_obj_t* tlbl = lv_label_create(parent);
   lv_label_set_text(tlbl, "12:00 AM");
-  lv_obj_set_style_text_color(tlbl, lv_color_white(), 0);
-  lv_obj_set_style_text_font(tlbl, &lv_font_montserrat_12, 0);
+  lv_obj_add_style(tlbl, &smc_styles.text, 0);
   lv_obj_align(tlbl, LV_ALIGN_TOP_MID, 0, CLOCK_CANVAS_SIZE + 4);
   ctx->time_label = tlbl;
 
@@ -429,8 +454,7 @@ static ClockCtx* clock_widget_create(lv_obj_t* parent, int parent_w) {
   /* Hour slider */
   lv_obj_t* h_lbl = lv_label_create(parent);
   lv_label_set_text(h_lbl, "H");
-  lv_obj_set_style_text_color(h_lbl, col(80, 130, 255), 0);
-  lv_obj_set_style_text_font(h_lbl, &lv_font_montserrat_12, 0);
+  lv_obj_add_style(h_lbl, &smc_styles.text_hour, 0);
   lv_obj_set_pos(h_lbl, lbl_x_h, slider_y + 2);
 
   lv_obj_t* sl_h = lv_slider_create(parent);
@@ -438,18 +462,16 @@ static ClockCtx* clock_widget_create(lv_obj_t* parent, int parent_w) {
   lv_slider_set_value(sl_h, 11, LV_ANIM_OFF); /* default 12 o'clock */
   lv_obj_set_size(sl_h, slider_w, 18);
   lv_obj_set_pos(sl_h, slider_x, slider_y);
-  lv_obj_set_style_bg_color(sl_h, col(50, 50, 80), LV_PART_MAIN);
-  lv_obj_set_style_bg_color(sl_h, col(80, 130, 255), LV_PART_INDICATOR);
-  lv_obj_set_style_bg_color(sl_h, lv_color_white(), LV_PART_KNOB);
-  lv_obj_set_style_radius(sl_h, 4, LV_PART_MAIN);
+  lv_obj_add_style(sl_h, &smc_styles.slider, LV_PART_MAIN);
+  lv_obj_add_style(sl_h, &smc_styles.slider_hour, LV_PART_INDICATOR);
+  lv_obj_add_style(sl_h, &smc_styles.slider_knob, LV_PART_KNOB);
   ctx->slider_h = sl_h;
 
   /* Minute slider */
   int m_slider_y = slider_y + 26;
   lv_obj_t* m_lbl = lv_label_create(parent);
   lv_label_set_text(m_lbl, "M");
-  lv_obj_set_style_text_color(m_lbl, col(60, 200, 110), 0);
-  lv_obj_set_style_text_font(m_lbl, &lv_font_montserrat_12, 0);
+  lv_obj_add_style(m_lbl, &smc_styles.text_minute, 0);
   lv_obj_set_pos(m_lbl, lbl_x_h, m_slider_y + 2);
 
   lv_obj_t* sl_m = lv_slider_create(parent);
@@ -457,10 +479,9 @@ static ClockCtx* clock_widget_create(lv_obj_t* parent, int parent_w) {
   lv_slider_set_value(sl_m, 0, LV_ANIM_OFF);
   lv_obj_set_size(sl_m, slider_w, 18);
   lv_obj_set_pos(sl_m, slider_x, m_slider_y);
-  lv_obj_set_style_bg_color(sl_m, col(50, 50, 80), LV_PART_MAIN);
-  lv_obj_set_style_bg_color(sl_m, col(60, 200, 110), LV_PART_INDICATOR);
-  lv_obj_set_style_bg_color(sl_m, lv_color_white(), LV_PART_KNOB);
-  lv_obj_set_style_radius(sl_m, 4, LV_PART_MAIN);
+  lv_obj_add_style(sl_m, &smc_styles.slider, LV_PART_MAIN);
+  lv_obj_add_style(sl_m, &smc_styles.slider_minute, LV_PART_INDICATOR);
+  lv_obj_add_style(sl_m, &smc_styles.slider_knob, LV_PART_KNOB);
   ctx->slider_m = sl_m;
 
   /* AM/PM toggle */
@@ -468,16 +489,15 @@ static ClockCtx* clock_widget_create(lv_obj_t* parent, int parent_w) {
   lv_obj_t* ampm = lv_btn_create(parent);
   lv_obj_set_size(ampm, 64, 24);
   lv_obj_set_pos(ampm, parent_w - 64, ampm_y);
-  lv_obj_set_style_bg_color(ampm, col(60, 40, 130), 0);
-  lv_obj_set_style_radius(ampm, 6, 0);
-  lv_obj_set_style_border_width(ampm, 0, 0);
-  lv_obj_set_style_pad_all(ampm, 0, 0);
+  lv_obj_add_style(ampm, &smc_styles.btn, 0);
+  lv_obj_add_style(ampm, &smc_styles.btn_small, 0);
+  lv_obj_add_style(ampm, &smc_styles.btn_ampm, 0);
+  lv_obj_add_style(ampm, &smc_styles.btn_ampm_checked, LV_STATE_CHECKED);
   ctx->ampm_btn = ampm;
 
   lv_obj_t* ampm_lbl = lv_label_create(ampm);
   lv_label_set_text(ampm_lbl, "AM");
-  lv_obj_set_style_text_color(ampm_lbl, lv_color_white(), 0);
-  lv_obj_set_style_text_font(ampm_lbl, &lv_font_montserrat_12, 0);
+  lv_obj_add_style(ampm_lbl, &smc_styles.text, 0);
   lv_obj_center(ampm_lbl);
 
   /* Wire events */
@@ -499,36 +519,113 @@ struct AddAlarmCtx {
   lv_obj_t* ta_name;
   lv_obj_t* ta_desc;
   lv_obj_t* day_btns[DAY_COUNT];
-  lv_obj_t* calendar;
+  lv_obj_t* date_lbl;
+  lv_calendar_date_t date;
   ClockCtx* clock_ctx;
 };
 
-static void add_alarm_confirm_cb(lv_event_t* e) {
+/* ── Date picker, a calendar on lv_layer_top() made when it is needed ── */
+static void date_label_update(AddAlarmCtx* ctx) {
+  lv_label_set_text_fmt(ctx->date_lbl, LV_SYMBOL_LIST "  %d-%02d-%02d",
+                        ctx->date.year, ctx->date.month, ctx->date.day);
+}
+
+static void date_picked_cb(lv_event_t* e) {
+  lv_obj_t* cal = (lv_obj_t*)lv_event_get_current_target(e);
+  auto* ctx = static_cast<AddAlarmCtx*>(lv_event_get_user_data(e));
+  lv_calendar_date_t date;
+  if (lv_calendar_get_pressed_date(cal, &date) != LV_RESULT_OK)
+    return;
+
+  ctx->date = date;
+  date_label_update(ctx);
+  lv_obj_delete_async(lv_obj_get_parent(cal));
+}
+
+static void date_btn_cb(lv_event_t* e) {
   if (lv_event_get_code(e) != LV_EVENT_CLICKED)
     return;
   auto* ctx = static_cast<AddAlarmCtx*>(lv_event_get_user_data(e));
 
-  if (alarm_count < MAX_ALARMS) {
-    AlarmEntry& a = alarm_list[alarm_count];
-
-    strncpy(a.name, lv_textarea_get_text(ctx->ta_name), 31);
-    a.name[31] = '\0';
-    strncpy(a.desc, lv_textarea_get_text(ctx->ta_desc), 63);
-    a.desc[63] = '\0';
+  lv_obj_t* overlay = lv_obj_create(lv_layer_top());
+  lv_obj_set_size(overlay, SCREEN_W, SCREEN_H);
+  lv_obj_set_pos(overlay, 0, 0);
+  lv_obj_add_style(overlay, &smc_styles.dim, 0);
+  lv_obj_set_style_bg_opa(overlay, LV_OPA_50, 0);
+  lv_obj_clear_flag(overlay, LV_OBJ_FLAG_SCROLLABLE);
+  /* Tap outside the calendar keeps the date */
+  lv_obj_add_flag(overlay, LV_OBJ_FLAG_CLICKABLE);
+  lv_obj_add_event_cb(
+      overlay,
+      [](lv_event_t* ev) {
+        if (lv_event_get_target(ev) == lv_event_get_current_target(ev))
+          lv_obj_delete_async((lv_obj_t*)lv_event_get_current_target(ev));
+      },
+      LV_EVENT_CLICKED, nullptr);
 
-    int h_raw = (int)lv_slider_get_value(ctx->clock_ctx->slider_h); /* 0-11 */
-    a.hour = (uint8_t)(h_raw == 0 ? 12 : h_raw); /* display as 1-12 */
-    a.minute = (uint8_t)lv_slider_get_value(ctx->clock_ctx->slider_m);
-    a.is_pm =
-        (strcmp(
-             lv_label_get_text(lv_obj_get_child(ctx->clock_ctx->ampm_btn, 0)),
-             "PM") == 0);
+  lv_obj_t* cal = lv_calendar_create(overlay);
+  lv_obj_set_size(cal, 292, 200);
+  lv_obj_center(cal);
+  lv_calendar_set_today_date(cal, 2025, 1, 1);
+  lv_calendar_set_showed_date(cal, ctx->date.year, ctx->date.month);
+  lv_calendar_set_highlighted_dates(cal, &ctx->date, 1);
+  lv_obj_add_style(cal, &smc_styles.calendar, 0);
+  lv_calendar_header_arrow_create(cal);
+  lv_obj_add_event_cb(cal, date_picked_cb, LV_EVENT_VALUE_CHANGED, ctx);
+}
 
-    for (int d = 0; d < DAY_COUNT; d++)
-      a.days[d] = lv_obj_has_state(ctx->day_btns[d], LV_STATE_CHECKED);
+static void add_alarm_confirm_cb(lv_event_t* e) {
+  if (lv_event_get_code(e) != LV_EVENT_CLICKED)
+    return;
+  auto* ctx = static_cast<AddAlarmCtx*>(lv_event_get_user_data(e));
 
-    alarm_count++;
-    alarm_list_rebuild();
+  Alarm a = {};
+  strncpy(a.name, lv_textarea_get_text(ctx->ta_name), sizeof(a.name) - 1);
+  strncpy(a.description, lv_textarea_get_text(ctx->ta_desc),
+          sizeof(a.description) - 1);
+
+  int h_raw = (int)lv_slider_get_value(ctx->clock_ctx->slider_h); /* 0-11 */
+  int m = (int)lv_slider_get_value(ctx->clock_ctx->slider_m);
+  bool is_pm =
+      (strcmp(lv_label_get_text(lv_obj_get_child(ctx->clock_ctx->ampm_btn, 0)),
+              "PM") == 0);
+  a.secondMark = ((h_raw + (is_pm ? 12 : 0)) * 60 + m) * 60;
+
+  for (int d = 0; d < DAY_COUNT; d++)
+    if (lv_obj_has_state(ctx->day_btns[d], LV_STATE_CHECKED))
+      a.days |= SUNDAY >> d;
+
+  /* The web server edits the store from its own task, hold it until the new
+   * alarm is saved. The list picks it up from the store, see
+   * alarm_store_cb() */
+  int idx;
+  int save_err = 0;
+  {
+    std::lock_guard<std::recursive_mutex> lock(Alarms::mutex);
+    idx = alarm_store->add(&a);
+    if (idx >= 0) {
+      time_t now_sec = time(NULL);
+      struct tm now;
+      gmtime_r(&now_sec, &now);
+      alarm_store->refresh(&now);
+      save_err = alarm_store->save_into_fs();
+    }
+  }
+  if (idx == -2) {
+    msgbox_show("New Alarm", "An alarm needs a name and at least one day.",
+                "OK", nullptr);
+    return;
+  }
+  if (idx < 0) {
+    msgbox_show("New Alarm", "There is no room for more alarms.", "OK",
+                nullptr);
+    return;
+  }
+  if (save_err != 0) {
+    msgbox_show("New Alarm",
+                "The alarm was added, but could not be saved and will be "
+                "gone after a restart.",
+                "OK", nullptr);
   }
 
   lv_obj_del(ctx->overlay);
@@ -552,11 +649,8 @@ static void alarm_add_overlay_create(lv_obj_t* parent_screen) {
   lv_obj_t* overlay = lv_obj_create(lv_layer_top());
   lv_obj_set_size(overlay, SCREEN_W, SCREEN_H);
   lv_obj_set_pos(overlay, 0, 0);
-  lv_obj_set_style_bg_color(overlay, lv_color_black(), 0);
+  lv_obj_add_style(overlay, &smc_styles.dim, 0);
   lv_obj_set_style_bg_opa(overlay, LV_OPA_70, 0);
-  lv_obj_set_style_border_width(overlay, 0, 0);
-  lv_obj_set_style_radius(overlay, 0, 0);
-  lv_obj_set_style_pad_all(overlay, 0, 0);
   lv_obj_clear_flag(overlay, LV_OBJ_FLAG_SCROLLABLE);
   lv_obj_add_flag(overlay, LV_OBJ_FLAG_CLICKABLE);
   ctx->overlay = overlay;
@@ -564,17 +658,13 @@ static void alarm_add_overlay_create(lv_obj_t* parent_screen) {
   /* ── Scrollable panel ── */
   const int PANEL_W = 308;
   const int PANEL_H = 224;
-  const int PANEL_PAD = 8;
+  const int PANEL_PAD = 8; /* smc_styles.panel */
   const int PANEL_INNER_W = PANEL_W - 2 * PANEL_PAD;
 
   lv_obj_t* panel = lv_obj_create(overlay);
   lv_obj_set_size(panel, PANEL_W, PANEL_H);
   lv_obj_align(panel, LV_ALIGN_CENTER, 0, 0);
-  lv_obj_set_style_bg_color(panel, col(22, 22, 45), 0);
-  lv_obj_set_style_border_color(panel, col(90, 90, 150), 0);
-  lv_obj_set_style_border_width(panel, 1, 0);
-  lv_obj_set_style_radius(panel, 12, 0);
-  lv_obj_set_style_pad_all(panel, PANEL_PAD, 0);
+  lv_obj_add_style(panel, &smc_styles.panel, 0);
   lv_obj_add_flag(panel, LV_OBJ_FLAG_SCROLLABLE);
   lv_obj_set_scroll_dir(panel, LV_DIR_VER);
   lv_obj_set_scrollbar_mode(panel, LV_SCROLLBAR_MODE_ACTIVE);
@@ -589,8 +679,7 @@ static void alarm_add_overlay_create(lv_obj_t* parent_screen) {
   /* Title */
   lv_obj_t* title = lv_label_create(panel);
   lv_label_set_text(title, "New Alarm");
-  lv_obj_set_style_text_color(title, lv_color_white(), 0);
-  lv_obj_set_style_text_font(title, &lv_font_montserrat_14, 0);
+  lv_obj_add_style(title, &smc_styles.text_big, 0);
   lv_obj_set_pos(title, 0, y);
   y += 22;
 
@@ -598,8 +687,7 @@ static void alarm_add_overlay_create(lv_obj_t* parent_screen) {
   auto sec = [&](const char* txt) {
     lv_obj_t* l = lv_label_create(panel);
     lv_label_set_text(l, txt);
-    lv_obj_set_style_text_color(l, col(150, 150, 200), 0);
-    lv_obj_set_style_text_font(l, &lv_font_montserrat_10, 0);
+    lv_obj_add_style(l, &smc_styles.text_section, 0);
     lv_obj_set_pos(l, 0, y);
     y += 14;
   };
@@ -612,12 +700,7 @@ static void alarm_add_overlay_create(lv_obj_t* parent_screen) {
     lv_textarea_set_placeholder_text(ta, placeholder);
     lv_obj_set_size(ta, PANEL_INNER_W, multiline ? 44 : 28);
     lv_obj_set_pos(ta, 0, y);
-    lv_obj_set_style_bg_color(ta, col(35, 35, 60), 0);
-    lv_obj_set_style_text_color(ta, lv_color_white(), 0);
-    lv_obj_set_style_text_font(ta, &lv_font_montserrat_12, 0);
-    lv_obj_set_style_border_color(ta, col(80, 80, 140), 0);
-    lv_obj_set_style_border_width(ta, 1, 0);
-    lv_obj_set_style_radius(ta, 6, 0);
+    lv_obj_add_style(ta, &smc_styles.textarea, 0);
     /* Tap → fullscreen keyboard */
     lv_obj_add_event_cb(ta, ta_clicked_cb, LV_EVENT_CLICKED, nullptr);
     y += (multiline ? 44 : 28) + 4;
@@ -639,9 +722,7 @@ static void alarm_add_overlay_create(lv_obj_t* parent_screen) {
   const int CLOCK_SECT_H = CLOCK_CANVAS_SIZE + 20 + 26 + 26 + 30;
   lv_obj_set_size(clock_cont, PANEL_INNER_W, CLOCK_SECT_H);
   lv_obj_set_pos(clock_cont, 0, y);
-  lv_obj_set_style_bg_opa(clock_cont, LV_OPA_TRANSP, 0);
-  lv_obj_set_style_border_width(clock_cont, 0, 0);
-  lv_obj_set_style_pad_all(clock_cont, 0, 0);
+  lv_obj_add_style(clock_cont, &smc_styles.transp, 0);
   lv_obj_clear_flag(clock_cont, LV_OBJ_FLAG_SCROLLABLE);
   ctx->clock_ctx = clock_widget_create(clock_cont, PANEL_INNER_W);
   y += CLOCK_SECT_H + 4;
@@ -651,9 +732,7 @@ static void alarm_add_overlay_create(lv_obj_t* parent_screen) {
   lv_obj_t* days_row = lv_obj_create(panel);
   lv_obj_set_size(days_row, PANEL_INNER_W, 30);
   lv_obj_set_pos(days_row, 0, y);
-  lv_obj_set_style_bg_opa(days_row, LV_OPA_TRANSP, 0);
-  lv_obj_set_style_border_width(days_row, 0, 0);
-  lv_obj_set_style_pad_all(days_row, 0, 0);
+  lv_obj_add_style(days_row, &smc_styles.transp, 0);
   lv_obj_set_flex_flow(days_row, LV_FLEX_FLOW_ROW);
   lv_obj_set_flex_align(days_row, LV_FLEX_ALIGN_SPACE_BETWEEN,
                         LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
@@ -662,33 +741,31 @@ static void alarm_add_overlay_create(lv_obj_t* parent_screen) {
   for (int d = 0; d < DAY_COUNT; d++) {
     lv_obj_t* db = lv_btn_create(days_row);
     lv_obj_set_size(db, 36, 26);
-    lv_obj_set_style_bg_color(db, col(45, 45, 72), 0);
-    lv_obj_set_style_bg_color(db, col(55, 85, 210), LV_STATE_CHECKED);
-    lv_obj_set_style_radius(db, 5, 0);
-    lv_obj_set_style_border_width(db, 0, 0);
-    lv_obj_set_style_pad_all(db, 0, 0);
+    lv_obj_add_style(db, &smc_styles.btn_day, 0);
+    lv_obj_add_style(db, &smc_styles.btn_day_checked, LV_STATE_CHECKED);
     lv_obj_add_flag(db, LV_OBJ_FLAG_CHECKABLE);
     lv_obj_t* dl = lv_label_create(db);
     lv_label_set_text(dl, DAY_NAMES[d]);
-    lv_obj_set_style_text_color(dl, lv_color_white(), 0);
-    lv_obj_set_style_text_font(dl, &lv_font_montserrat_10, 0);
+    lv_obj_add_style(dl, &smc_styles.text_small, 0);
     lv_obj_center(dl);
     ctx->day_btns[d] = db;
   }
   y += 34;
 
-  /* Calendar */
+  /* Date, the calendar is only made when this is tapped */
   sec("Date");
-  lv_obj_t* cal = lv_calendar_create(panel);
-  lv_obj_set_size(cal, PANEL_INNER_W, 148);
-  lv_obj_set_pos(cal, 0, y);
-  lv_calendar_set_today_date(cal, 2025, 1, 1);
-  lv_calendar_set_showed_date(cal, 2025, 1);
-  lv_obj_set_style_bg_color(cal, col(28, 28, 50), 0);
-  lv_obj_set_style_text_color(cal, lv_color_white(), 0);
-  lv_calendar_header_arrow_create(cal);
-  ctx->calendar = cal;
-  y += 152;
+  lv_obj_t* date_btn = lv_btn_create(panel);
+  lv_obj_set_size(date_btn, PANEL_INNER_W, 28);
+  lv_obj_set_pos(date_btn, 0, y);
+  lv_obj_add_style(date_btn, &smc_styles.textarea, 0);
+  lv_obj_add_event_cb(date_btn, date_btn_cb, LV_EVENT_CLICKED, ctx);
+
+  ctx->date_lbl = lv_label_create(date_btn);
+  lv_obj_add_style(ctx->date_lbl, &smc_styles.text, 0);
+  lv_obj_align(ctx->date_lbl, LV_ALIGN_LEFT_MID, 0, 0);
+  ctx->date = {2025, 1, 1};
+  date_label_update(ctx);
+  y += 32;
 
   /* Confirm / Cancel */
   int half = (PANEL_INNER_W - 6) / 2;
@@ -696,118 +773,143 @@ static void alarm_add_overlay_create(lv_obj_t* parent_screen) {
   lv_obj_t* confirm = lv_btn_create(panel);
   lv_obj_set_size(confirm, half, 34);
   lv_obj_set_pos(confirm, 0, y);
-  lv_obj_set_style_bg_color(confirm, col(45, 160, 75), 0);
-  lv_obj_set_style_bg_color(confirm, col(65, 190, 95), LV_STATE_PRESSED);
-  lv_obj_set_style_radius(confirm, 8, 0);
-  lv_obj_set_style_border_width(confirm, 0, 0);
+  lv_obj_add_style(confirm, &smc_styles.btn, 0);
+  lv_obj_add_style(confirm, &smc_styles.btn_ok, 0);
+  lv_obj_add_style(confirm, &smc_styles.btn_ok_pressed, LV_STATE_PRESSED);
   lv_obj_add_event_cb(confirm, add_alarm_confirm_cb, LV_EVENT_CLICKED, ctx);
 
   lv_obj_t* clbl = lv_label_create(confirm);
   lv_label_set_text(clbl, LV_SYMBOL_OK "  Add");
-  lv_obj_set_style_text_color(clbl, lv_color_white(), 0);
-  lv_obj_set_style_text_font(clbl, &lv_font_montserrat_12, 0);
+  lv_obj_add_style(clbl, &smc_styles.text, 0);
   lv_obj_center(clbl);
 
   lv_obj_t* cancel = lv_btn_create(panel);
   lv_obj_set_size(cancel, half, 34);
   lv_obj_set_pos(cancel, half + 6, y);
-  lv_obj_set_style_bg_color(cancel, col(160, 45, 45), 0);
-  lv_obj_set_style_bg_color(cancel, col(190, 65, 65), LV_STATE_PRESSED);
-  lv_obj_set_style_radius(cancel, 8, 0);
-  lv_obj_set_style_border_width(cancel, 0, 0);
+  lv_obj_add_style(cancel, &smc_styles.btn, 0);
+  lv_obj_add_style(cancel, &smc_styles.btn_cancel, 0);
+  lv_obj_add_style(cancel, &smc_styles.btn_cancel_pressed, LV_STATE_PRESSED);
   lv_obj_add_event_cb(cancel, add_alarm_cancel_cb, LV_EVENT_CLICKED, ctx);
 
   lv_obj_t* xlbl = lv_label_create(cancel);
   lv_label_set_text(xlbl, LV_SYMBOL_CLOSE "  Cancel");
-  lv_obj_set_style_text_color(xlbl, lv_color_white(), 0);
-  lv_obj_set_style_text_font(xlbl, &lv_font_montserrat_12, 0);
+  lv_obj_add_style(xlbl, &smc_styles.text, 0);
   lv_obj_center(xlbl);
 }
 
-/* ─── Alarm list rebuild ──────────────────────────────────────────── */
-static void alarm_list_rebuild(void) {
-  if (!alarm_list_container)
-    return;
-  lv_obj_clean(alarm_list_container);
-
-  if (alarm_count == 0) {
-    lv_obj_t* empty = lv_label_create(alarm_list_container);
-    lv_label_set_text(empty, "No alarms.\nTap  +  to add one.");
-    lv_obj_set_style_text_color(empty, col(130, 130, 165), 0);
-    lv_obj_set_style_text_font(empty, &lv_font_montserrat_12, 0);
-    lv_obj_set_style_text_align(empty, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_center(empty);
+/* ─── Alarm list ──────────────────────────────────────────────────── */
+#define ALARM_ROW_H 50
+#define ALARM_ROW_GAP 4
+
+/* Child order of a row, see alarm_row_create() */
+enum { ROW_ICON, ROW_NAME, ROW_DESC, ROW_DAYS, ROW_TIME };
+
+static lv_obj_t* row_label(lv_obj_t* row, lv_style_t* style) {
+  lv_obj_t* l = lv_label_create(row);
+  lv_obj_add_style(l, style, 0);
+  return l;
+}
+
+/* Changing a label's text redraws it, even to the same text */
+static void row_label_set(lv_obj_t* label, const char* text) {
+  if (strcmp(lv_label_get_text(label), text) != 0)
+    lv_label_set_text(label, text);
+}
+
+static void alarm_row_create(lv_obj_t* row, void*) {
+  lv_obj_add_style(row, &smc_styles.row, 0);
+  lv_obj_clear_flag(row, LV_OBJ_FLAG_SCROLLABLE);
+
+  lv_obj_t* icon = row_label(row, &smc_styles.row_icon);
+  lv_label_set_text(icon, LV_SYMBOL_BELL);
+  lv_obj_align(icon, LV_ALIGN_LEFT_MID, 2, 0);
+
+  lv_obj_t* name_l = row_label(row, &smc_styles.text);
+  lv_label_set_long_mode(name_l, LV_LABEL_LONG_CLIP);
+  lv_obj_set_size(name_l, 140, 16);
+  lv_obj_align(name_l, LV_ALIGN_TOP_LEFT, 26, 0);
+
+  lv_obj_t* desc_l = row_label(row, &smc_styles.row_desc);
+  lv_label_set_long_mode(desc_l, LV_LABEL_LONG_CLIP);
+  lv_obj_set_size(desc_l, 140, 14);
+  lv_obj_align(desc_l, LV_ALIGN_BOTTOM_LEFT, 26, 0);
+
+  /* Under the time, the description has the bottom left */
+  lv_obj_t* days_l = row_label(row, &smc_styles.row_days);
+  lv_obj_align(days_l, LV_ALIGN_BOTTOM_RIGHT, -4, 0);
+
+  lv_obj_t* time_l = row_label(row, &smc_styles.row_time);
+  lv_obj_align(time_l, LV_ALIGN_TOP_RIGHT, -4, -2);
+}
+
+static void alarm_row_bind(lv_obj_t* row, int idx, void*) {
+  Alarm a;
+  if (alarm_store->get(alarm_slots[idx], &a) != 0)
     return;
-  }
 
-  for (int i = 0; i < alarm_count; i++) {
-    const AlarmEntry& a = alarm_list[i];
-
-    lv_obj_t* row = lv_obj_create(alarm_list_container);
-    lv_obj_set_size(row, lv_pct(100), 50);
-    lv_obj_set_style_bg_color(row, col(35, 35, 60), 0);
-    lv_obj_set_style_radius(row, 8, 0);
-    lv_obj_set_style_border_width(row, 0, 0);
-    lv_obj_set_style_pad_all(row, 6, 0);
-    lv_obj_clear_flag(row, LV_OBJ_FLAG_SCROLLABLE);
-
-    /* Icon */
-    lv_obj_t* icon = lv_label_create(row);
-    lv_label_set_text(icon, LV_SYMBOL_BELL);
-    lv_obj_set_style_text_color(icon, col(100, 180, 255), 0);
-    lv_obj_set_style_text_font(icon, &lv_font_montserrat_14, 0);
-    lv_obj_align(icon, LV_ALIGN_LEFT_MID, 2, 0);
-
-    /* Name */
-    lv_obj_t* name_l = lv_label_create(row);
-    lv_label_set_text(name_l, a.name[0] ? a.name : "(unnamed)");
-    lv_obj_set_style_text_color(name_l, lv_color_white(), 0);
-    lv_obj_set_style_text_font(name_l, &lv_font_montserrat_12, 0);
-    lv_label_set_long_mode(name_l, LV_LABEL_LONG_CLIP);
-    lv_obj_set_size(name_l, 140, 16);
-    lv_obj_align(name_l, LV_ALIGN_TOP_LEFT, 26, 4);
-
-    /* Description */
-    if (a.desc[0]) {
-      lv_obj_t* desc_l = lv_label_create(row);
-      lv_label_set_text(desc_l, a.desc);
-      lv_obj_set_style_text_color(desc_l, col(155, 155, 185), 0);
-      lv_obj_set_style_text_font(desc_l, &lv_font_montserrat_10, 0);
-      lv_label_set_long_mode(desc_l, LV_LABEL_LONG_CLIP);
-      lv_obj_set_size(desc_l, 140, 14);
-      lv_obj_align(desc_l, LV_ALIGN_TOP_LEFT, 26, 22);
-    }
+  row_label_set(lv_obj_get_child(row, ROW_NAME), a.name);
+  row_label_set(lv_obj_get_child(row, ROW_DESC), a.description);
 
-    /* Days */
-    char day_str[20] = {};
-    bool any = false;
-    for (int d = 0; d < DAY_COUNT; d++) {
-      if (a.days[d]) {
-        if (any)
-          strcat(day_str, " ");
-        strcat(day_str, DAY_NAMES[d]);
-        any = true;
-      }
+  char day_str[24] = {};
+  for (int d = 0; d < DAY_COUNT; d++) {
+    if (a.days & (SUNDAY >> d)) {
+      if (day_str[0])
+        strcat(day_str, " ");
+      strcat(day_str, DAY_NAMES[d]);
     }
-    if (!any)
-      strcpy(day_str, "Once");
-
-    lv_obj_t* days_l = lv_label_create(row);
-    lv_label_set_text(days_l, day_str);
-    lv_obj_set_style_text_color(days_l, col(115, 115, 155), 0);
-    lv_obj_set_style_text_font(days_l, &lv_font_montserrat_10, 0);
-    lv_obj_align(days_l, LV_ALIGN_BOTTOM_LEFT, 26, -4);
-
-    /* Time */
-    char time_str[12];
-    snprintf(time_str, sizeof(time_str), "%d:%02d %s", a.hour, a.minute,
-             a.is_pm ? "PM" : "AM");
-    lv_obj_t* time_l = lv_label_create(row);
-    lv_label_set_text(time_l, time_str);
-    lv_obj_set_style_text_color(time_l, col(80, 210, 140), 0);
-    lv_obj_set_style_text_font(time_l, &lv_font_montserrat_14, 0);
-    lv_obj_align(time_l, LV_ALIGN_RIGHT_MID, -4, 0);
   }
+  row_label_set(lv_obj_get_child(row, ROW_DAYS), day_str);
+
+  int h = a.secondMark / 3600 % 24;
+  char time_str[12];
+  snprintf(time_str, sizeof(time_str), "%d:%02d %s", h % 12 == 0 ? 12 : h % 12,
+           a.secondMark / 60 % 60, h >= 12 ? "PM" : "AM");
+  row_label_set(lv_obj_get_child(row, ROW_TIME), time_str);
+}
+
+/* Rebinds the rows of the dirty slots, or all of them if alarms came or went
+ * and the rows moved */
+static void alarm_list_refresh(uint32_t dirty) {
+  int old_slots[MAX_ALARMS];
+  int old_count = alarm_slot_count;
+  memcpy(old_slots, alarm_slots, sizeof(alarm_slots));
+
+  alarm_slot_count = 0;
+  for (int i = 0; i < MAX_ALARMS; i++)
+    if (alarm_store->get(i, nullptr) == 0)
+      alarm_slots[alarm_slot_count++] = i;
+
+  if (!alarm_vlist)
+    return;
+
+  if (alarm_slot_count != old_count ||
+      memcmp(old_slots, alarm_slots, alarm_slot_count * sizeof(int)) != 0) {
+    if (vlist_get_count(alarm_vlist) != alarm_slot_count)
+      vlist_set_count(alarm_vlist, alarm_slot_count);
+    vlist_update(alarm_vlist, -1);
+  } else {
+    for (int i = 0; i < alarm_slot_count; i++)
+      if (dirty & (1u << alarm_slots[i]))
+        vlist_update(alarm_vlist, i);
+  }
+
+  if (alarm_slot_count == 0)
+    lv_obj_remove_flag(alarm_list_empty, LV_OBJ_FLAG_HIDDEN);
+  else
+    lv_obj_add_flag(alarm_list_empty, LV_OBJ_FLAG_HIDDEN);
+}
+
+/* Runs on whatever task changed the store, so it only marks the slot and
+ * homescreen_alarms_sync() patches the row on the LVGL one */
+static void alarm_store_cb(int idx, void*) {
+  uint32_t bits = idx < 0 ? UINT32_MAX : 1u << idx;
+  __atomic_fetch_or(&alarm_dirty, bits, __ATOMIC_RELAXED);
+}
+
+void homescreen_alarms_sync(void) {
+  uint32_t dirty = __atomic_exchange_n(&alarm_dirty, 0, __ATOMIC_RELAXED);
+  if (dirty != 0)
+    alarm_list_refresh(dirty);
 }
 
 /* ─── Add button callback ─────────────────────────────────────────── */
@@ -820,155 +922,310 @@ static void alarm_add_btn_cb(lv_event_t* e) {
 
 /* ─── Alarm open/close ────────────────────────────────────────────── */
 static void open_alarms(lv_obj_t* content) {
-  lv_obj_set_style_pad_all(content, 0, 0);
-
   /* Header bar */
   lv_obj_t* hdr = lv_obj_create(content);
   lv_obj_set_size(hdr, lv_pct(100), 30);
   lv_obj_align(hdr, LV_ALIGN_TOP_LEFT, 0, 0);
-  lv_obj_set_style_bg_color(hdr, col(25, 25, 50), 0);
-  lv_obj_set_style_border_width(hdr, 0, 0);
-  lv_obj_set_style_radius(hdr, 0, 0);
-  lv_obj_set_style_pad_all(hdr, 4, 0);
+  lv_obj_add_style(hdr, &smc_styles.header, 0);
   lv_obj_clear_flag(hdr, LV_OBJ_FLAG_SCROLLABLE);
 
   lv_obj_t* hdr_lbl = lv_label_create(hdr);
   lv_label_set_text(hdr_lbl, LV_SYMBOL_BELL "  Alarms");
-  lv_obj_set_style_text_color(hdr_lbl, lv_color_white(), 0);
-  lv_obj_set_style_text_font(hdr_lbl, &lv_font_montserrat_12, 0);
+  lv_obj_add_style(hdr_lbl, &smc_styles.text, 0);
   lv_obj_align(hdr_lbl, LV_ALIGN_LEFT_MID, 4, 0);
 
   lv_obj_t* add_btn = lv_btn_create(hdr);
   lv_obj_set_size(add_btn, 52, 22);
   lv_obj_align(add_btn, LV_ALIGN_RIGHT_MID, -2, 0);
-  lv_obj_set_style_bg_color(add_btn, col(45, 160, 75), 0);
-  lv_obj_set_style_bg_color(add_btn, col(65, 190, 95), LV_STATE_PRESSED);
-  lv_obj_set_style_radius(add_btn, 6, 0);
-  lv_obj_set_style_border_width(add_btn, 0, 0);
-  lv_obj_set_style_pad_all(add_btn, 0, 0);
+  lv_obj_add_style(add_btn, &smc_styles.btn, 0);
+  lv_obj_add_style(add_btn, &smc_styles.btn_small, 0);
+  lv_obj_add_style(add_btn, &smc_styles.btn_ok, 0);
+  lv_obj_add_style(add_btn, &smc_styles.btn_ok_pressed, LV_STATE_PRESSED);
 
   lv_obj_t* add_lbl = lv_label_create(add_btn);
   lv_label_set_text(add_lbl, LV_SYMBOL_PLUS " Add");
-  lv_obj_set_style_text_color(add_lbl, lv_color_white(), 0);
-  lv_obj_set_style_text_font(add_lbl, &lv_font_montserrat_12, 0);
+  lv_obj_add_style(add_lbl, &smc_styles.text, 0);
   lv_obj_center(add_lbl);
 
   lv_obj_add_event_cb(add_btn, alarm_add_btn_cb, LV_EVENT_CLICKED, nullptr);
 
-  /* Scrollable list */
-  lv_obj_t* list = lv_obj_create(content);
+  /* Scrollable list, content was only just created so lay it out first */
+  lv_obj_update_layout(content);
+  alarm_vlist = vlist_create(content, ALARM_ROW_H, ALARM_ROW_GAP,
+                             alarm_row_create, alarm_row_bind, nullptr);
+  lv_obj_t* list = vlist_get_obj(alarm_vlist);
   lv_obj_set_size(list, lv_pct(100), lv_obj_get_height(content) - 30);
   lv_obj_align(list, LV_ALIGN_TOP_LEFT, 0, 30);
-  lv_obj_set_style_bg_opa(list, LV_OPA_TRANSP, 0);
-  lv_obj_set_style_border_width(list, 0, 0);
+  lv_obj_add_style(list, &smc_styles.transp, 0);
   lv_obj_set_style_pad_all(list, 2, 0);
-  lv_obj_set_style_pad_row(list, 4, 0);
-  lv_obj_set_flex_flow(list, LV_FLEX_FLOW_COLUMN);
-  lv_obj_add_flag(list, LV_OBJ_FLAG_SCROLLABLE);
-  lv_obj_set_scroll_dir(list, LV_DIR_VER);
 
-  alarm_list_container = list;
-  alarm_list_rebuild();
+  alarm_list_empty = lv_label_create(content);
+  lv_label_set_text(alarm_list_empty, "No alarms yet");
+  lv_obj_add_style(alarm_list_empty, &smc_styles.text_empty, 0);
+  lv_obj_align(alarm_list_empty, LV_ALIGN_CENTER, 0, 15);
+
+  alarm_list_refresh(UINT32_MAX);
 }
 
 static void close_alarms(lv_obj_t*) {
-  alarm_list_container = nullptr;
+  alarm_vlist = nullptr;
+  alarm_list_empty = nullptr;
   LV_LOG_USER("Alarms closed");
 }
 
 /* ═══════════════════════════════════════════════════════════════════
  * NAVIGATION
  * ═══════════════════════════════════════════════════════════════════ */
-struct AppScreenCtx {
-  const AppInfo* app;
-  lv_obj_t* home_screen;
+#define APP_COUNT (sizeof(apps) / sizeof(apps[0]))
+
+static lv_obj_t* home_screen = nullptr;
+static lv_obj_t* app_screens[APP_COUNT]; /* By index in apps[] */
+static uint32_t app_screen_opened[APP_COUNT];
+static uint32_t app_screen_opens = 0;
+
+/* A screen sliding in by scrolling the panel's memory, see screen_slide() */
+struct ScreenSlide {
+  lv_obj_t* scr; /* nullptr unless sliding */
+  bool from_right;
+  int32_t shown;    /* Columns of scr in view */
+  int32_t drawing;  /* shown as of the frame being drawn */
+  int32_t scrolled; /* shown as of the panel's scroll */
 };
+static ScreenSlide slide;
+
+/* The columns of scr in view, where they are on scr. */
+static void slide_shown_area(int32_t shown, lv_area_t* area) {
+  area->y1 = 0;
+  area->y2 = SCREEN_H - 1;
+  area->x1 = slide.from_right ? 0 : SCREEN_W - shown;
+  area->x2 = slide.from_right ? shown - 1 : SCREEN_W - 1;
+}
+
+static void slide_anim_cb(void*, int32_t shown) {
+  if (shown <= slide.shown)
+    return;
+  lv_area_t area;
+  slide_shown_area(shown, &area);
+  if (slide.from_right)
+    area.x1 = slide.shown;
+  else
+    area.x2 = SCREEN_W - slide.shown - 1;
+  slide.shown = shown;
+  lv_obj_invalidate_area(slide.scr, &area);
+}
+
+/* Ends the slide at once, leaving the memory as it is on the display. */
+static void slide_stop(void) {
+  lv_anim_delete(&slide, slide_anim_cb);
+  slide.scr = nullptr;
+  if (slide.scrolled != 0)
+    smc_display_scroll(0);
+  slide.scrolled = 0;
+}
+
+static void slide_display_event_cb(lv_event_t* e) {
+  if (slide.scr == nullptr)
+    return;
+  if (slide.scr != lv_screen_active()) {
+    /* Another screen was loaded, it is drawn in full */
+    slide_stop();
+    return;
+  }
+
+  switch (lv_event_get_code(e)) {
+    case LV_EVENT_INVALIDATE_AREA: {
+      /* The rest is drawn when it comes into view. With nothing in view,
+       * the newest column stands in, it is already invalidated or drawn. */
+      auto* area = static_cast<lv_area_t*>(lv_event_get_param(e));
+      lv_area_t shown;
+      slide_shown_area(slide.shown, &shown);
+      area->x1 = LV_MAX(area->x1, shown.x1);
+      area->x2 = LV_MIN(area->x2, shown.x2);
+      if (area->x1 > area->x2) {
+        area->x1 = area->x2 = slide.from_right ? shown.x2 : shown.x1;
+        area->y2 = area->y1;
+      }
+      break;
+    }
+    case LV_EVENT_REFR_START:
+      slide.drawing = slide.shown;
+      break;
+    case LV_EVENT_REFR_READY:
+      /* Flushed, so the new columns can come into view */
+      if (slide.drawing == slide.scrolled)
+        break;
+      smc_display_scroll(slide.from_right ? -slide.drawing : slide.drawing);
+      slide.scrolled = slide.drawing;
+      if (slide.drawing == SCREEN_W) {
+        slide.scr = nullptr;
+        slide.scrolled = 0;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+/* Slides scr in from the right or from the left, as LV_SCR_LOAD_ANIM_MOVE_*
+ * would, but every frame draws and flushes only the columns of scr coming
+ * into view, where they are on scr, and smc_display_scroll() moves the rest
+ * along. After SCREEN_W columns the panel holds scr as drawn and is scrolled
+ * back to 0. Anything else invalidated on scr meanwhile is clipped to the
+ * columns in view.
+ *
+ * Without the scroll, or while another slide is on, LVGL slides the screens
+ * and redraws all of them every frame. */
+static void screen_slide(lv_obj_t* scr, bool from_right) {
+  if (scr == lv_screen_active())
+    return;
+
+  lv_display_t* disp = lv_display_get_default();
+  static bool registered = false;
+  if (!registered) {
+    lv_display_add_event_cb(disp, slide_display_event_cb,
+                            LV_EVENT_INVALIDATE_AREA, nullptr);
+    lv_display_add_event_cb(disp, slide_display_event_cb, LV_EVENT_REFR_START,
+                            nullptr);
+    lv_display_add_event_cb(disp, slide_display_event_cb, LV_EVENT_REFR_READY,
+                            nullptr);
+    registered = true;
+  }
+
+  bool sliding = slide.scr != nullptr;
+  if (sliding)
+    slide_stop();
+  if (sliding || lv_display_get_screen_loading(nullptr) != nullptr ||
+      smc_display_scroll(0) != 0) {
+    lv_scr_load_anim(scr,
+                     from_right ? LV_SCR_LOAD_ANIM_MOVE_LEFT
+                                : LV_SCR_LOAD_ANIM_MOVE_RIGHT,
+                     TRANSITION_MS, 0, false);
+    return;
+  }
+
+  /* What is left to draw on the old screen, e.g. the button just released,
+   * would be drawn from scr otherwise. Nothing of scr is in view yet. */
+  lv_refr_now(disp);
+  lv_display_enable_invalidation(disp, false);
+  lv_screen_load(scr);
+  lv_display_enable_invalidation(disp, true);
+
+  slide.scr = scr;
+  slide.from_right = from_right;
+  slide.shown = 0;
+  slide.drawing = 0;
+  slide.scrolled = 0;
+  /* A column in view from the start, see slide_display_event_cb() */
+  slide_anim_cb(&slide, 1);
+
+  lv_anim_t a;
+  lv_anim_init(&a);
+  lv_anim_set_var(&a, &slide);
+  lv_anim_set_exec_cb(&a, slide_anim_cb);
+  lv_anim_set_values(&a, 1, SCREEN_W);
+  lv_anim_set_duration(&a, TRANSITION_MS);
+  lv_anim_start(&a);
+}
 
 static void back_btn_event_cb(lv_event_t* e) {
   if (lv_event_get_code(e) != LV_EVENT_CLICKED)
     return;
-  auto* ctx = static_cast<AppScreenCtx*>(lv_event_get_user_data(e));
-  lv_obj_t* content = lv_obj_get_child(lv_scr_act(), 1);
-  if (ctx->app->on_close)
-    ctx->app->on_close(content);
-  lv_scr_load_anim(ctx->home_screen, LV_SCR_LOAD_ANIM_MOVE_RIGHT, TRANSITION_MS,
-                   0, false);
+  screen_slide(home_screen, false);
+}
+
+static void app_screen_delete_cb(lv_event_t* e) {
+  auto* app = static_cast<const AppInfo*>(lv_event_get_user_data(e));
+  lv_obj_t* scr = (lv_obj_t*)lv_event_get_current_target(e);
+  if (app->on_close)
+    app->on_close(lv_obj_get_child(scr, 1));
+  app_screens[app - apps] = nullptr;
+}
+
+/* Deletes the screen opened longest ago if APP_SCREEN_CACHE are kept, but
+ * never one still on the display or sliding off it. */
+static void app_screens_evict(void) {
+  int kept = 0;
+  int oldest = -1;
+  for (int i = 0; i < (int)APP_COUNT; i++) {
+    lv_obj_t* scr = app_screens[i];
+    if (scr == nullptr)
+      continue;
+    kept++;
+    if (scr == lv_scr_act() || scr == lv_display_get_screen_prev(nullptr) ||
+        scr == lv_display_get_screen_loading(nullptr))
+      continue;
+    if (oldest == -1 || app_screen_opened[i] < app_screen_opened[oldest])
+      oldest = i;
+  }
+
+  if (kept >= APP_SCREEN_CACHE && oldest != -1)
+    lv_obj_delete(app_screens[oldest]);
 }
 
-static void open_app_screen(const AppInfo* app, lv_obj_t* home_screen) {
+static lv_obj_t* app_screen_create(const AppInfo* app) {
   lv_obj_t* app_scr = lv_obj_create(nullptr);
-  lv_obj_set_style_bg_color(app_scr, col(15, 15, 30), 0);
+  lv_obj_add_style(app_scr, &smc_styles.app_screen, 0);
   lv_obj_clear_flag(app_scr, LV_OBJ_FLAG_SCROLLABLE);
 
   const int TOP_BAR_H = 28;
   lv_obj_t* top_bar = lv_obj_create(app_scr);
   lv_obj_set_size(top_bar, SCREEN_W, TOP_BAR_H);
   lv_obj_align(top_bar, LV_ALIGN_TOP_LEFT, 0, 0);
-  lv_obj_set_style_bg_color(top_bar, lv_color_black(), 0);
-  lv_obj_set_style_bg_opa(top_bar, LV_OPA_50, 0);
-  lv_obj_set_style_border_width(top_bar, 0, 0);
-  lv_obj_set_style_radius(top_bar, 0, 0);
-  lv_obj_set_style_pad_all(top_bar, 4, 0);
+  lv_obj_add_style(top_bar, &smc_styles.top_bar, 0);
   lv_obj_clear_flag(top_bar, LV_OBJ_FLAG_SCROLLABLE);
 
   lv_obj_t* back_btn = lv_btn_create(top_bar);
   lv_obj_set_size(back_btn, 60, TOP_BAR_H - 6);
   lv_obj_align(back_btn, LV_ALIGN_LEFT_MID, 0, 0);
-  lv_obj_set_style_bg_color(back_btn, col(70, 70, 120), 0);
-  lv_obj_set_style_radius(back_btn, 6, 0);
-  lv_obj_set_style_border_width(back_btn, 0, 0);
-  lv_obj_set_style_pad_all(back_btn, 0, 0);
+  lv_obj_add_style(back_btn, &smc_styles.btn, 0);
+  lv_obj_add_style(back_btn, &smc_styles.btn_small, 0);
+  lv_obj_add_style(back_btn, &smc_styles.btn_back, 0);
+  lv_obj_add_event_cb(back_btn, back_btn_event_cb, LV_EVENT_CLICKED, nullptr);
 
   lv_obj_t* back_lbl = lv_label_create(back_btn);
   lv_label_set_text(back_lbl, LV_SYMBOL_LEFT " Back");
-  lv_obj_set_style_text_color(back_lbl, lv_color_white(), 0);
-  lv_obj_set_style_text_font(back_lbl, &lv_font_montserrat_10, 0);
+  lv_obj_add_style(back_lbl, &smc_styles.text_small, 0);
   lv_obj_center(back_lbl);
 
   lv_obj_t* title = lv_label_create(top_bar);
   lv_label_set_text(title, app->name);
-  lv_obj_set_style_text_color(title, lv_color_white(), 0);
-  lv_obj_set_style_text_font(title, &lv_font_montserrat_12, 0);
+  lv_obj_add_style(title, &smc_styles.text, 0);
   lv_obj_align(title, LV_ALIGN_CENTER, 0, 0);
 
-  auto* ctx = new AppScreenCtx{app, home_screen};
-  lv_obj_add_event_cb(back_btn, back_btn_event_cb, LV_EVENT_CLICKED, ctx);
-  lv_obj_add_event_cb(
-      app_scr,
-      [](lv_event_t* ev) {
-        delete static_cast<AppScreenCtx*>(lv_event_get_user_data(ev));
-      },
-      LV_EVENT_DELETE, ctx);
-
+  /* Child 1, app_screen_delete_cb() relies on it */
   lv_obj_t* content = lv_obj_create(app_scr);
   lv_obj_set_size(content, SCREEN_W, SCREEN_H - TOP_BAR_H);
   lv_obj_align(content, LV_ALIGN_BOTTOM_LEFT, 0, 0);
-  lv_obj_set_style_bg_opa(content, LV_OPA_TRANSP, 0);
-  lv_obj_set_style_border_width(content, 0, 0);
-  lv_obj_set_style_pad_all(content, 0, 0);
+  lv_obj_add_style(content, &smc_styles.transp, 0);
   lv_obj_clear_flag(content, LV_OBJ_FLAG_SCROLLABLE);
 
   if (app->on_open)
     app->on_open(content);
 
-  lv_scr_load_anim(app_scr, LV_SCR_LOAD_ANIM_MOVE_LEFT, TRANSITION_MS, 0,
-                   false);
+  lv_obj_add_event_cb(app_scr, app_screen_delete_cb, LV_EVENT_DELETE,
+                      (void*)app);
+  return app_scr;
+}
+
+/* Builds the app's screen unless it was kept from the last time. */
+static lv_obj_t* app_screen_get(const AppInfo* app) {
+  int idx = app - apps;
+  if (app_screens[idx] == nullptr) {
+    app_screens_evict();
+    app_screens[idx] = app_screen_create(app);
+  }
+  app_screen_opened[idx] = ++app_screen_opens;
+  return app_screens[idx];
+}
+
+static void open_app_screen(const AppInfo* app) {
+  screen_slide(app_screen_get(app), true);
 }
 
 static void home_btn_event_cb(lv_event_t* e) {
   if (lv_event_get_code(e) != LV_EVENT_CLICKED)
     return;
-  open_app_screen(static_cast<const AppInfo*>(lv_event_get_user_data(e)),
-                  lv_scr_act());
-}
-
-static void btn_press_feedback_cb(lv_event_t* e) {
-  lv_event_code_t code = lv_event_get_code(e);
-  lv_obj_t* btn = (lv_obj_t*)lv_event_get_target(e);
-  if (code == LV_EVENT_PRESSED)
-    lv_obj_set_style_opa(btn, LV_OPA_70, 0);
-  else if (code == LV_EVENT_RELEASED || code == LV_EVENT_PRESS_LOST)
-    lv_obj_set_style_opa(btn, LV_OPA_COVER, 0);
+  open_app_screen(static_cast<const AppInfo*>(lv_event_get_user_data(e)));
 }
 
 static lv_obj_t* create_btn(lv_obj_t* parent, const AppInfo* app, int x, int y,
@@ -976,70 +1233,144 @@ static lv_obj_t* create_btn(lv_obj_t* parent, const AppInfo* app, int x, int y,
   lv_obj_t* btn = lv_obj_create(parent);
   lv_obj_set_size(btn, w, h);
   lv_obj_set_pos(btn, x, y);
-  lv_obj_set_style_bg_color(btn, col(55, 55, 85), 0);
-  lv_obj_set_style_radius(btn, 10, 0);
-  lv_obj_set_style_border_width(btn, 0, 0);
-  lv_obj_set_style_shadow_width(btn, 6, 0);
-  lv_obj_set_style_shadow_opa(btn, LV_OPA_30, 0);
-  lv_obj_set_style_pad_all(btn, 0, 0);
+  lv_obj_add_style(btn, &smc_styles.app_btn, 0);
+  lv_obj_add_style(btn, &smc_styles.app_btn_pressed, LV_STATE_PRESSED);
   lv_obj_add_flag(btn, LV_OBJ_FLAG_CLICKABLE);
   lv_obj_clear_flag(btn, LV_OBJ_FLAG_SCROLLABLE);
 
   lv_obj_t* icon_lbl = lv_label_create(btn);
   lv_label_set_text(icon_lbl, app->icon_label);
-  lv_obj_set_style_text_color(icon_lbl, lv_color_white(), 0);
-  lv_obj_set_style_text_font(icon_lbl, &lv_font_montserrat_14, 0);
+  lv_obj_add_style(icon_lbl, &smc_styles.text_big, 0);
   lv_obj_align(icon_lbl, LV_ALIGN_CENTER, 0, -8);
 
   lv_obj_t* name_lbl = lv_label_create(btn);
   lv_label_set_text(name_lbl, app->name);
-  lv_obj_set_style_text_color(name_lbl, col(190, 190, 210), 0);
-  lv_obj_set_style_text_font(name_lbl, &lv_font_montserrat_10, 0);
+  lv_obj_add_style(name_lbl, &smc_styles.text_app_name, 0);
   lv_label_set_long_mode(name_lbl, LV_LABEL_LONG_CLIP);
   lv_obj_set_width(name_lbl, w - 6);
-  lv_obj_set_style_text_align(name_lbl, LV_TEXT_ALIGN_CENTER, 0);
   lv_obj_align(name_lbl, LV_ALIGN_BOTTOM_MID, 0, -3);
 
   lv_obj_add_event_cb(btn, home_btn_event_cb, LV_EVENT_CLICKED, (void*)app);
-  lv_obj_add_event_cb(btn, btn_press_feedback_cb, LV_EVENT_PRESSED, nullptr);
-  lv_obj_add_event_cb(btn, btn_press_feedback_cb, LV_EVENT_RELEASED, nullptr);
-  lv_obj_add_event_cb(btn, btn_press_feedback_cb, LV_EVENT_PRESS_LOST, nullptr);
   return btn;
 }
 
+/* What the status bar shows, set by homescreen_status_tick(). Each label
+ * observes one of these, LVGL only notifies when the value changed, so a
+ * label is redrawn when what it shows changes and the rest of the bar is not.
+ * The labels have fixed sizes for the same reason, text of another width
+ * would otherwise move them and redraw their old and new place. */
+static lv_subject_t status_clock;   /* Minutes since midnight */
+static lv_subject_t status_wifi;    /* Bars 0-4, 0 when not connected */
+static lv_subject_t status_battery; /* Percent */
+static lv_subject_t status_alarm;   /* Minutes since midnight, -1 if none */
+
+/* The signal in bars rather than dBm, which changes nearly every second */
+static int wifi_bars(int rssi) {
+  if (rssi == 0)
+    return 0;
+  if (rssi >= -55)
+    return 4;
+  if (rssi >= -67)
+    return 3;
+  if (rssi >= -78)
+    return 2;
+  return 1;
+}
+
+void homescreen_status_tick(const struct tm* now, const HomescreenStatus* st) {
+  lv_subject_set_int(&status_clock, now->tm_hour * 60 + now->tm_min);
+  lv_subject_set_int(&status_wifi, wifi_bars(st->rssi));
+  lv_subject_set_int(&status_battery, LV_CLAMP(0, st->battery, 100));
+
+  int alarm = -1;
+  struct tm ring;
+  if (st->next_alarm > 0 && gmtime_r(&st->next_alarm, &ring) != nullptr)
+    alarm = ring.tm_hour * 60 + ring.tm_min;
+  lv_subject_set_int(&status_alarm, alarm);
+}
+
+static void status_clock_cb(lv_observer_t* obs, lv_subject_t* subject) {
+  int v = lv_subject_get_int(subject);
+  lv_label_set_text_fmt(lv_observer_get_target_obj(obs), "%d:%02d", v / 60,
+                        v % 60);
+}
+
+static void status_wifi_cb(lv_observer_t* obs, lv_subject_t* subject) {
+  int bars = lv_subject_get_int(subject);
+  lv_obj_t* lbl = lv_observer_get_target_obj(obs);
+  if (bars == 0)
+    lv_label_set_text(lbl, LV_SYMBOL_WIFI " --");
+  else
+    lv_label_set_text_fmt(lbl, LV_SYMBOL_WIFI " %d%%", bars * 25);
+}
+
+static void status_battery_cb(lv_observer_t* obs, lv_subject_t* subject) {
+  static const char* const LEVELS[] = {
+      LV_SYMBOL_BATTERY_EMPTY, LV_SYMBOL_BATTERY_1, LV_SYMBOL_BATTERY_2,
+      LV_SYMBOL_BATTERY_3, LV_SYMBOL_BATTERY_FULL};
+  int pct = lv_subject_get_int(subject);
+  lv_label_set_text_fmt(lv_observer_get_target_obj(obs), "%s %d%%",
+                        LEVELS[(pct + 12) / 25], pct);
+}
+
+static void status_alarm_cb(lv_observer_t* obs, lv_subject_t* subject) {
+  int v = lv_subject_get_int(subject);
+  lv_obj_t* lbl = lv_observer_get_target_obj(obs);
+  if (v < 0)
+    lv_label_set_text(lbl, "");
+  else
+    lv_label_set_text_fmt(lbl, LV_SYMBOL_BELL " %d:%02d", v / 60, v % 60);
+}
+
+/* A label of width w in the bar at x from align, showing subject with cb */
+static void status_label(lv_obj_t* bar, const lv_style_t* style,
+                         lv_align_t align, int x, int w, lv_subject_t* subject,
+                         lv_observer_cb_t cb) {
+  lv_obj_t* lbl = lv_label_create(bar);
+  lv_obj_add_style(lbl, style, 0);
+  lv_obj_set_width(lbl, w);
+  lv_label_set_long_mode(lbl, LV_LABEL_LONG_CLIP);
+  lv_obj_align(lbl, align, x, 0);
+  lv_subject_add_observer_obj(subject, cb, lbl, nullptr);
+}
+
 static void create_status_bar(lv_obj_t* scr) {
+  lv_subject_init_int(&status_clock, 0);
+  lv_subject_init_int(&status_wifi, 0);
+  lv_subject_init_int(&status_battery, 100);
+  lv_subject_init_int(&status_alarm, -1);
+
   lv_obj_t* bar = lv_obj_create(scr);
   lv_obj_set_size(bar, SCREEN_W, STATUS_BAR_H);
   lv_obj_align(bar, LV_ALIGN_TOP_LEFT, 0, 0);
-  lv_obj_set_style_bg_color(bar, lv_color_black(), 0);
-  lv_obj_set_style_bg_opa(bar, LV_OPA_30, 0);
-  lv_obj_set_style_border_width(bar, 0, 0);
-  lv_obj_set_style_radius(bar, 0, 0);
-  lv_obj_set_style_pad_hor(bar, 6, 0);
-  lv_obj_set_style_pad_ver(bar, 2, 0);
+  lv_obj_add_style(bar, &smc_styles.status_bar, 0);
   lv_obj_clear_flag(bar, LV_OBJ_FLAG_SCROLLABLE);
 
-  lv_obj_t* time_lbl = lv_label_create(bar);
-  lv_label_set_text(time_lbl, "9:41");
-  lv_obj_set_style_text_color(time_lbl, lv_color_white(), 0);
-  lv_obj_set_style_text_font(time_lbl, &lv_font_montserrat_12, 0);
-  lv_obj_align(time_lbl, LV_ALIGN_LEFT_MID, 0, 0);
-
-  lv_obj_t* status_r = lv_label_create(bar);
-  lv_label_set_text(status_r, "WiFi  100%");
-  lv_obj_set_style_text_color(status_r, lv_color_white(), 0);
-  lv_obj_set_style_text_font(status_r, &lv_font_montserrat_10, 0);
-  lv_obj_align(status_r, LV_ALIGN_RIGHT_MID, 0, 0);
+  status_label(bar, &smc_styles.text, LV_ALIGN_LEFT_MID, 0, 40, &status_clock,
+               status_clock_cb);
+
+  /* Right to left: battery, Wi-Fi, next alarm */
+  const lv_style_t* right = &smc_styles.text_status;
+  status_label(bar, right, LV_ALIGN_RIGHT_MID, 0, 44, &status_battery,
+               status_battery_cb);
+  status_label(bar, right, LV_ALIGN_RIGHT_MID, -48, 40, &status_wifi,
+               status_wifi_cb);
+  status_label(bar, right, LV_ALIGN_RIGHT_MID, -92, 44, &status_alarm,
+               status_alarm_cb);
 }
 
 /* ═══════════════════════════════════════════════════════════════════
  * HOME SCREEN
  * ═══════════════════════════════════════════════════════════════════ */
-void homescreen_create(void) {
+void homescreen_create(Alarms* alarms) {
+  smc_style_init();
+
+  alarm_store = alarms;
+  Alarms::subscribe(alarm_store_cb, nullptr);
+
   lv_obj_t* scr = lv_scr_act();
-  lv_obj_set_style_bg_color(scr, col(20, 20, 40), 0);
-  lv_obj_set_style_bg_grad_color(scr, col(55, 18, 75), 0);
-  lv_obj_set_style_bg_grad_dir(scr, LV_GRAD_DIR_VER, 0);
+  home_screen = scr;
+  lv_obj_add_style(scr, &smc_styles.home_screen, 0);
   lv_obj_clear_flag(scr, LV_OBJ_FLAG_SCROLLABLE);
 
   create_status_bar(scr);
@@ -1064,6 +1395,9 @@ void homescreen_create(void) {
   place_row(0, 3, BTN_SMALL_W, BTN_SMALL_H, row0_y);
   place_row(3, 2, BTN_BIG_W, BTN_BIG_H, row1_y);
   place_row(5, 3, BTN_SMALL_W, BTN_SMALL_H, row2_y);
+
+  /* Build the alarms at boot rather than on the first tap */
+  app_screen_get(&apps[APP_ALARMS]);
 }
 
 /* ═══════════════════════════════════════════════════════════════════
@@ -1072,8 +1406,7 @@ void homescreen_create(void) {
 static void stub_screen(lv_obj_t* content, const char* text) {
   lv_obj_t* l = lv_label_create(content);
   lv_label_set_text(l, text);
-  lv_obj_set_style_text_color(l, col(200, 200, 220), 0);
-  lv_obj_set_style_text_font(l, &lv_font_montserrat_12, 0);
+  lv_obj_add_style(l, &smc_styles.text_body, 0);
   lv_obj_center(l);
 }
 
@@ -1 +1,21 @@
-void homescreen_create(void);
+#include <ctime>
+#include "alarm.h"
+
+// Builds the home screen, the alarms app showing and editing alarms.
+void homescreen_create(Alarms* alarms);
+
+// Shows the alarms changed since the last call, by any task, in the alarms
+// app, redrawing only their rows. Call on the LVGL task before
+// lv_timer_handler().
+void homescreen_alarms_sync(void);
+
+// What the status bar shows besides the time.
+struct HomescreenStatus {
+  int rssi;           // dBm, 0 if not connected
+  int battery;        // Percent
+  time_t next_alarm;  // UNIX time GMT+0, 0 or less if there is none
+};
+
+// Updates the status bar, call once a second. Only the labels whose text
+// changes are redrawn.
+void homescreen_status_tick(const struct tm* now, const HomescreenStatus* st);
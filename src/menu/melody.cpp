@@ -0,0 +1,12 @@
+#include "./melody.h"
+
+static const uint8_t MELODY_ALARM_TONES[] = {
+    melody_step(E7, EIGHTH), melody_step(REST, SIXTEENTH),
+    melody_step(E7, EIGHTH), melody_step(REST, SIXTEENTH),
+    melody_step(E7, EIGHTH), melody_step(REST, SIXTEENTH),
+    melody_step(C7, QUARTER), melody_step(G7, QUARTER),
+    melody_step(REST, WHOLE),
+};
+
+const SMC_Melody MELODY_ALARM = {MELODY_ALARM_TONES,
+                                 sizeof(MELODY_ALARM_TONES), 60};
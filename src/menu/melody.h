@@ -0,0 +1,87 @@
+#ifndef SMC_MELODY_H
+#define SMC_MELODY_H
+
+#include <cstddef>
+#include <cstdint>
+
+// A melody is one byte per step: the length in the top 3 bits and the note in
+// the bottom 5, see melody_step(). Steps are played in order and the melody
+// repeats until stopped.
+struct SMC_Melody {
+  const uint8_t* tones;
+  size_t tones_len;
+  uint16_t unit_ms;  // How long a sixteenth is
+};
+
+// Semitones from C6, where piezo buzzers are loud. 0 is silence.
+enum MelodyNote : uint8_t {
+  REST = 0,
+  C6, CS6, D6, DS6, E6, F6, FS6, G6, GS6, A6, AS6, B6,
+  C7, CS7, D7, DS7, E7, F7, FS7, G7, GS7, A7, AS7, B7,
+  C8, CS8, D8, DS8, E8, F8,
+};
+
+enum MelodyLength : uint8_t {
+  SIXTEENTH = 0,
+  EIGHTH,
+  DOTTED_EIGHTH,
+  QUARTER,
+  DOTTED_QUARTER,
+  HALF,
+  DOTTED_HALF,
+  WHOLE,
+};
+
+static const uint16_t MELODY_FREQS[32] = {
+    0,    1047, 1109, 1175, 1245, 1319, 1397, 1480, 1568, 1661, 1760,
+    1865, 1976, 2093, 2217, 2349, 2489, 2637, 2794, 2960, 3136, 3322,
+    3520, 3729, 3951, 4186, 4435, 4699, 4978, 5274, 5588, 0,
+};
+
+// In sixteenths.
+static const uint8_t MELODY_UNITS[8] = {1, 2, 3, 4, 6, 8, 12, 16};
+
+constexpr uint8_t melody_step(MelodyNote note, MelodyLength len) {
+  return (uint8_t)(len << 5 | note);
+}
+
+inline uint16_t melody_step_freq(uint8_t step) {
+  return MELODY_FREQS[step & 0x1F];
+}
+
+inline uint32_t melody_step_ms(uint8_t step, uint16_t unit_ms) {
+  return (uint32_t)MELODY_UNITS[step >> 5] * unit_ms;
+}
+
+// Walks a melody step by step, wrapping around. Shared by the buzzer and the
+// desktop stand-in so both play the same timeline.
+struct MelodyCursor {
+  const SMC_Melody* melody = nullptr;
+  size_t step = 0;
+
+  // Moves to the next step, or the first one if melody changed, and gives its
+  // frequency (0 for silence) and length. Returns false if there is nothing to
+  // play.
+  bool next(const SMC_Melody* to_play, uint16_t* freq, uint32_t* ms) {
+    if (to_play == nullptr || to_play->tones_len == 0) {
+      melody = nullptr;
+      return false;
+    }
+
+    if (to_play != melody) {
+      melody = to_play;
+      step = 0;
+    } else {
+      step = (step + 1) % melody->tones_len;
+    }
+
+    *freq = melody_step_freq(melody->tones[step]);
+    *ms = melody_step_ms(melody->tones[step], melody->unit_ms);
+    return true;
+  }
+};
+
+// What plays while an alarm rings.
+extern const SMC_Melody MELODY_ALARM;
+
+#endif
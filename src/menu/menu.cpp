@@ -3,6 +3,9 @@
 #include "../ui.h"
 #include "./alarm.h"
 #include "./boot_logo.h"
+#ifdef SMC_DRAW_PROFILE
+#include "draw_prof.h"
+#endif
 #include "lvgl_homescreen.h"
 #include "stdlib.h"
 #include "widgets.h"
@@ -27,27 +30,38 @@ static const char* btnm_map[] = {"1",  "2",  "3",       "4",       "67",
                                  "\n", "6",  "7",       "8",       "9",
                                  "0",  "\n", "Action1", "Action2", ""};
 
-static lv_style_t style;
-
-void smc_style_init(void) {
-  lv_style_init(&style);
-
-  lv_style_set_drop_shadow_color(&style, lv_palette_main(LV_PALETTE_RED));
-  lv_style_set_drop_shadow_radius(&style, 16);
-  lv_style_set_drop_shadow_opa(&style, 255);
-  lv_style_set_drop_shadow_offset_x(&style, 5);
-  lv_style_set_drop_shadow_offset_y(&style, 10);
-}
-
 void test_menu(void) {
-  homescreen_create();
-  // smc_style_init();
+  homescreen_create(smc_system_alarms());
+#ifdef SMC_DRAW_PROFILE
+  smc_draw_prof_start(lv_display_get_default());
+#endif
   // lv_obj_t* btnm = lv_buttonmatrix_create(lv_screen_active());
   // lv_buttonmatrix_set_map(btnm, btnm_map);
   // lv_obj_set_size(btnm, lv_pct(100), lv_pct(100));
 }
 
+void smc_internal_tick(const struct tm* now) {
+  HomescreenStatus st;
+  st.rssi = smc_wifi_signal();
+  st.battery = smc_battery_percentage();
+  st.next_alarm = smc_system_alarms()->ring_in(NULL);
+  homescreen_status_tick(now, &st);
+
+#ifdef SMC_DRAW_PROFILE
+  // A report of the last ten seconds of drawing
+  static int ticks = 0;
+  static char report[2048];
+  if (++ticks == 10) {
+    ticks = 0;
+    smc_draw_prof_report(report, sizeof(report));
+    fputs(report, stdout);
+    smc_draw_prof_reset();
+  }
+#endif
+}
+
 void smc_internal_loop(void) {
+  homescreen_alarms_sync();
   lv_subject_set_int(&steps_subject, smc_motor_steps() * 100 / 4096);
   static long alarm_ptr_tk;
   // if (bounce_alt(&alarm_ptr_tk)) {
@@ -57,7 +71,7 @@ void smc_internal_loop(void) {
   Alarms* alarms = smc_system_alarms();
 
   if (alarms->is_ringing() > -1) {
-    smc_alarm_buzzer_play(SMC_Melody{});
+    smc_alarm_buzzer_play(&MELODY_ALARM);
   } else {
     smc_alarm_buzzer_off();
   }
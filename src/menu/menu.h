@@ -1,13 +1,20 @@
 #ifndef SMC_MENU_H
 #define SMC_MENU_H
 
+#include <ctime>
+
 #ifdef SMC_DESKTOP
 #define LVGL_INCLUDE "lvgl/lvgl.h"
+#define LVGL_PRIVATE_INCLUDE "lvgl/lvgl_private.h"
 #else
 #define LVGL_INCLUDE "thirdparty/lvgl/lvgl.h"
+#define LVGL_PRIVATE_INCLUDE "thirdparty/lvgl/lvgl_private.h"
 #endif
 
 void test_menu(void);
 void smc_internal_loop(void);
+// Called once a second with the time in GMT+0, for what only changes that
+// often, e.g. the status bar.
+void smc_internal_tick(const struct tm* now);
 
 #endif
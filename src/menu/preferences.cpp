@@ -1,5 +1,6 @@
 #include "preferences.h"
 #include "../ui.h"
+#include <cassert>
 #include "config.h"
 #include "cstring"
 #include "utils.h"
@@ -12,7 +13,7 @@ int DevicePreferences::setup(void) {
     smc_data_reset();
     smc_device_restart();
   } else if (err < -2) {
-    ESP_LOGE(TAG, "err is %d", err);
+    SMC_LOGE(TAG, "err is %d", err);
     assert(false);
   };
 
@@ -21,13 +22,20 @@ int DevicePreferences::setup(void) {
 
 int DevicePreferences::load_from_fs(void) {
   smc_fs_read(PREFERENCES_PATH, this, sizeof(DevicePreferences));
-  // TODO DEBUG
-  char dump[256 * 3 + 1];
-  int dump_res = hexdump(dump, this, sizeof(DevicePreferences));
-  ESP_LOGD(TAG, "first %d bytes dump of %s: %s", 256, PREFERENCES_PATH, dump);
+#if SMC_LOG_LEVEL >= SMC_LOG_DEBUG
+  // As much as fits a log record's string.
+  char dump[SMC_LOG_STR_MAX + 1];
+  size_t dump_len = sizeof(DevicePreferences);
+  if (dump_len > SMC_LOG_STR_MAX / 3) {
+    dump_len = SMC_LOG_STR_MAX / 3;
+  }
+  int dump_res = hexdump(dump, this, dump_len);
+  SMC_LOGD(TAG, "first %d bytes dump of %s: %s", dump_res, PREFERENCES_PATH,
+           dump);
+#endif
 
   if (version != PREFERENCES_VERSION) {
-    ESP_LOGE(TAG, "unsupported version: %02X", version);
+    SMC_LOGE(TAG, "unsupported version: %02X", version);
     return -3;
   }
 
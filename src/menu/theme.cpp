@@ -0,0 +1,147 @@
+#include "theme.h"
+
+SmcStyles smc_styles;
+
+static void text_style(lv_style_t* style, lv_color_t color,
+                       const lv_font_t* font) {
+  lv_style_init(style);
+  lv_style_set_text_color(style, color);
+  lv_style_set_text_font(style, font);
+}
+
+static void bg_style(lv_style_t* style, lv_color_t color) {
+  lv_style_init(style);
+  lv_style_set_bg_color(style, color);
+}
+
+// Flat background without border, radius or padding.
+static void flat_style(lv_style_t* style, lv_color_t color) {
+  bg_style(style, color);
+  lv_style_set_border_width(style, 0);
+  lv_style_set_radius(style, 0);
+  lv_style_set_pad_all(style, 0);
+}
+
+void smc_style_init(void) {
+  static bool done = false;
+  if (done)
+    return;
+  done = true;
+
+  SmcStyles* s = &smc_styles;
+
+  lv_style_init(&s->transp);
+  lv_style_set_bg_opa(&s->transp, LV_OPA_TRANSP);
+  lv_style_set_border_width(&s->transp, 0);
+  lv_style_set_pad_all(&s->transp, 0);
+
+  flat_style(&s->dim, lv_color_black());
+
+  bg_style(&s->panel, col(22, 22, 45));
+  lv_style_set_border_color(&s->panel, col(90, 90, 150));
+  lv_style_set_border_width(&s->panel, 1);
+  lv_style_set_radius(&s->panel, 12);
+  lv_style_set_pad_all(&s->panel, 8);
+
+  flat_style(&s->divider, col(100, 100, 160));
+
+  bg_style(&s->home_screen, col(20, 20, 40));
+  lv_style_set_bg_grad_color(&s->home_screen, col(55, 18, 75));
+  lv_style_set_bg_grad_dir(&s->home_screen, LV_GRAD_DIR_VER);
+
+  bg_style(&s->app_screen, col(15, 15, 30));
+
+  flat_style(&s->status_bar, lv_color_black());
+  lv_style_set_bg_opa(&s->status_bar, LV_OPA_30);
+  lv_style_set_pad_hor(&s->status_bar, 6);
+  lv_style_set_pad_ver(&s->status_bar, 2);
+
+  flat_style(&s->top_bar, lv_color_black());
+  lv_style_set_bg_opa(&s->top_bar, LV_OPA_50);
+  lv_style_set_pad_all(&s->top_bar, 4);
+
+  flat_style(&s->header, col(25, 25, 50));
+  lv_style_set_pad_all(&s->header, 4);
+
+  lv_style_init(&s->btn);
+  lv_style_set_radius(&s->btn, 8);
+  lv_style_set_border_width(&s->btn, 0);
+
+  lv_style_init(&s->btn_small);
+  lv_style_set_radius(&s->btn_small, 6);
+  lv_style_set_pad_all(&s->btn_small, 0);
+
+  bg_style(&s->btn_ok, col(45, 160, 75));
+  bg_style(&s->btn_ok_pressed, col(65, 190, 95));
+  bg_style(&s->btn_cancel, col(160, 45, 45));
+  bg_style(&s->btn_cancel_pressed, col(190, 65, 65));
+  bg_style(&s->btn_primary, col(70, 70, 180));
+  bg_style(&s->btn_primary_pressed, col(90, 90, 210));
+  bg_style(&s->btn_back, col(70, 70, 120));
+  bg_style(&s->btn_ampm, col(60, 40, 130));
+  bg_style(&s->btn_ampm_checked, col(140, 40, 80));
+
+  bg_style(&s->btn_day, col(45, 45, 72));
+  lv_style_set_radius(&s->btn_day, 5);
+  lv_style_set_border_width(&s->btn_day, 0);
+  lv_style_set_pad_all(&s->btn_day, 0);
+  bg_style(&s->btn_day_checked, col(55, 85, 210));
+
+  bg_style(&s->app_btn, col(55, 55, 85));
+  lv_style_set_radius(&s->app_btn, 10);
+  lv_style_set_border_width(&s->app_btn, 0);
+  lv_style_set_shadow_width(&s->app_btn, 6);
+  lv_style_set_shadow_opa(&s->app_btn, LV_OPA_30);
+  lv_style_set_pad_all(&s->app_btn, 0);
+  lv_style_init(&s->app_btn_pressed);
+  lv_style_set_opa(&s->app_btn_pressed, LV_OPA_70);
+
+  text_style(&s->text, lv_color_white(), &lv_font_montserrat_12);
+  text_style(&s->text_big, lv_color_white(), &lv_font_montserrat_14);
+  text_style(&s->text_small, lv_color_white(), &lv_font_montserrat_10);
+  text_style(&s->text_body, col(200, 200, 220), &lv_font_montserrat_12);
+  text_style(&s->text_section, col(150, 150, 200), &lv_font_montserrat_10);
+  text_style(&s->text_app_name, col(190, 190, 210), &lv_font_montserrat_10);
+  lv_style_set_text_align(&s->text_app_name, LV_TEXT_ALIGN_CENTER);
+  text_style(&s->text_hour, col(80, 130, 255), &lv_font_montserrat_12);
+  text_style(&s->text_minute, col(60, 200, 110), &lv_font_montserrat_12);
+  text_style(&s->text_empty, col(115, 115, 155), &lv_font_montserrat_12);
+  text_style(&s->text_status, lv_color_white(), &lv_font_montserrat_10);
+  lv_style_set_text_align(&s->text_status, LV_TEXT_ALIGN_RIGHT);
+
+  text_style(&s->textarea, lv_color_white(), &lv_font_montserrat_12);
+  lv_style_set_bg_color(&s->textarea, col(35, 35, 60));
+  lv_style_set_border_color(&s->textarea, col(80, 80, 140));
+  lv_style_set_border_width(&s->textarea, 1);
+  lv_style_set_radius(&s->textarea, 6);
+
+  bg_style(&s->keyboard, col(20, 20, 40));
+  lv_style_set_text_color(&s->keyboard, lv_color_white());
+
+  bg_style(&s->calendar, col(28, 28, 50));
+  lv_style_set_text_color(&s->calendar, lv_color_white());
+
+  bg_style(&s->slider, col(50, 50, 80));
+  lv_style_set_radius(&s->slider, 4);
+  bg_style(&s->slider_hour, col(80, 130, 255));
+  bg_style(&s->slider_minute, col(60, 200, 110));
+  bg_style(&s->slider_knob, lv_color_white());
+
+  lv_style_init(&s->clock_hand_h);
+  lv_style_set_line_color(&s->clock_hand_h, col(80, 130, 255));
+  lv_style_set_line_width(&s->clock_hand_h, 3);
+  lv_style_init(&s->clock_hand_m);
+  lv_style_set_line_color(&s->clock_hand_m, col(60, 200, 110));
+  lv_style_set_line_width(&s->clock_hand_m, 2);
+  flat_style(&s->clock_dot, lv_color_white());
+  lv_style_set_radius(&s->clock_dot, LV_RADIUS_CIRCLE);
+
+  bg_style(&s->row, col(35, 35, 60));
+  lv_style_set_radius(&s->row, 8);
+  lv_style_set_border_width(&s->row, 0);
+  lv_style_set_pad_all(&s->row, 6);
+  text_style(&s->row_icon, col(100, 180, 255), &lv_font_montserrat_14);
+  text_style(&s->row_desc, col(155, 155, 185), &lv_font_montserrat_10);
+  text_style(&s->row_days, col(115, 115, 155), &lv_font_montserrat_10);
+  text_style(&s->row_time, col(80, 210, 140), &lv_font_montserrat_14);
+}
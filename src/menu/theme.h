@@ -0,0 +1,82 @@
+#ifndef SMC_THEME_H
+#define SMC_THEME_H
+
+#include "menu.h"
+#include LVGL_INCLUDE
+
+static inline lv_color_t col(uint8_t r, uint8_t g, uint8_t b) {
+  return lv_color_make(r, g, b);
+}
+
+// The look of the screens. Objects get these with lv_obj_add_style() instead
+// of setting local style properties, which allocate style storage for every
+// object and are looked up separately while rendering. Geometry (sizes,
+// positions) stays on the objects.
+struct SmcStyles {
+  // Containers
+  lv_style_t transp;  // No background, border or padding
+  lv_style_t dim;     // Full screen overlays, bg_opa is set by each
+  lv_style_t panel;   // Dialogs floating on a dim overlay
+  lv_style_t divider;
+  lv_style_t home_screen;
+  lv_style_t app_screen;
+  lv_style_t status_bar;
+  lv_style_t top_bar;
+  lv_style_t header;  // Under the top bar, e.g. "Alarms  [+ Add]"
+
+  // Buttons, btn and one of the colours. The *_pressed and *_checked ones
+  // are added with LV_STATE_PRESSED and LV_STATE_CHECKED.
+  lv_style_t btn;
+  lv_style_t btn_small;  // Radius 6 and no padding, on top of btn
+  lv_style_t btn_ok;
+  lv_style_t btn_ok_pressed;
+  lv_style_t btn_cancel;
+  lv_style_t btn_cancel_pressed;
+  lv_style_t btn_primary;
+  lv_style_t btn_primary_pressed;
+  lv_style_t btn_back;
+  lv_style_t btn_ampm;
+  lv_style_t btn_ampm_checked;  // PM
+  lv_style_t btn_day;           // On its own, not with btn
+  lv_style_t btn_day_checked;
+  lv_style_t app_btn;  // The home screen's, not with btn
+  lv_style_t app_btn_pressed;
+
+  // Text, white unless said otherwise
+  lv_style_t text;        // 12
+  lv_style_t text_big;    // 14
+  lv_style_t text_small;  // 10
+  lv_style_t text_body;   // Light grey 12
+  lv_style_t text_section;
+  lv_style_t text_app_name;
+  lv_style_t text_hour;
+  lv_style_t text_minute;
+  lv_style_t text_empty;
+  lv_style_t text_status;  // 10, right aligned
+
+  // Widgets
+  lv_style_t textarea;
+  lv_style_t keyboard;
+  lv_style_t calendar;
+  lv_style_t slider;
+  lv_style_t slider_hour;    // LV_PART_INDICATOR
+  lv_style_t slider_minute;  // LV_PART_INDICATOR
+  lv_style_t slider_knob;    // LV_PART_KNOB
+  lv_style_t clock_hand_h;   // Lines
+  lv_style_t clock_hand_m;
+  lv_style_t clock_dot;
+
+  // Alarm list rows
+  lv_style_t row;
+  lv_style_t row_icon;
+  lv_style_t row_desc;
+  lv_style_t row_days;
+  lv_style_t row_time;
+};
+
+extern SmcStyles smc_styles;
+
+// Initialises smc_styles, only the first call does anything.
+void smc_style_init(void);
+
+#endif
@@ -0,0 +1,145 @@
+#include "vlist.h"
+#include <vector>
+
+struct VListSlot {
+  lv_obj_t* row;
+  int idx;  // -1 when hidden
+};
+
+struct VList {
+  lv_obj_t* obj;
+  // Sized so the container scrolls as far as the last item.
+  lv_obj_t* spacer;
+  int32_t row_h;
+  int32_t stride;
+  VListCreateCb create_cb;
+  VListBindCb bind_cb;
+  void* user_data;
+  int count;
+  std::vector<VListSlot> slots;
+};
+
+static void bind(VList* list, VListSlot* slot, int idx) {
+  if (slot->idx == -1)
+    lv_obj_remove_flag(slot->row, LV_OBJ_FLAG_HIDDEN);
+  slot->idx = idx;
+  lv_obj_set_y(slot->row, idx * list->stride);
+  list->bind_cb(slot->row, idx, list->user_data);
+}
+
+// Makes sure the items in view, and the margin around them, have a row.
+static void layout(VList* list) {
+  int32_t view_h = lv_obj_get_content_height(list->obj);
+  int wanted = view_h / list->stride + 2 + 2 * VLIST_MARGIN_ROWS;
+  if (wanted > list->count)
+    wanted = list->count;
+
+  while ((int)list->slots.size() < wanted) {
+    lv_obj_t* row = lv_obj_create(list->obj);
+    lv_obj_set_size(row, lv_pct(100), list->row_h);
+    list->create_cb(row, list->user_data);
+    lv_obj_add_flag(row, LV_OBJ_FLAG_HIDDEN);
+    list->slots.push_back({row, -1});
+  }
+
+  int first =
+      lv_obj_get_scroll_y(list->obj) / list->stride - VLIST_MARGIN_ROWS;
+  if (first > list->count - wanted)
+    first = list->count - wanted;
+  if (first < 0)
+    first = 0;
+  int last = first + wanted;
+
+  // Free the rows which left the window, then give them to the items which
+  // entered it.
+  for (VListSlot& slot : list->slots) {
+    if (slot.idx != -1 && (slot.idx < first || slot.idx >= last)) {
+      slot.idx = -1;
+      lv_obj_add_flag(slot.row, LV_OBJ_FLAG_HIDDEN);
+    }
+  }
+
+  size_t free_slot = 0;
+  for (int idx = first; idx < last; idx++) {
+    bool shown = false;
+    for (const VListSlot& slot : list->slots) {
+      if (slot.idx == idx) {
+        shown = true;
+        break;
+      }
+    }
+    if (shown)
+      continue;
+
+    while (list->slots[free_slot].idx != -1)
+      free_slot++;
+    bind(list, &list->slots[free_slot], idx);
+  }
+}
+
+static void scroll_cb(lv_event_t* e) {
+  layout(static_cast<VList*>(lv_event_get_user_data(e)));
+}
+
+static void delete_cb(lv_event_t* e) {
+  delete static_cast<VList*>(lv_event_get_user_data(e));
+}
+
+VList* vlist_create(lv_obj_t* parent, int32_t row_h, int32_t gap,
+                    VListCreateCb create_cb, VListBindCb bind_cb,
+                    void* user_data) {
+  auto* list = new VList{};
+  list->row_h = row_h;
+  list->stride = row_h + gap;
+  list->create_cb = create_cb;
+  list->bind_cb = bind_cb;
+  list->user_data = user_data;
+
+  list->obj = lv_obj_create(parent);
+  lv_obj_add_flag(list->obj, LV_OBJ_FLAG_SCROLLABLE);
+  lv_obj_set_scroll_dir(list->obj, LV_DIR_VER);
+  lv_obj_add_event_cb(list->obj, scroll_cb, LV_EVENT_SCROLL, list);
+  lv_obj_add_event_cb(list->obj, delete_cb, LV_EVENT_DELETE, list);
+
+  list->spacer = lv_obj_create(list->obj);
+  lv_obj_remove_style_all(list->spacer);
+  lv_obj_set_size(list->spacer, 1, 1);
+  lv_obj_add_flag(list->spacer, LV_OBJ_FLAG_HIDDEN);
+
+  return list;
+}
+
+lv_obj_t* vlist_get_obj(VList* list) {
+  return list->obj;
+}
+
+void vlist_set_count(VList* list, int count) {
+  list->count = count;
+  for (VListSlot& slot : list->slots) {
+    if (slot.idx >= count) {
+      slot.idx = -1;
+      lv_obj_add_flag(slot.row, LV_OBJ_FLAG_HIDDEN);
+    }
+  }
+
+  if (count > 0) {
+    lv_obj_remove_flag(list->spacer, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_set_y(list->spacer, (count - 1) * list->stride + list->row_h - 1);
+  } else {
+    lv_obj_add_flag(list->spacer, LV_OBJ_FLAG_HIDDEN);
+  }
+
+  lv_obj_update_layout(list->obj);
+  layout(list);
+}
+
+int vlist_get_count(VList* list) {
+  return list->count;
+}
+
+void vlist_update(VList* list, int idx) {
+  for (VListSlot& slot : list->slots) {
+    if (slot.idx != -1 && (idx == -1 || slot.idx == idx))
+      list->bind_cb(slot.row, slot.idx, list->user_data);
+  }
+}
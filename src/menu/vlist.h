@@ -0,0 +1,35 @@
+#ifndef SMC_VLIST_H
+#define SMC_VLIST_H
+
+#include "menu.h"
+#include LVGL_INCLUDE
+
+// Rows kept beyond each edge of the viewport, so a slow scroll does not
+// rebind on every frame.
+static const int VLIST_MARGIN_ROWS = 1;
+
+// Builds the children of an empty row, once per row object.
+typedef void (*VListCreateCb)(lv_obj_t* row, void* user_data);
+// Shows item idx on row, which showed some other item or nothing before.
+typedef void (*VListBindCb)(lv_obj_t* row, int idx, void* user_data);
+
+struct VList;
+
+// A scrolling list of equally tall rows which only creates as many row objects
+// as fit its height, plus VLIST_MARGIN_ROWS on each side, however many items
+// there are. Rows are moved and rebound to other items while scrolling.
+// Deleted along with its object.
+VList* vlist_create(lv_obj_t* parent, int32_t row_h, int32_t gap,
+                    VListCreateCb create_cb, VListBindCb bind_cb,
+                    void* user_data);
+lv_obj_t* vlist_get_obj(VList* list);
+
+// Changes how many items there are. Rows already showing an item are not
+// rebound, see vlist_update().
+void vlist_set_count(VList* list, int count);
+int vlist_get_count(VList* list);
+
+// Rebinds the row showing idx if there is one, or every row if idx is -1.
+void vlist_update(VList* list, int idx);
+
+#endif
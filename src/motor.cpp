@@ -1,7 +1,7 @@
 #include "motor.h"
-#include "LittleFS.h"
 #include "pins.h"
 #include "thirdparty/ULN2003.h"
+#include "ui.h"
 #include "utils.h"
 
 // TODO FIXME When the motor isnt spinning, the ULN2003 is still being instructed to send power to the motor, wasting alot of energy and heating up the motor.
@@ -13,10 +13,10 @@ static CheapStepper stepper(STEPPER_IN1, STEPPER_IN2, STEPPER_IN3, STEPPER_IN4);
 
 int Motor::setup(void) {
   if (int err = load_from_fs(); err == -2) {
-    assert(LittleFS.format());
-    esp_restart();
+    smc_data_reset();
+    smc_device_restart();
   } else if (err < -2) {
-    ESP_LOGE(TAG, "err is %d", err);
+    SMC_LOGE(TAG, "err is %d", err);
     assert(false);
   };
 
@@ -33,36 +33,24 @@ void Motor::loop(void) {
 }
 
 int Motor::load_from_fs(void) {
-  // TODO extract these into functions
-  fs_mutex.lock();
-  File file = LittleFS.open(MOTOR_PATH, FILE_READ);
-  if (!file) {
-    file.close();
-    fs_mutex.unlock();
-    ESP_LOGW(TAG, "no saved data at %s, ignoring", MOTOR_PATH);
-    return -1;
+  if (int err = smc_fs_read(MOTOR_PATH, this, sizeof(Motor)); err != 0) {
+    return err;
   }
-  assert(!file.isDirectory());
-
-  size_t res = file.readBytes((char*)this, sizeof(Motor));
-  if (res != sizeof(Motor)) {
-    file.close();
-    fs_mutex.unlock();
-    ESP_LOGE(TAG, "reading from %s, res %d, size %d", MOTOR_PATH, res,
-             sizeof(Motor));
-    return -2;
-  };
 
-  file.close();
-  fs_mutex.unlock();
-
-  // TODO DEBUG
-  char dump[256 * 3 + 1];
-  int dump_res = hexdump(dump, this, sizeof(Motor));
-  ESP_LOGD(TAG, "first %d bytes dump of %s: %s", 256, MOTOR_PATH, dump);
+#if SMC_LOG_LEVEL >= SMC_LOG_DEBUG
+  // As much as fits a log record's string.
+  char dump[SMC_LOG_STR_MAX + 1];
+  size_t dump_len = sizeof(Motor);
+  if (dump_len > SMC_LOG_STR_MAX / 3) {
+    dump_len = SMC_LOG_STR_MAX / 3;
+  }
+  int dump_res = hexdump(dump, this, dump_len);
+  SMC_LOGD(TAG, "first %d bytes dump of %s: %s", dump_res, MOTOR_PATH,
+           dump);
+#endif
 
   if (version != MOTOR_VERSION) {
-    ESP_LOGE(TAG, "unsupported version: %02X", version);
+    SMC_LOGE(TAG, "unsupported version: %02X", version);
     return -3;
   }
 
@@ -70,24 +58,7 @@ int Motor::load_from_fs(void) {
 }
 
 int Motor::save_into_fs(void) {
-  fs_mutex.lock();
-  File file = LittleFS.open(MOTOR_PATH, FILE_WRITE);
-
-  assert(file && !file.isDirectory());
-
-  assert(file.write((const uint8_t*)this, sizeof(Motor)) == sizeof(Motor));
-  // assert(file.write(version) == 1);
-  //
-  // for (int i = 0; i < MAX_ALARMS; i++) {
-  //   assert(file.write((uint8_t *)&list[i], sizeof(Alarm)) == sizeof(Alarm));
-  // }
-  //
-  // ESP_LOGD(TAG, "write err is %d", file.getWriteError());
-
-  file.close();
-  fs_mutex.unlock();
-
-  return 0;
+  return smc_fs_write(MOTOR_PATH, this, sizeof(Motor));
 }
 
 int Motor::spin_to(int compartment) {
@@ -103,7 +74,7 @@ int Motor::spin_to(int compartment) {
   double displacement = compartment * STEPS_PER_COMPARTMENT - current_step;
   int steps = abs((int)lround(displacement));
 
-  ESP_LOGD(TAG, "%lf , %d, %d", displacement, steps, current_step);
+  SMC_LOGD(TAG, "%lf , %d, %d", displacement, steps, current_step);
 
   if (displacement > 0.0) {
     stepper.newMove(true, steps);
@@ -141,5 +112,5 @@ int Motor::calibrate(int steps) {
 }
 
 bool Motor::is_running(void) {
-  return stepper.getStepsLeft() > 0;
+  return stepper.getStepsLeft() != 0;
 }
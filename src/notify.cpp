@@ -0,0 +1,152 @@
+#include "notify.h"
+#include <cstring>
+#include "HTTPClient.h"
+#include "WiFi.h"
+#include "utils.h"
+
+static const char* TAG = "notify";
+
+struct NotifyMessage {
+  char text[NOTIFY_MESSAGE_SIZE];
+};
+
+static QueueHandle_t queue = NULL;
+static char notify_url[128];
+
+// Kept across batches so the connection to notify_url stays alive.
+static WiFiClient client;
+static HTTPClient http;
+
+int Notifier::setup(const char* url) {
+  if (queue != NULL) {
+    return 0;
+  }
+
+  strncpy(notify_url, url, sizeof(notify_url) - 1);
+  if (notify_url[0] == 0x00) {
+    SMC_LOGW(TAG, "no notify url, notifications will be dropped");
+  }
+
+  http.setReuse(true);
+
+  queue = xQueueCreate(NOTIFY_QUEUE_LEN, sizeof(NotifyMessage));
+  assert(queue != NULL);
+  assert(xTaskCreate(task, "notify", 6 * 1024, NULL, 1, NULL) == pdPASS);
+
+  return 0;
+}
+
+int Notifier::send(const char* message) {
+  if (queue == NULL) {
+    return -2;
+  }
+
+  NotifyMessage msg;
+  strncpy(msg.text, message, sizeof(msg.text) - 1);
+  msg.text[sizeof(msg.text) - 1] = 0x00;
+
+  if (xQueueSend(queue, &msg, 0) != pdTRUE) {
+    SMC_LOGW(TAG, "queue full, dropping \"%s\"", msg.text);
+    return -1;
+  }
+
+  return 0;
+}
+
+int Notifier::pending(void) {
+  if (queue == NULL) {
+    return 0;
+  }
+  return uxQueueMessagesWaiting(queue);
+}
+
+// Returns the HTTP status code, or a negative HTTPC_ERROR_* code.
+int Notifier::post(const char* body, size_t len) {
+  if (!http.begin(client, notify_url)) {
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+  http.addHeader("Content-Type", "text/plain");
+
+  unsigned long start = millis();
+  int code = http.POST((uint8_t*)body, len);
+  SMC_LOGD(TAG, "posted %d bytes in %lums, resp: %d", len, millis() - start,
+           code);
+
+  // Keeps the connection open when the server allows it.
+  http.end();
+  return code;
+}
+
+void Notifier::task(void* arg) {
+  static char batch[NOTIFY_BATCH_SIZE];
+  size_t batch_len = 0;
+  int backoff_ms = NOTIFY_BACKOFF_MIN_MS;
+  NotifyMessage msg;
+
+  for (;;) {
+    // Only wait for the first message of a batch, then gather whatever else
+    // arrives within the window.
+    if (batch_len == 0) {
+      xQueueReceive(queue, &msg, portMAX_DELAY);
+      batch_len = strlen(msg.text);
+      memcpy(batch, msg.text, batch_len);
+    }
+
+    TickType_t window_end =
+        xTaskGetTickCount() + pdMS_TO_TICKS(NOTIFY_BATCH_WINDOW_MS);
+    for (;;) {
+      int32_t left = (int32_t)(window_end - xTaskGetTickCount());
+      if (left <= 0) {
+        break;
+      }
+      if (xQueuePeek(queue, &msg, left) != pdTRUE) {
+        break;
+      }
+      size_t len = strlen(msg.text);
+      if (batch_len + 1 + len > sizeof(batch)) {
+        break;  // Left in the queue for the next batch.
+      }
+      xQueueReceive(queue, &msg, 0);
+      batch[batch_len++] = '\n';
+      memcpy(batch + batch_len, msg.text, len);
+      batch_len += len;
+    }
+
+    if (notify_url[0] == 0x00) {
+      batch_len = 0;
+      continue;
+    }
+
+    int code = -1;
+    if (WiFi.status() == WL_CONNECTED) {
+      code = post(batch, batch_len);
+    }
+
+    if (code >= 200 && code < 300) {
+      batch_len = 0;
+      backoff_ms = NOTIFY_BACKOFF_MIN_MS;
+      continue;
+    }
+
+    // The server refused this batch and would refuse it again, only a
+    // timeout or rate limit is worth waiting out.
+    if (code > 0 && code < 500 && code != 408 && code != 429) {
+      SMC_LOGE(TAG, "server answered %d, dropping %d bytes of notifications",
+               code, (int)batch_len);
+      batch_len = 0;
+      backoff_ms = NOTIFY_BACKOFF_MIN_MS;
+      continue;
+    }
+
+    // No connection or a server error, the batch is kept and retried, messages
+    // queued meanwhile are appended to it on the next attempt.
+    SMC_LOGW(TAG, "sending failed with %d, retrying in %dms", code,
+             backoff_ms);
+    client.stop();
+    vTaskDelay(pdMS_TO_TICKS(backoff_ms));
+    backoff_ms *= 2;
+    if (backoff_ms > NOTIFY_BACKOFF_MAX_MS) {
+      backoff_ms = NOTIFY_BACKOFF_MAX_MS;
+    }
+  }
+}
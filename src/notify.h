@@ -0,0 +1,36 @@
+#ifndef SMC_NOTIFY_H
+#define SMC_NOTIFY_H
+
+#include <cstddef>
+
+static const int NOTIFY_QUEUE_LEN = 16;
+static const int NOTIFY_MESSAGE_SIZE = 128;
+
+// Messages queued within this window of the first one are sent together, one
+// per line, in a single POST.
+static const int NOTIFY_BATCH_WINDOW_MS = 250;
+static const int NOTIFY_BATCH_SIZE = 1024;
+
+static const int NOTIFY_BACKOFF_MIN_MS = 1000;
+static const int NOTIFY_BACKOFF_MAX_MS = 60 * 1000;
+
+// Sends notifications to the notify URL from its own task, so callers never
+// wait on the network. The connection is kept alive between batches.
+class Notifier {
+ public:
+  int setup(const char* url);
+
+  // Queues message without blocking. Returns 0, -1 if the queue is full, or -2
+  // if the notifier is not set up.
+  int send(const char* message);
+
+  // Messages queued and not yet taken into a batch, for diagnostics. A batch
+  // being sent or retried isn't counted.
+  static int pending(void);
+
+ private:
+  static void task(void* arg);
+  static int post(const char* body, size_t len);
+};
+
+#endif
@@ -6,7 +6,10 @@
 #define PRI_BUTTON_PIN 34
 #define SEC_BUTTON_PIN -1
 
-#define RTC_SQW -1
+// The DS3231's SQW is open drain and GPIO39 is input only, with no internal
+// pull-up. It needs an external pull-up to 3.3V, which most DS3231 modules
+// have, else the pin floats and every bit of noise is counted as a second.
+#define RTC_SQW 39
 
 #define I2C_SCL 22
 #define I2C_SDA 21
@@ -0,0 +1,211 @@
+#include "profiler.h"
+#include <Arduino.h>
+#include <hal/cpu_hal.h>
+#include <cstring>
+#include "utils.h"
+
+static const char* TAG = "profiler";
+
+// Tasks whose stack high-water marks are reported, when they exist.
+static const char* const STACK_TASKS[] = {
+    "loopTask", "log",  "notify", "httpd",   "esp_timer",
+    "tiT",      "wifi", "sys_evt", "arduino_events",
+};
+
+static uint32_t cycles_per_us = 240;
+static uint32_t bucket_cycles[PROFILE_BUCKETS - 1];
+
+static ProfileStats stages[PROFILE_STAGES];
+static ProfileStats loops;
+static uint32_t loops_per_sec = 0;
+
+// The slowest loop iteration since the last reset, by stage.
+static uint32_t worst_cycles = 0;
+static uint32_t worst_breakdown[PROFILE_STAGES];
+static unsigned long worst_at_ms = 0;
+
+static uint32_t loop_started = 0;
+static uint32_t last_mark = 0;
+static uint32_t breakdown[PROFILE_STAGES];
+static uint32_t second_started = 0;
+static uint32_t second_loops = 0;
+static unsigned long last_report = 0;
+
+// Set from the web server's task, applied by the main loop.
+static volatile bool reset_requested = false;
+
+static void reset_stats(ProfileStats* stats) {
+  memset(stats, 0, sizeof(ProfileStats));
+  stats->min_cycles = UINT32_MAX;
+}
+
+static void reset(void) {
+  for (ProfileStats& stats : stages) {
+    reset_stats(&stats);
+  }
+  reset_stats(&loops);
+  worst_cycles = 0;
+  memset(worst_breakdown, 0, sizeof(worst_breakdown));
+  worst_at_ms = 0;
+}
+
+static void record(ProfileStats* stats, uint32_t cycles) {
+  stats->count++;
+  stats->total_cycles += cycles;
+  if (cycles < stats->min_cycles) {
+    stats->min_cycles = cycles;
+  }
+  if (cycles > stats->max_cycles) {
+    stats->max_cycles = cycles;
+  }
+
+  int bucket = 0;
+  while (bucket < PROFILE_BUCKETS - 1 && cycles > bucket_cycles[bucket]) {
+    bucket++;
+  }
+  stats->buckets[bucket]++;
+}
+
+static uint32_t avg_us(const ProfileStats* stats) {
+  if (stats->count == 0) {
+    return 0;
+  }
+  return stats->total_cycles / stats->count / cycles_per_us;
+}
+
+static uint32_t min_us(const ProfileStats* stats) {
+  return stats->count == 0 ? 0 : stats->min_cycles / cycles_per_us;
+}
+
+void profile_setup(void) {
+  cycles_per_us = getCpuFrequencyMhz();
+  for (int i = 0; i < PROFILE_BUCKETS - 1; i++) {
+    bucket_cycles[i] = PROFILE_BUCKETS_US[i] * cycles_per_us;
+  }
+  reset();
+
+  second_started = cpu_hal_get_cycle_count();
+  last_report = millis();
+}
+
+void profile_loop_start(void) {
+  if (reset_requested) {
+    reset();
+    reset_requested = false;
+  }
+
+  loop_started = last_mark = cpu_hal_get_cycle_count();
+  memset(breakdown, 0, sizeof(breakdown));
+}
+
+void profile_mark(ProfileStage stage) {
+  uint32_t now = cpu_hal_get_cycle_count();
+  uint32_t cycles = now - last_mark;
+  last_mark = now;
+
+  breakdown[stage] += cycles;
+  record(&stages[stage], cycles);
+}
+
+static void log_report(void) {
+  SMC_LOGI(TAG, "%u loops/s, loop avg %uus max %uus", loops_per_sec,
+           avg_us(&loops), loops.max_cycles / cycles_per_us);
+  for (int i = 0; i < PROFILE_STAGES; i++) {
+    SMC_LOGI(TAG, "%-8s avg %6uus max %6uus, %uus in the worst loop",
+             PROFILE_STAGE_NAMES[i], avg_us(&stages[i]),
+             stages[i].max_cycles / cycles_per_us,
+             worst_breakdown[i] / cycles_per_us);
+  }
+  for (const char* name : STACK_TASKS) {
+    TaskHandle_t task = xTaskGetHandle(name);
+    if (task != NULL) {
+      SMC_LOGI(TAG, "%-14s %u bytes of stack never used", name,
+               uxTaskGetStackHighWaterMark(task));
+    }
+  }
+}
+
+void profile_loop_end(void) {
+  uint32_t now = cpu_hal_get_cycle_count();
+  uint32_t cycles = now - loop_started;
+  record(&loops, cycles);
+
+  if (cycles > worst_cycles) {
+    worst_cycles = cycles;
+    memcpy(worst_breakdown, breakdown, sizeof(breakdown));
+    worst_at_ms = millis();
+  }
+
+  second_loops++;
+  if (now - second_started >= cycles_per_us * 1000000) {
+    loops_per_sec = second_loops;
+    second_loops = 0;
+    second_started = now;
+  }
+
+  if (millis() - last_report >= PROFILE_REPORT_MS) {
+    last_report = millis();
+    log_report();
+  }
+}
+
+static void write_stats(MetricsWriter* w, const char* name,
+                        const ProfileStats* stats) {
+  w->append("%-8s count %u min %uus avg %uus max %uus\n", name, stats->count,
+            min_us(stats), avg_us(stats), stats->max_cycles / cycles_per_us);
+
+  w->append("         ");
+  for (int b = 0; b < PROFILE_BUCKETS; b++) {
+    if (b < PROFILE_BUCKETS - 1) {
+      w->append(" <%uus:%u", PROFILE_BUCKETS_US[b], stats->buckets[b]);
+    } else {
+      w->append(" more:%u\n", stats->buckets[b]);
+    }
+  }
+}
+
+static void write_profile(MetricsWriter* w) {
+  w->append("uptime %lums, %u loops/s\n\n", millis(), loops_per_sec);
+
+  write_stats(w, "loop", &loops);
+  for (int i = 0; i < PROFILE_STAGES; i++) {
+    write_stats(w, PROFILE_STAGE_NAMES[i], &stages[i]);
+  }
+
+  w->append("\nworst loop %uus at %lums\n", worst_cycles / cycles_per_us,
+            worst_at_ms);
+  for (int i = 0; i < PROFILE_STAGES; i++) {
+    w->append("  %-8s %uus\n", PROFILE_STAGE_NAMES[i],
+              worst_breakdown[i] / cycles_per_us);
+  }
+
+  w->append("\nstack never used\n");
+  for (const char* name : STACK_TASKS) {
+    TaskHandle_t task = xTaskGetHandle(name);
+    if (task != NULL) {
+      w->append("  %-14s %u bytes\n", name,
+                uxTaskGetStackHighWaterMark(task));
+    }
+  }
+}
+
+void register_endpoints_profile(MetricsHttpServer* server) {
+  server->on("/profile", HTTP_GET,
+             [](PsychicRequest* req, PsychicResponse* res) {
+               res->setContentType("text/plain");
+
+               MetricsWriter w = {.res = res, .len = 0, .err = 0};
+               write_profile(&w);
+               w.flush();
+               if (w.err != 0) {
+                 SMC_LOGE(TAG, "sendChunk returned %d", w.err);
+                 return w.err;
+               }
+
+               if (req->hasParam("reset")) {
+                 reset_requested = true;
+               }
+
+               return res->finishChunking();
+             });
+}
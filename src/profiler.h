@@ -0,0 +1,55 @@
+#ifndef SMC_PROFILER_H
+#define SMC_PROFILER_H
+
+#include <cstdint>
+#include "http_metrics.h"
+
+// The stages of smc_loop(), in order.
+enum ProfileStage : uint8_t {
+  PROFILE_INTERNAL = 0,  // smc_internal_loop()
+  PROFILE_LVGL,
+  PROFILE_WIFI,
+  PROFILE_CLOCK,
+  PROFILE_SMS,
+  PROFILE_TICK,  // Alarms and the rest of the once a second work
+  PROFILE_MOTOR,
+  PROFILE_STAGES,
+};
+
+static const char* const PROFILE_STAGE_NAMES[PROFILE_STAGES] = {
+    "internal", "lvgl", "wifi", "clock", "sms", "tick", "motor",
+};
+
+// Upper bounds of the histogram buckets in microseconds, an implicit bucket
+// for anything longer follows.
+static const uint32_t PROFILE_BUCKETS_US[] = {
+    16, 64, 256, 1000, 4000, 16000, 64000,
+};
+static const int PROFILE_BUCKETS =
+    sizeof(PROFILE_BUCKETS_US) / sizeof(PROFILE_BUCKETS_US[0]) + 1;
+
+static const unsigned long PROFILE_REPORT_MS = 5 * 60 * 1000;
+
+struct ProfileStats {
+  uint32_t count;
+  uint32_t min_cycles;
+  uint32_t max_cycles;
+  uint64_t total_cycles;
+  uint32_t buckets[PROFILE_BUCKETS];
+};
+
+// Times the main loop with the CPU's cycle counter, a register read and a few
+// additions per stage, so it stays enabled. Only call these from the main
+// loop.
+void profile_setup(void);
+void profile_loop_start(void);
+// Ends stage, which began at the previous mark or profile_loop_start().
+void profile_mark(ProfileStage stage);
+// Also logs a summary every PROFILE_REPORT_MS.
+void profile_loop_end(void);
+
+// Registers /profile, the per stage timings, the worst loop iteration and the
+// stack high-water marks as text. /profile?reset starts over.
+void register_endpoints_profile(MetricsHttpServer* server);
+
+#endif
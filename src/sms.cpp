@@ -1,71 +1,250 @@
 #include <pins.h>
 #include <sms.h>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "utils.h"
 
 static const char* TAG = "sms";
 
-// Helper function to easily perform IO (Input/Output) Operations with a serial connection in one function. Good for transmitting a message and expecting to recieve messages as well.
-uint16_t serialIO(HardwareSerial serial, const char* send_msg, char* recv_buf,
-                  uint16_t max_recv, int ms = 1000) {
-  if (!serial) {
+// Sent once at boot, in order: echo off, text mode, new messages announced
+// with +CMTI, delivery reports with +CDS and registration changes with +CREG.
+static const char* SETUP_COMMANDS[] = {
+    "AT", "ATE0", "AT+CMGF=1", "AT+CNMI=2,1,0,1,0", "AT+CREG=1",
+};
+
+size_t SMS::uart_write(void* ctx, const uint8_t* data, size_t len) {
+  return ((HardwareSerial*)ctx)->write(data, len);
+}
+
+int SMS::setup(void) {
+  simSerial.setRxBufferSize(1024);
+  simSerial.begin(9600, SERIAL_8N1, SIM_RX, SIM_TX);
+
+  assert(at.on_urc("+CMTI", on_cmti, this) == 0);
+  assert(at.on_urc("+CREG", on_creg, this) == 0);
+  assert(at.on_urc("+CDS", on_cds, this) == 0);
+
+  for (const char* cmd : SETUP_COMMANDS) {
+    assert(at.command(cmd, on_setup, (void*)cmd) == 0);
+  }
+  assert(at.command("AT+CSQ", on_csq, this) == 0);
+
+  outbox.setup(&at);
+
+  return 0;
+}
+
+void SMS::loop(void) {
+  uint8_t buf[64];
+  while (int len = simSerial.available()) {
+    if (len > (int)sizeof(buf)) {
+      len = sizeof(buf);
+    }
+    len = simSerial.read(buf, len);
+    at.feed(buf, len, millis());
+  }
+
+  at.poll(millis());
+  outbox.loop(millis());
+
+  if (bounce(&signal_tk, SMS_SIGNAL_PERIOD_MS) && at.queued() == 0) {
+    at.command("AT+CSQ", on_csq, this);
+  }
+}
+
+int SMS::send(const char* message, const char* number) {
+  int slot = outbox.queue(number, message);
+  if (slot < 0) {
+    SMC_LOGW(TAG, "not sending to %s, outbox returned %d", number, slot);
+    return slot;
+  }
+  return 0;
+}
+
+int SMS::list(SMC_SMSMessage** dest, int max_len) {
+  int len = inbox_len < max_len ? inbox_len : max_len;
+  for (int i = 0; i < len; i++) {
+    int idx = (inbox_next - 1 - i + SMS_INBOX_LEN) % SMS_INBOX_LEN;
+    inbox_messages[idx] = {.content = inbox[idx].content,
+                           .number = inbox[idx].number,
+                           .timestamp = inbox[idx].timestamp};
+    dest[i] = &inbox_messages[idx];
+  }
+  return len;
+}
+
+int SMS::signal(void) {
+  if (csq < 0 || csq > 31) {
     return 0;
   }
+  return -113 + (csq * 2);
+}
+
+int SMS::registration(void) {
+  return creg;
+}
+
+void SMS::on_setup(void* ctx, int result, const char* lines) {
+  if (result != AT_OK) {
+    SMC_LOGE(TAG, "%s failed with %d: %s", (const char*)ctx, result, lines);
+  }
+}
 
-  if (send_msg != NULL) {
-    serial.println(send_msg);
+// +CMTI: "SM",3
+void SMS::on_cmti(void* ctx, const char* line) {
+  SMS* sms = (SMS*)ctx;
+  const char* comma = strrchr(line, ',');
+  if (comma == NULL) {
+    SMC_LOGW(TAG, "malformed %s", line);
+    return;
   }
+  int idx = atoi(comma + 1);
+  SMC_LOGI(TAG, "new message at %d", idx);
 
-  uint16_t recv = 0;
+  // Deleted by on_cmgr() once it was read, so the SIM storage does not fill
+  // up. There are never more reads queued than commands.
+  ReadCtx* read = &sms->read_ctx[sms->read_next];
+  sms->read_next = (sms->read_next + 1) % AT_QUEUE_LEN;
+  read->sms = sms;
+  read->idx = idx;
 
-  if (recv_buf != NULL) {
-    delay(ms);
-    memset(recv_buf, 0, max_recv);
-    while (serial.available() && recv < max_recv - 1) {
-      recv_buf[recv++] = serial.read();
-    }
-    recv_buf[recv] = 0x00;
+  char cmd[AT_CMD_SIZE];
+  snprintf(cmd, sizeof(cmd), "AT+CMGR=%d", idx);
+  if (sms->at.command(cmd, on_cmgr, read) != 0) {
+    SMC_LOGW(TAG, "command queue full, message %d stays on the SIM", idx);
   }
+}
 
-  return recv;
+// +CREG: 1 (unsolicited) or +CREG: 1,1 (answer to AT+CREG?)
+void SMS::on_creg(void* ctx, const char* line) {
+  SMS* sms = (SMS*)ctx;
+  const char* value = strrchr(line, ',');
+  value = value == NULL ? strchr(line, ':') : value;
+  if (value == NULL) {
+    return;
+  }
+  sms->creg = atoi(value + 1);
+  SMC_LOGI(TAG, "registration status %d", sms->creg);
 }
 
-int SMS::setup(void) {
-  simSerial.begin(9600, SERIAL_8N1, SIM_RX, SIM_TX);
-  char buf[250];
-
-  // serialIO(simSerial, "AT+CSQ", buf, sizeof(buf), 1500);
-  // ESP_LOGD(TAG, "got sim resp: %s", buf);
-
-  // serialIO(simSerial, "AT+COPS?", buf, sizeof(buf), 1500);
-  // ESP_LOGD(TAG, "got sim resp: %s", buf);
-  //
-  // serialIO(simSerial, "AT+CREG?", buf, sizeof(buf), 1500);
-  // ESP_LOGD(TAG, "got sim resp: %s", buf);
-
-  serialIO(simSerial, "AT+CMGL=?", buf, sizeof(buf), 1500);
-  ESP_LOGD(TAG, "got sim resp: %s", buf);
-
-  // serialIO(simSerial, "AT+CMGF=1", buf, sizeof(buf), 1500);
-  // ESP_LOGD(TAG, "got sim resp: %s", buf);
-  //
-  // serialIO(simSerial, "AT+CMGS=\"+639472436267\"", buf, sizeof(buf), 1500);
-  // ESP_LOGD(TAG, "got sim resp: %s", buf);
-  //
-  // serialIO(simSerial, "Hello from Smart Medicine Container!", buf, sizeof(buf),
-  //          1500);
-  // ESP_LOGD(TAG, "got sim resp: %s", buf);
-  //
-  // simSerial.write(26);
-
-  // delay(1500);
-  // memset(buf, 0, sizeof(buf));
-  // while (simSerial.available()) {
-  //   Serial.print(simSerial.read());
-  // }
+// Text mode: +CDS: 6,<mr>,"<ra>",<tora>,"<scts>","<dt>",<st>
+// PDU mode: +CDS: <length>, then the PDU on its own line
+void SMS::on_cds(void* ctx, const char* line) {
+  SMS* sms = (SMS*)ctx;
+  const char* first = strchr(line, ',');
+  if (first == NULL) {
+    sms->at.take_next_line(on_cds_pdu, sms);
+    return;
+  }
 
-  return 0;
+  int mr = atoi(first + 1);
+  int status = atoi(strrchr(line, ',') + 1);
+  sms->outbox.status_report(mr, status);
+}
+
+void SMS::on_cds_pdu(void* ctx, const char* line) {
+  SMS* sms = (SMS*)ctx;
+  int mr, status;
+  if (sms_pdu_parse_status_report(line, &mr, &status) != 0) {
+    SMC_LOGW(TAG, "malformed status report: %s", line);
+    return;
+  }
+  sms->outbox.status_report(mr, status);
 }
 
-uint16_t SMS::IO(const char* send_msg, char* recv_buf, uint16_t max_recv,
-                 int ms) {
-  return serialIO(simSerial, send_msg, recv_buf, max_recv, ms);
+// +CSQ: 17,0
+void SMS::on_csq(void* ctx, int result, const char* lines) {
+  SMS* sms = (SMS*)ctx;
+  if (result != AT_OK || strncmp(lines, "+CSQ:", 5) != 0) {
+    SMC_LOGW(TAG, "AT+CSQ failed with %d: %s", result, lines);
+    return;
+  }
+  sms->csq = atoi(lines + 5);
+}
+
+void SMS::on_cmgd(void* ctx, int result, const char* lines) {
+  if (result != AT_OK) {
+    SMC_LOGW(TAG, "deleting message %d failed with %d: %s", (int)(intptr_t)ctx,
+             result, lines);
+  }
+}
+
+// +CMGR: "REC UNREAD","+639170000000","","24/05/01,10:00:00+32"
+// <text>
+//
+// A message is only deleted once it was read here. In PDU mode the header
+// starts with the status as a number, and the PDU would pass for the text.
+void SMS::on_cmgr(void* ctx, int result, const char* lines) {
+  ReadCtx* read = (ReadCtx*)ctx;
+  SMS* sms = read->sms;
+  if (result != AT_OK) {
+    SMC_LOGW(TAG, "AT+CMGR=%d failed with %d: %s, it stays on the SIM",
+             read->idx, result, lines);
+    return;
+  }
+
+  const char* text = strchr(lines, '\n');
+  if (strncmp(lines, "+CMGR: \"", 8) != 0 || text == NULL) {
+    SMC_LOGW(TAG, "malformed message %d, it stays on the SIM: %s", read->idx,
+             lines);
+    return;
+  }
+  text++;
+
+  char cmd[AT_CMD_SIZE];
+  snprintf(cmd, sizeof(cmd), "AT+CMGD=%d", read->idx);
+  if (sms->at.command(cmd, on_cmgd, (void*)(intptr_t)read->idx) != 0) {
+    SMC_LOGW(TAG, "command queue full, message %d stays on the SIM",
+             read->idx);
+  }
+
+  // Quoted fields of the header, in order.
+  const char* fields[4] = {};
+  size_t fields_len[4] = {};
+  const char* cur = lines;
+  for (int i = 0; i < 4; i++) {
+    const char* open = strchr(cur, '"');
+    if (open == NULL || open > text) {
+      break;
+    }
+    const char* close = strchr(open + 1, '"');
+    if (close == NULL || close > text) {
+      break;
+    }
+    fields[i] = open + 1;
+    fields_len[i] = close - open - 1;
+    cur = close + 1;
+  }
+
+  SMSInboxEntry* entry = &sms->inbox[sms->inbox_next];
+  memset(entry, 0, sizeof(SMSInboxEntry));
+  if (fields[1] != NULL && fields_len[1] < sizeof(entry->number)) {
+    memcpy(entry->number, fields[1], fields_len[1]);
+  }
+
+  struct tm ts = {};
+  if (fields[3] != NULL &&
+      sscanf(fields[3], "%d/%d/%d,%d:%d:%d", &ts.tm_year, &ts.tm_mon,
+             &ts.tm_mday, &ts.tm_hour, &ts.tm_min, &ts.tm_sec) == 6) {
+    ts.tm_year += 100;
+    ts.tm_mon -= 1;
+    entry->timestamp = mktime(&ts);
+  } else {
+    entry->timestamp = time(NULL);
+  }
+
+  size_t text_len = strcspn(text, "\n");
+  if (text_len > sizeof(entry->content) - 1) {
+    text_len = sizeof(entry->content) - 1;
+  }
+  memcpy(entry->content, text, text_len);
+
+  sms->inbox_next = (sms->inbox_next + 1) % SMS_INBOX_LEN;
+  if (sms->inbox_len < SMS_INBOX_LEN) {
+    sms->inbox_len++;
+  }
+
+  SMC_LOGI(TAG, "message from %s: %s", entry->number, entry->content);
 }
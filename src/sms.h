@@ -2,15 +2,72 @@
 #define SMS_H
 
 #include <HardwareSerial.h>
+#include "at_engine.h"
+#include "sms_outbox.h"
+#include "ui.h"
 
+static const int SMS_INBOX_LEN = 8;
+static const int SMS_NUMBER_SIZE = 24;
+static const int SMS_CONTENT_SIZE = 161;
+
+static const unsigned long SMS_SIGNAL_PERIOD_MS = 30 * 1000;
+
+struct SMSInboxEntry {
+  char number[SMS_NUMBER_SIZE];
+  char content[SMS_CONTENT_SIZE];
+  time_t timestamp;
+};
+
+// Talks to the SIM module through AtEngine, nothing here waits on the modem.
 class SMS {
  public:
   int setup(void);
-  uint16_t IO(const char* send_msg, char* recv_buf, uint16_t max_recv,
-              int ms = 1000);
+  // Feeds received bytes to the engine and handles timeouts, call it from the
+  // main loop.
+  void loop(void);
+
+  // Queues an SMS in the outbox. Returns 0, -1 if the outbox is full, or -2
+  // if the message is too long or the number invalid.
+  int send(const char* message, const char* number);
+  // Points dest at the received messages, newest first. Returns how many.
+  int list(SMC_SMSMessage** dest, int max_len);
+  // Returns the signal strength in dBm from the last AT+CSQ, or 0 if unknown.
+  int signal(void);
+  // Network registration status from +CREG, -1 if unknown.
+  int registration(void);
 
  private:
+  static size_t uart_write(void* ctx, const uint8_t* data, size_t len);
+  static void on_cmti(void* ctx, const char* line);
+  static void on_creg(void* ctx, const char* line);
+  static void on_cds(void* ctx, const char* line);
+  static void on_cds_pdu(void* ctx, const char* line);
+  static void on_csq(void* ctx, int result, const char* lines);
+  static void on_cmgr(void* ctx, int result, const char* lines);
+  static void on_cmgd(void* ctx, int result, const char* lines);
+  static void on_setup(void* ctx, int result, const char* lines);
+
   HardwareSerial simSerial = HardwareSerial(2);
+  AtEngine at = AtEngine(uart_write, &simSerial);
+  SmsOutbox outbox;
+
+  // The message each AT+CMGR in the queue reads, so it is deleted only once
+  // it was.
+  struct ReadCtx {
+    SMS* sms;
+    int idx;
+  };
+  ReadCtx read_ctx[AT_QUEUE_LEN];
+  int read_next = 0;
+
+  SMSInboxEntry inbox[SMS_INBOX_LEN];
+  SMC_SMSMessage inbox_messages[SMS_INBOX_LEN];
+  int inbox_len = 0;
+  int inbox_next = 0;
+
+  int csq = 99;
+  int creg = -1;
+  time_t signal_tk = 0;
 };
 
 #endif
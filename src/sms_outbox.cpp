@@ -0,0 +1,298 @@
+#include "sms_outbox.h"
+#include <Arduino.h>
+#include <cstdlib>
+#include <cstring>
+#include "ui.h"
+#include "utils.h"
+
+static const char* TAG = "sms_outbox";
+
+// Scratch space for encoding, the outbox is only used from the main loop.
+static SmsPdu pdus[SMS_PDU_MAX_PARTS];
+
+static uint8_t all_parts(const SmsOutboxEntry* entry) {
+  return (1 << entry->parts) - 1;
+}
+
+int SmsOutbox::setup(AtEngine* at) {
+  this->at = at;
+
+  if (load_from_fs() != 0) {
+    file = SmsOutboxFile{};
+  }
+
+  SMC_LOGI(TAG, "%d messages waiting to be sent", pending());
+  return 0;
+}
+
+int SmsOutbox::load_from_fs(void) {
+  if (int err = smc_fs_read(SMS_OUTBOX_PATH, &file, sizeof(file)); err != 0) {
+    return err;
+  }
+
+  if (file.version != SMS_OUTBOX_VERSION) {
+    SMC_LOGE(TAG, "unsupported version: %02X", file.version);
+    return -3;
+  }
+
+  // The modem never confirmed these, so they are sent again. Parts already
+  // confirmed stay sent.
+  for (SmsOutboxEntry& entry : file.entries) {
+    if (entry.state == SMS_OUTBOX_SENDING) {
+      entry.state = SMS_OUTBOX_QUEUED;
+    }
+  }
+
+  return 0;
+}
+
+int SmsOutbox::save_into_fs(void) {
+  return smc_fs_write(SMS_OUTBOX_PATH, &file, sizeof(file));
+}
+
+int SmsOutbox::pending(void) {
+  int count = 0;
+  for (const SmsOutboxEntry& entry : file.entries) {
+    if (entry.state == SMS_OUTBOX_QUEUED || entry.state == SMS_OUTBOX_SENDING) {
+      count++;
+    }
+  }
+  return count;
+}
+
+int SmsOutbox::queue(const char* number, const char* text) {
+  if (strlen(number) >= SMS_OUTBOX_NUMBER_SIZE ||
+      strlen(text) >= SMS_OUTBOX_TEXT_SIZE) {
+    return -2;
+  }
+
+  int parts = sms_pdu_encode(number, text, 0, true, pdus, SMS_PDU_MAX_PARTS);
+  if (parts < 0) {
+    return -2;
+  }
+
+  // Entries only waiting for delivery reports are given up first.
+  int slot = -1;
+  for (int i = 0; i < SMS_OUTBOX_LEN && slot == -1; i++) {
+    if (file.entries[i].state == SMS_OUTBOX_FREE) {
+      slot = i;
+    }
+  }
+  for (int i = 0; i < SMS_OUTBOX_LEN && slot == -1; i++) {
+    if (file.entries[i].state == SMS_OUTBOX_SENT) {
+      SMC_LOGW(TAG, "no delivery report for %s, forgetting it",
+               file.entries[i].number);
+      slot = i;
+    }
+  }
+  if (slot == -1) {
+    return -1;
+  }
+
+  SmsOutboxEntry* entry = &file.entries[slot];
+  memset(entry, 0, sizeof(SmsOutboxEntry));
+  entry->state = SMS_OUTBOX_QUEUED;
+  entry->ref = file.next_ref++;
+  entry->parts = parts;
+  strcpy(entry->number, number);
+  strcpy(entry->text, text);
+
+  assert(save_into_fs() == 0);
+  SMC_LOGD(TAG, "queued %d parts to %s at %d", parts, number, slot);
+
+  return slot;
+}
+
+void SmsOutbox::loop(unsigned long now_ms) {
+  if (retry_pending) {
+    retry_at = now_ms + SMS_OUTBOX_RETRY_MS;
+    retry_pending = false;
+  }
+
+  if (sending || (long)(now_ms - retry_at) < 0) {
+    return;
+  }
+
+  // Room for AT+CMGF=0, the longest message and AT+CMGF=1, so the first
+  // queued entry always fits.
+  if (pending() == 0 || at->free_slots() < SMS_PDU_MAX_PARTS + 2) {
+    return;
+  }
+
+  // The whole round is queued at once, so nothing else, like reading a message
+  // announced with +CMTI, runs while the modem is in PDU mode. If AT+CMGF=0
+  // fails, on_pdu_mode() drops the parts again: in text mode, AT+CMGS would
+  // take the length for a number and send the hex as text.
+  assert(at->command("AT+CMGF=0", on_pdu_mode, this) == 0);
+  round_parts = queue_parts(at->free_slots() - 1);
+  if (round_parts == 0) {
+    // Whatever was queued no longer encodes and was dropped.
+    at->cancel(on_pdu_mode);
+    retry_at = now_ms + SMS_OUTBOX_RETRY_MS;
+    return;
+  }
+
+  // Back to text mode, the rest of SMS expects it.
+  assert(at->command("AT+CMGF=1", on_round_done, this) == 0);
+  sending = true;
+  pdu_mode_failed = false;
+  round_start = now_ms;
+  round_sent = 0;
+}
+
+void SmsOutbox::on_pdu_mode(void* ctx, int result, const char* lines) {
+  SmsOutbox* outbox = (SmsOutbox*)ctx;
+
+  if (result != AT_OK) {
+    SMC_LOGW(TAG, "switching to pdu mode failed with %d: %s, retrying later",
+             result, lines);
+    outbox->at->cancel(on_cmgs);
+    outbox->pdu_mode_failed = true;
+  }
+}
+
+int SmsOutbox::queue_parts(int room) {
+  int count = 0;
+
+  for (int i = 0; i < SMS_OUTBOX_LEN; i++) {
+    SmsOutboxEntry* entry = &file.entries[i];
+    if (entry->state != SMS_OUTBOX_QUEUED) {
+      continue;
+    }
+
+    int parts = sms_pdu_encode(entry->number, entry->text, entry->ref, true,
+                               pdus, SMS_PDU_MAX_PARTS);
+    if (parts != entry->parts) {
+      SMC_LOGE(TAG, "%d no longer encodes (%d), dropping it", i, parts);
+      entry->state = SMS_OUTBOX_FREE;
+      continue;
+    }
+
+    int unsent = parts - __builtin_popcount(entry->sent_mask);
+    if (unsent > room - count) {
+      break;  // Next round
+    }
+
+    entry->state = SMS_OUTBOX_SENDING;
+    for (int p = 0; p < parts; p++) {
+      if (entry->sent_mask & (1 << p)) {
+        continue;
+      }
+
+      PartCtx* ctx = &part_ctx[count++];
+      *ctx = {.outbox = this, .entry = (int8_t)i, .part = (int8_t)p};
+
+      char cmd[AT_CMD_SIZE];
+      snprintf(cmd, sizeof(cmd), "AT+CMGS=%d", pdus[p].tpdu_len);
+      assert(at->command(cmd, on_cmgs, ctx, SMS_OUTBOX_SEND_TIMEOUT_MS,
+                         pdus[p].hex) == 0);
+    }
+  }
+
+  return count;
+}
+
+// +CMGS: 12
+void SmsOutbox::on_cmgs(void* ctx, int result, const char* lines) {
+  PartCtx* part = (PartCtx*)ctx;
+  SmsOutboxEntry* entry = &part->outbox->file.entries[part->entry];
+
+  if (result != AT_OK || strncmp(lines, "+CMGS:", 6) != 0) {
+    SMC_LOGW(TAG, "part %d of %d to %s failed with %d: %s", part->part + 1,
+             entry->parts, entry->number, result, lines);
+    return;
+  }
+
+  entry->mr[part->part] = atoi(lines + 6);
+  entry->sent_mask |= 1 << part->part;
+  if (entry->sent_mask == all_parts(entry)) {
+    part->outbox->round_sent++;
+  }
+}
+
+void SmsOutbox::on_round_done(void* ctx, int result, const char* lines) {
+  SmsOutbox* outbox = (SmsOutbox*)ctx;
+  outbox->sending = false;
+
+  if (result != AT_OK) {
+    SMC_LOGE(TAG, "switching back to text mode failed with %d: %s", result,
+             lines);
+  }
+
+  // Nothing was sent, so nothing changed that needs saving, and it wasn't the
+  // messages' fault.
+  if (outbox->pdu_mode_failed) {
+    for (SmsOutboxEntry& entry : outbox->file.entries) {
+      if (entry.state == SMS_OUTBOX_SENDING) {
+        entry.state = SMS_OUTBOX_QUEUED;
+      }
+    }
+    outbox->retry_pending = true;
+    return;
+  }
+
+  for (SmsOutboxEntry& entry : outbox->file.entries) {
+    if (entry.state != SMS_OUTBOX_SENDING) {
+      continue;
+    }
+
+    if (entry.sent_mask == all_parts(&entry)) {
+      entry.state = SMS_OUTBOX_SENT;
+      continue;
+    }
+
+    entry.attempts++;
+    if (entry.attempts >= SMS_OUTBOX_MAX_ATTEMPTS) {
+      SMC_LOGE(TAG, "giving up on %s after %d attempts", entry.number,
+               entry.attempts);
+      entry.state = SMS_OUTBOX_FREE;
+    } else {
+      entry.state = SMS_OUTBOX_QUEUED;
+      outbox->retry_pending = true;
+    }
+  }
+
+  SMC_LOGI(TAG, "round of %d parts took %lums, %d messages sent",
+           outbox->round_parts, millis() - outbox->round_start,
+           outbox->round_sent);
+
+  assert(outbox->save_into_fs() == 0);
+}
+
+void SmsOutbox::status_report(int mr, int status) {
+  for (SmsOutboxEntry& entry : file.entries) {
+    if (entry.state != SMS_OUTBOX_SENT && entry.state != SMS_OUTBOX_SENDING) {
+      continue;
+    }
+
+    for (int p = 0; p < entry.parts; p++) {
+      uint8_t bit = 1 << p;
+      if (!(entry.sent_mask & bit) || (entry.delivered_mask & bit) ||
+          entry.mr[p] != mr) {
+        continue;
+      }
+
+      // 0x00-0x1F completed, 0x20-0x3F still trying, the rest failed.
+      if (status < 0x20) {
+        entry.delivered_mask |= bit;
+        if (entry.delivered_mask == all_parts(&entry)) {
+          SMC_LOGI(TAG, "delivered to %s", entry.number);
+          entry.state = SMS_OUTBOX_FREE;
+        }
+      } else if (status < 0x40) {
+        SMC_LOGD(TAG, "mr %d to %s pending, status %02X", mr, entry.number,
+                 status);
+        return;
+      } else {
+        SMC_LOGE(TAG, "delivery to %s failed, status %02X", entry.number,
+                 status);
+        entry.state = SMS_OUTBOX_FREE;
+      }
+
+      assert(save_into_fs() == 0);
+      return;
+    }
+  }
+
+  SMC_LOGD(TAG, "status report for unknown mr %d", mr);
+}
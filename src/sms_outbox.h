@@ -0,0 +1,98 @@
+#ifndef SMC_SMS_OUTBOX_H
+#define SMC_SMS_OUTBOX_H
+
+#include <cstdint>
+#include "at_engine.h"
+#include "sms_pdu.h"
+
+static const char* SMS_OUTBOX_PATH = "/sms_outbox";
+static const char SMS_OUTBOX_VERSION = 0x00;
+
+static const int SMS_OUTBOX_LEN = 8;
+static const int SMS_OUTBOX_NUMBER_SIZE = 24;
+static const int SMS_OUTBOX_TEXT_SIZE = 480;  // UTF-8 bytes
+
+static const int SMS_OUTBOX_MAX_ATTEMPTS = 5;
+static const unsigned long SMS_OUTBOX_RETRY_MS = 30 * 1000;
+static const unsigned long SMS_OUTBOX_SEND_TIMEOUT_MS = 60 * 1000;
+
+enum SmsOutboxState : char {
+  SMS_OUTBOX_FREE = 0,
+  SMS_OUTBOX_QUEUED,
+  SMS_OUTBOX_SENDING,
+  SMS_OUTBOX_SENT,  // Waiting for the delivery reports
+};
+
+struct SmsOutboxEntry {
+  char state;
+  char attempts;
+  uint8_t ref;  // Concatenation reference
+  uint8_t parts;
+  uint8_t sent_mask;
+  uint8_t delivered_mask;
+  int16_t mr[SMS_PDU_MAX_PARTS];  // From +CMGS, matched against +CDS
+  char number[SMS_OUTBOX_NUMBER_SIZE];
+  char text[SMS_OUTBOX_TEXT_SIZE];
+};
+
+// What is kept on the filesystem.
+struct SmsOutboxFile {
+  char version = SMS_OUTBOX_VERSION;
+  uint8_t next_ref;
+  SmsOutboxEntry entries[SMS_OUTBOX_LEN];
+};
+
+// Queues outgoing SMS and sends them in PDU mode, split into concatenated
+// parts when needed. Everything queued is sent back to back in one round of
+// AT commands, and the queue is kept on the filesystem until the modem accepts
+// every part.
+class SmsOutbox {
+ public:
+  int setup(AtEngine* at);
+
+  int load_from_fs(void);
+  int save_into_fs(void);
+
+  // Returns the slot, -1 if the outbox is full, or -2 if the text does not fit
+  // SMS_PDU_MAX_PARTS or the number is invalid.
+  int queue(const char* number, const char* text);
+
+  // Starts a round of sends when there is something queued, call it from the
+  // main loop.
+  void loop(unsigned long now_ms);
+
+  // Feeds a delivery report, from +CDS.
+  void status_report(int mr, int status);
+
+  // Entries not sent yet.
+  int pending(void);
+
+  SmsOutboxFile file;
+
+ private:
+  struct PartCtx {
+    SmsOutbox* outbox;
+    int8_t entry;
+    int8_t part;
+  };
+
+  // Queues the unsent parts of queued entries which fit into room, returns
+  // how many.
+  int queue_parts(int room);
+
+  static void on_pdu_mode(void* ctx, int result, const char* lines);
+  static void on_cmgs(void* ctx, int result, const char* lines);
+  static void on_round_done(void* ctx, int result, const char* lines);
+
+  AtEngine* at = NULL;
+  bool sending = false;
+  bool retry_pending = false;
+  bool pdu_mode_failed = false;
+  unsigned long retry_at = 0;
+  unsigned long round_start = 0;
+  int round_parts = 0;
+  int round_sent = 0;
+  PartCtx part_ctx[AT_QUEUE_LEN];
+};
+
+#endif
@@ -0,0 +1,355 @@
+#include "sms_pdu.h"
+#include <cstring>
+
+// GSM 03.38 default alphabet, indexed by septet. 0x1B is the escape to the
+// extension table and never matches.
+static const uint16_t GSM7_BASIC[128] = {
+    0x0040, 0x00A3, 0x0024, 0x00A5, 0x00E8, 0x00E9, 0x00F9, 0x00EC,
+    0x00F2, 0x00C7, 0x000A, 0x00D8, 0x00F8, 0x000D, 0x00C5, 0x00E5,
+    0x0394, 0x005F, 0x03A6, 0x0393, 0x039B, 0x03A9, 0x03A0, 0x03A8,
+    0x03A3, 0x0398, 0x039E, 0xFFFF, 0x00C6, 0x00E6, 0x00DF, 0x00C9,
+    0x0020, 0x0021, 0x0022, 0x0023, 0x00A4, 0x0025, 0x0026, 0x0027,
+    0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+    0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037,
+    0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+    0x00A1, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047,
+    0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+    0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057,
+    0x0058, 0x0059, 0x005A, 0x00C4, 0x00D6, 0x00D1, 0x00DC, 0x00A7,
+    0x00BF, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067,
+    0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+    0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077,
+    0x0078, 0x0079, 0x007A, 0x00E4, 0x00F6, 0x00F1, 0x00FC, 0x00E0,
+};
+
+struct Gsm7Ext {
+  uint8_t septet;
+  uint16_t cp;
+};
+
+static const Gsm7Ext GSM7_EXT[] = {
+    {0x14, '^'}, {0x28, '{'}, {0x29, '}'}, {0x2F, '\\'}, {0x3C, '['},
+    {0x3D, '~'}, {0x3E, ']'}, {0x40, '|'}, {0x65, 0x20AC},
+};
+
+static const uint8_t GSM7_ESC = 0x1B;
+
+static const int GSM7_SINGLE = 160;  // septets
+static const int GSM7_MULTI = 153;
+static const int UCS2_SINGLE = 70;  // 16 bit units
+static const int UCS2_MULTI = 67;
+
+// 05 00 03 ref total seq, 8 bit reference concatenation.
+static const int UDH_LEN = 6;
+
+static const uint8_t DCS_GSM7 = 0x00;
+static const uint8_t DCS_UCS2 = 0x08;
+
+// Reads one code point from *s and advances it. Malformed sequences read as
+// '?'.
+static uint32_t utf8_next(const char** s) {
+  const uint8_t* p = (const uint8_t*)*s;
+  uint32_t cp;
+  int extra;
+
+  if (p[0] < 0x80) {
+    cp = p[0];
+    extra = 0;
+  } else if ((p[0] & 0xE0) == 0xC0) {
+    cp = p[0] & 0x1F;
+    extra = 1;
+  } else if ((p[0] & 0xF0) == 0xE0) {
+    cp = p[0] & 0x0F;
+    extra = 2;
+  } else if ((p[0] & 0xF8) == 0xF0) {
+    cp = p[0] & 0x07;
+    extra = 3;
+  } else {
+    (*s)++;
+    return '?';
+  }
+
+  for (int i = 1; i <= extra; i++) {
+    if ((p[i] & 0xC0) != 0x80) {
+      *s += i;
+      return '?';
+    }
+    cp = (cp << 6) | (p[i] & 0x3F);
+  }
+
+  *s += 1 + extra;
+  return cp;
+}
+
+// Writes the septets of cp into dest, which must fit 2. Returns how many, or 0
+// if it is not in the alphabet.
+static int gsm7_encode(uint32_t cp, uint8_t* dest) {
+  for (int i = 0; i < 128; i++) {
+    if (GSM7_BASIC[i] == cp) {
+      dest[0] = i;
+      return 1;
+    }
+  }
+  for (const Gsm7Ext& ext : GSM7_EXT) {
+    if (ext.cp == cp) {
+      dest[0] = GSM7_ESC;
+      dest[1] = ext.septet;
+      return 2;
+    }
+  }
+  return 0;
+}
+
+// Writes the UTF-16 units of cp into dest, which must fit 2. Returns how many.
+static int ucs2_encode(uint32_t cp, uint16_t* dest) {
+  if (cp < 0x10000) {
+    dest[0] = cp;
+    return 1;
+  }
+  cp -= 0x10000;
+  dest[0] = 0xD800 | (cp >> 10);
+  dest[1] = 0xDC00 | (cp & 0x3FF);
+  return 2;
+}
+
+static char* put_hex(char* dest, uint8_t octet) {
+  static const char* HEX = "0123456789ABCDEF";
+  dest[0] = HEX[octet >> 4];
+  dest[1] = HEX[octet & 0x0F];
+  return dest + 2;
+}
+
+// TP-DA holds up to 20 digits.
+static const int MAX_DIGITS = 20;
+
+// Everything of an SMS-SUBMIT except the user data: first octet, TP-MR, the
+// address length, type and digits, TP-PID, TP-DCS and TP-VP.
+struct SubmitHeader {
+  uint8_t octets[4 + (MAX_DIGITS + 1) / 2 + 3];
+  int len;
+};
+
+static int submit_header(const char* number, bool status_report, bool udhi,
+                         uint8_t dcs, SubmitHeader* header) {
+  bool international = number[0] == '+';
+  const char* digits = international ? number + 1 : number;
+  int digits_len = strlen(digits);
+  if (digits_len == 0 || digits_len > MAX_DIGITS) {
+    return -1;
+  }
+  for (int i = 0; i < digits_len; i++) {
+    if (digits[i] < '0' || digits[i] > '9') {
+      return -1;
+    }
+  }
+
+  uint8_t* o = header->octets;
+  int len = 0;
+
+  // SMS-SUBMIT, relative validity period.
+  o[len++] = 0x01 | 0x10 | (status_report ? 0x20 : 0x00) | (udhi ? 0x40 : 0);
+  o[len++] = 0x00;  // TP-MR, set by the modem
+  o[len++] = digits_len;
+  o[len++] = international ? 0x91 : 0x81;
+  for (int i = 0; i < digits_len; i += 2) {
+    uint8_t lo = digits[i] - '0';
+    uint8_t hi = i + 1 < digits_len ? digits[i + 1] - '0' : 0x0F;
+    o[len++] = (hi << 4) | lo;
+  }
+  o[len++] = 0x00;  // TP-PID
+  o[len++] = dcs;
+  o[len++] = 0xAA;  // TP-VP, 4 days
+
+  header->len = len;
+  return 0;
+}
+
+// Builds one part from its units, which are septets for GSM-7 and UTF-16 units
+// for UCS-2.
+static void build_part(const SubmitHeader* header, bool gsm7,
+                       const uint8_t* septets, const uint16_t* units,
+                       int units_len, uint8_t ref, int total, int seq,
+                       SmsPdu* pdu) {
+  uint8_t ud[140];
+  memset(ud, 0, sizeof(ud));
+  int ud_len = 0;  // octets
+  int udl;         // septets for GSM-7, octets for UCS-2
+
+  if (total > 1) {
+    ud[0] = 0x05;
+    ud[1] = 0x00;
+    ud[2] = 0x03;
+    ud[3] = ref;
+    ud[4] = total;
+    ud[5] = seq;
+    ud_len = UDH_LEN;
+  }
+
+  if (gsm7) {
+    // The text starts at the first septet boundary after the header.
+    int start = (ud_len * 8 + 6) / 7;
+    for (int i = 0; i < units_len; i++) {
+      int bit = (start + i) * 7;
+      ud[bit / 8] |= septets[i] << (bit % 8);
+      if (bit % 8 > 1) {
+        ud[bit / 8 + 1] |= septets[i] >> (8 - (bit % 8));
+      }
+    }
+    udl = start + units_len;
+    ud_len = (udl * 7 + 7) / 8;
+  } else {
+    for (int i = 0; i < units_len; i++) {
+      ud[ud_len++] = units[i] >> 8;
+      ud[ud_len++] = units[i] & 0xFF;
+    }
+    udl = ud_len;
+  }
+
+  char* out = pdu->hex;
+  out = put_hex(out, 0x00);  // SMSC from the SIM
+  out = put_hex(out, header->octets[0]);
+  for (int i = 1; i < header->len; i++) {
+    out = put_hex(out, header->octets[i]);
+  }
+  out = put_hex(out, udl);
+  for (int i = 0; i < ud_len; i++) {
+    out = put_hex(out, ud[i]);
+  }
+  *out = 0x00;
+
+  pdu->tpdu_len = header->len + 1 + ud_len;
+}
+
+int sms_pdu_encode(const char* number, const char* text, uint8_t ref,
+                   bool status_report, SmsPdu* parts, int max_parts) {
+  if (max_parts > SMS_PDU_MAX_PARTS) {
+    max_parts = SMS_PDU_MAX_PARTS;
+  }
+
+  // First pass, picks the encoding and counts the units.
+  bool gsm7 = true;
+  int gsm7_len = 0;
+  int ucs2_len = 0;
+  for (const char* s = text; *s != 0x00;) {
+    uint32_t cp = utf8_next(&s);
+    uint8_t septets[2];
+    uint16_t units[2];
+    int n = gsm7_encode(cp, septets);
+    if (n == 0) {
+      gsm7 = false;
+    }
+    gsm7_len += n;
+    ucs2_len += ucs2_encode(cp, units);
+  }
+
+  int len = gsm7 ? gsm7_len : ucs2_len;
+  int single = gsm7 ? GSM7_SINGLE : UCS2_SINGLE;
+  int per_part = gsm7 ? GSM7_MULTI : UCS2_MULTI;
+
+  // Estimate, characters are never split so it may need one more.
+  int total = len <= single ? 1 : (len + per_part - 1) / per_part;
+  if (total > max_parts) {
+    return -1;
+  }
+
+  // Second pass, splits at character boundaries so an escape sequence or a
+  // surrogate pair never straddles two parts.
+  uint8_t septets[GSM7_SINGLE];
+  uint16_t units[UCS2_SINGLE];
+  int part_units_len[SMS_PDU_MAX_PARTS + 1];
+  const char* part_start[SMS_PDU_MAX_PARTS + 1];
+  int capacity = total == 1 ? single : per_part;
+
+  int count = 0;
+  int units_len = 0;
+  part_start[0] = text;
+  for (const char* s = text; *s != 0x00;) {
+    const char* prev = s;
+    uint32_t cp = utf8_next(&s);
+    int n = gsm7 ? gsm7_encode(cp, septets) : ucs2_encode(cp, units);
+    if (units_len + n > capacity) {
+      part_units_len[count++] = units_len;
+      if (count == max_parts) {
+        return -1;
+      }
+      part_start[count] = prev;
+      units_len = 0;
+    }
+    units_len += n;
+  }
+  part_units_len[count++] = units_len;
+
+  SubmitHeader header;
+  uint8_t dcs = gsm7 ? DCS_GSM7 : DCS_UCS2;
+  if (submit_header(number, status_report, count > 1, dcs, &header) != 0) {
+    return -2;
+  }
+
+  for (int p = 0; p < count; p++) {
+    const char* s = part_start[p];
+    int filled = 0;
+    while (filled < part_units_len[p]) {
+      uint32_t cp = utf8_next(&s);
+      filled += gsm7 ? gsm7_encode(cp, septets + filled)
+                     : ucs2_encode(cp, units + filled);
+    }
+    build_part(&header, gsm7, septets, units, filled, ref, count, p + 1,
+               &parts[p]);
+  }
+
+  return count;
+}
+
+static int hex_octet(const char* hex, int idx) {
+  int value = 0;
+  for (int i = 0; i < 2; i++) {
+    char ch = hex[idx * 2 + i];
+    value <<= 4;
+    if (ch >= '0' && ch <= '9') {
+      value |= ch - '0';
+    } else if (ch >= 'A' && ch <= 'F') {
+      value |= ch - 'A' + 10;
+    } else if (ch >= 'a' && ch <= 'f') {
+      value |= ch - 'a' + 10;
+    } else {
+      return -1;
+    }
+  }
+  return value;
+}
+
+int sms_pdu_parse_status_report(const char* hex, int* mr, int* status) {
+  int len = strlen(hex) / 2;
+  int pos = 0;
+
+  // SMSC address
+  int sca_len = hex_octet(hex, pos);
+  if (sca_len < 0) {
+    return -1;
+  }
+  pos += 1 + sca_len;
+
+  // First octet, MR, recipient address length (in digits) and type
+  if (pos + 4 > len) {
+    return -1;
+  }
+  int first = hex_octet(hex, pos++);
+  if ((first & 0x03) != 0x02) {
+    return -1;  // Not an SMS-STATUS-REPORT
+  }
+  *mr = hex_octet(hex, pos++);
+  int ra_digits = hex_octet(hex, pos++);
+  pos += 1 + (ra_digits + 1) / 2;
+
+  // SCTS and discharge time, 7 octets each, then the status
+  pos += 7 + 7;
+  if (pos + 1 > len) {
+    return -1;
+  }
+  *status = hex_octet(hex, pos);
+  if (*mr < 0 || *status < 0) {
+    return -1;
+  }
+
+  return 0;
+}
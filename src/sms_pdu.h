@@ -0,0 +1,29 @@
+#ifndef SMC_SMS_PDU_H
+#define SMC_SMS_PDU_H
+
+#include <cstddef>
+#include <cstdint>
+
+static const int SMS_PDU_MAX_PARTS = 4;
+// The largest SMS-SUBMIT, with the empty SMSC address in front, in hex.
+static const int SMS_PDU_HEX_SIZE = 2 * 160 + 1;
+
+struct SmsPdu {
+  char hex[SMS_PDU_HEX_SIZE];
+  // Octets after the SMSC address, what AT+CMGS=<length> wants.
+  int tpdu_len;
+};
+
+// Encodes the UTF-8 text for number as SMS-SUBMIT PDUs. GSM-7 is used if every
+// character is in the default alphabet or its extension table, UCS-2
+// otherwise. Longer texts are split into concatenated parts sharing ref.
+// Returns the number of parts, -1 if it needs more than max_parts, or -2 if
+// number is invalid.
+int sms_pdu_encode(const char* number, const char* text, uint8_t ref,
+                   bool status_report, SmsPdu* parts, int max_parts);
+
+// Parses an SMS-STATUS-REPORT PDU in hex, as received with +CDS in PDU mode.
+// Returns 0, or -1 if it is malformed.
+int sms_pdu_parse_status_report(const char* hex, int* mr, int* status);
+
+#endif
@@ -260,7 +260,9 @@ void ST7789V::resetDisplay() {
 }
 
 void ST7789V::setScrollArea(uint16_t tfa, uint16_t bfa) {
-  uint16_t vsa = 240 - tfa - bfa;  // ST7789 320x240 VRAM
+  // ST7789 240x320 VRAM, scrolled along its 320 lines, which are the x of the
+  // landscape MADCTL above
+  uint16_t vsa = 320 - tfa - bfa;
   writecommand(ST7789_VSCRDEF);    // SETSCROLLAREA = 0x33
   writedata(tfa >> 8);
   writedata(tfa);
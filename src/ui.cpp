@@ -3,16 +3,20 @@
 #include <thirdparty/XPT2046.h>
 #include "./menu/alarm.h"
 #include "./menu/boot_logo.h"
+#include "./menu/config.h"
 #include "./menu/preferences.h"
 #include "./pins.h"
 #include "./webserver.h"
 #include "./wifi.h"
+#include "buzzer.h"
 #include "LittleFS.h"
 #include "WiFi.h"
 #include "clock.h"
 #include "esp32-hal-gpio.h"
 #include "menu/menu.h"
 #include "motor.h"
+#include "notify.h"
+#include "profiler.h"
 #include "sms.h"
 #include "thirdparty/lvgl/lvgl.h"
 #include "utils.h"
@@ -26,6 +30,8 @@ Alarms alarms;
 Webserver webserver;
 Motor motor;
 SMS sms;
+Notifier notifier;
+Buzzer buzzer;
 
 ST7789V tft = ST7789V(TFT_DC, TFT_CS);
 XPT2046 ts(TOUCH_CS);
@@ -40,12 +46,12 @@ void ui_touch_cb(lv_indev_t* indev, lv_indev_data_t* data);
 
 int smc_init_drivers(void) {
   pinMode(LED_PIN, OUTPUT);
-  pinMode(BUZZER_PIN, OUTPUT);
   pinMode(PRI_BUTTON_PIN, INPUT_PULLDOWN);
   // pinMode(HAND_SENSOR_PIN, INPUT);
   // pinMode(SEC_BUTTON_PIN, INPUT_PULLDOWN);
 
   tft.init(320, 240);
+  tft.setScrollArea(0, 0);
   tft.fillScreen(0xFFFF);
   tft.drawImage(96, 56, 127, 127, (uint16_t*)BOOT_LOGO_SRC);
 
@@ -79,26 +85,40 @@ int smc_init_drivers(void) {
            LittleFS.totalBytes());
 
   preferences.setup();
-  wifi.setup();
+  wifi.setup(&preferences);
   rtc.setup();
   assert(sms.setup() == 0);
   alarms.setup();
   motor.setup();
+  assert(buzzer.setup() == 0);
   assert(preferences.save_into_fs() == 0);
 
-  if (WiFi.status() == WL_CONNECTED) {
-    assert(webserver.setup(&alarms) == 0);
+  // The url from the preferences wins over the one in config.h.
+  if (strnlen(preferences.notify_url, sizeof(preferences.notify_url)) <
+          sizeof(preferences.notify_url) &&
+      preferences.notify_url[0] != 0x00) {
+    notifier.setup(preferences.notify_url);
+  } else {
+    notifier.setup(NOTIFY_URL);
   }
 
+  // Without a valid time, e.g. the RTC lost power, the alarms are worked out
+  // once it is set, see smc_loop().
   struct tm now;
-  Clock::get(&now);
-  alarms.refresh(&now);
+  if (Clock::get(&now) == 0) {
+    alarms.refresh(&now);
+  }
 
   SMC_LOGI(TAG, "alarm size: %d", sizeof(Alarm));
   SMC_LOGI(TAG, "alarm file size: %d", sizeof(Alarms));
   SMC_LOGI(TAG, "alarm log file size: %d", sizeof(AlarmLog));
   SMC_LOGI(TAG, "preferences file stroage size: %d", sizeof(DevicePreferences));
   SMC_LOGI(TAG, "wifi config size: %d", sizeof(WiFiConfig));
+  SMC_LOGI(TAG, "sms outbox file size: %d", sizeof(SmsOutboxFile));
+  SMC_LOGI(TAG, "sms outbox ram size: %d", sizeof(SmsOutbox));
+  SMC_LOGI(TAG, "at engine ram size: %d", sizeof(AtEngine));
+
+  profile_setup();
 
   SMC_LOGI(TAG, "took %ldms to boot", millis());
 
@@ -106,16 +126,47 @@ int smc_init_drivers(void) {
 }
 
 void smc_loop(void) {
+  profile_loop_start();
   smc_internal_loop();
+  profile_mark(PROFILE_INTERNAL);
   lv_timer_handler();
-  wifi.reconnect_loop();
-  alarms.loop();
+  profile_mark(PROFILE_LVGL);
+  wifi.loop();
+
+  // Things which need the network wait for the first connection, boot does
+  // not wait on Wi-Fi.
+  static bool was_connected = false;
+  if (wifi.connected() && !was_connected) {
+    was_connected = true;
+    assert(webserver.setup(&alarms) == 0);
+  }
+  profile_mark(PROFILE_WIFI);
+  rtc.loop(wifi.connected());
+  profile_mark(PROFILE_CLOCK);
+  sms.loop();
+  profile_mark(PROFILE_SMS);
+
+  if (rtc.tick() > 0) {
+    struct tm now;
+    if (Clock::get(&now) == 0) {
+      // The next alarm was worked out against a time which no longer holds.
+      if (Clock::stepped()) {
+        alarms.refresh(&now);
+      }
+      alarms.loop(Clock::now());
+      smc_internal_tick(&now);
+    }
+  }
+  profile_mark(PROFILE_TICK);
+
   static int last_compartment;
   if (alarms.should_move() != last_compartment) {
     smc_motor_move(alarms.should_move());
     last_compartment = alarms.should_move();
   }
   motor.loop();
+  profile_mark(PROFILE_MOTOR);
+  profile_loop_end();
 }
 
 int smc_motor_steps(void) {
@@ -134,13 +185,25 @@ bool smc_motor_running(void) {
   return motor.is_running();
 };
 
+int smc_notify(const char* message) {
+  return notifier.send(message);
+}
+
 struct Alarms* smc_system_alarms(void) {
   return &alarms;
 }
 
-int smc_sms_send(char* message, char* number);
-int smc_sms_list(SMC_SMSMessage** dest, int max_len);
-int smc_sms_signal(void);
+int smc_sms_send(char* message, char* number) {
+  return sms.send(message, number);
+};
+
+int smc_sms_list(SMC_SMSMessage** dest, int max_len) {
+  return sms.list(dest, max_len);
+};
+
+int smc_sms_signal(void) {
+  return sms.signal();
+};
 
 int smc_wifi_add(struct SMC_WifiConfig* cfg);
 int smc_wifi_remove(char* name);
@@ -160,18 +223,16 @@ int smc_wifi_signal(void) {
 int smc_wifi_scan(SMC_WifiConfig** dest, int max_len);
 int smc_wifi_ap(bool state, char* pass);
 
-void smc_alarm_buzzer_play(struct SMC_Melody) {
-  digitalWrite(BUZZER_PIN, HIGH);
+void smc_alarm_buzzer_play(const struct SMC_Melody* melody) {
+  buzzer.play(melody);
 };
 
 void smc_alarm_buzzer_off(void) {
-  digitalWrite(BUZZER_PIN, LOW);
+  buzzer.stop();
 };
 
 time_t smc_time_get(void) {
-  struct tm now;
-  rtc.get(&now);
-  return mktime(&now);
+  return Clock::now();
 };
 
 int smc_battery_percentage(void) {
@@ -263,6 +324,16 @@ uint32_t ui_millis_cb(void) {
   return millis();
 }
 
+int smc_display_scroll(int dx) {
+  // MADCTL's MV puts the panel's scroll axis along our x and its MY makes a
+  // larger start line move the picture right.
+  dx %= SCREEN_WIDTH;
+  if (dx < 0)
+    dx += SCREEN_WIDTH;
+  tft.setScroll(dx);
+  return 0;
+}
+
 void ui_flush_cb(lv_display_t* disp, const lv_area_t* area, uint8_t* px_buf) {
   tft.drawImage(area->x1, area->y1, area->x2 - area->x1, area->y2 - area->y1,
                 (uint16_t*)px_buf);
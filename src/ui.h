@@ -4,6 +4,7 @@
 #include <time.h>
 #include <cstdint>
 #include "./menu/alarm.h"
+#include "./menu/melody.h"
 #include "./menu/preferences.h"
 
 struct SMC_SMSMessage {
@@ -12,12 +13,6 @@ struct SMC_SMSMessage {
   time_t timestamp;
 };
 
-struct SMC_Melody {
-  uint8_t* tones;
-  size_t tones_len;
-  uint16_t sample_rate;
-};
-
 struct SMC_WifiConfig {
   char* ssid;
   char* pass;
@@ -28,14 +23,24 @@ struct SMC_WifiConfig {
 int smc_init_drivers(void);
 void smc_loop(void);
 
+// Shows the display's memory dx columns further right, wrapping around, by
+// scrolling in the panel instead of sending pixels; 0 shows it as drawn. Takes
+// effect at once, so call it once what belongs there was flushed. Returns -1
+// if the display can't, 0 otherwise.
+int smc_display_scroll(int dx);
+
 // interface
 int smc_motor_steps(void);
 int smc_motor_compartment(void);
 void smc_motor_move(int compartment);
 bool smc_motor_running(void);
 
+// Queues an SMS, the result only shows up in the logs. Returns 0 if queued.
 int smc_sms_send(char* message, char* number);
+// Fills dest with up to max_len received messages, newest first. They stay
+// valid until more messages arrive. Returns how many.
 int smc_sms_list(SMC_SMSMessage** dest, int max_len);
+// Signal strength in dBm, 0 if unknown.
 int smc_sms_signal(void);
 
 int smc_wifi_add(struct SMC_WifiConfig* cfg);
@@ -46,7 +51,13 @@ int smc_wifi_signal(void);
 int smc_wifi_scan(SMC_WifiConfig** dest, int max_len);
 int smc_wifi_ap(bool state, char* pass);
 
-void smc_alarm_buzzer_play(struct SMC_Melody);
+// Queues a notification for the notify url, never blocks. Returns 0 if it was
+// queued.
+int smc_notify(const char* message);
+
+// Plays melody on repeat in the background, melody must stay valid until
+// stopped. Calling it again with what is already playing does nothing.
+void smc_alarm_buzzer_play(const struct SMC_Melody* melody);
 void smc_alarm_buzzer_off(void);
 
 Alarms* smc_system_alarms(void);
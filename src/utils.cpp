@@ -1,5 +1,4 @@
 #include <Arduino.h>
-#include <esp_log.h>
 #include "ctime"
 
 int hexdump(char* dest, const void* src, size_t size) {
@@ -12,6 +11,23 @@ int hexdump(char* dest, const void* src, size_t size) {
   return dump_size;
 }
 
+time_t tm_to_utc(const struct tm* tm) {
+  int year = tm->tm_year + 1900;
+  int month = tm->tm_mon + 1;
+  if (month <= 2) {
+    year--;
+    month += 12;
+  }
+  // Days since 1970-01-01, from the civil calendar.
+  long era = year / 400;
+  long yoe = year - era * 400;
+  long doy = (153 * (month - 3) + 2) / 5 + tm->tm_mday - 1;
+  long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  long days = era * 146097 + doe - 719468;
+
+  return days * 86400 + tm->tm_hour * 3600 + tm->tm_min * 60 + tm->tm_sec;
+}
+
 bool bounce(time_t* timekeeper, int bounce_ms = 1000, bool renew = false) {
   long now = millis();
   if (*timekeeper < now) {
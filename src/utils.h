@@ -1,8 +1,9 @@
 #ifndef UTILS_H
 #define UTILS_H
 
-#include <esp32-hal-log.h>
 #include <cstdio>
+#include <ctime>
+#include "log.h"
 #include "mutex"
 
 static std::mutex fs_mutex;
@@ -17,9 +18,8 @@ int hexdump(char* dest, const void* src, size_t size);
 // will update the timekeeper regardless of state, good for button pressses.
 bool bounce(time_t* timekeeper, int bounce_ms = 1000, bool renew = false);
 
-#define SMC_LOGD ESP_LOGD
-#define SMC_LOGI ESP_LOGI
-#define SMC_LOGW ESP_LOGW
-#define SMC_LOGE ESP_LOGE
+// mktime() without the timezone, which changes once configTime() runs. tm is
+// in GMT+0.
+time_t tm_to_utc(const struct tm* tm);
 
 #endif
@@ -2,17 +2,107 @@
 #include <ESPmDNS.h>
 #include <string.h>
 #include "./menu/config.h"
-#include "HTTPClient.h"
 #include "LittleFS.h"
 #include "PsychicHttpServer.h"
 #include "clock.h"
 #include "endpoints/endpoints.h"
+#include "log.h"
 #include "menu/alarm.h"
 #include "motor.h"
+#include "profiler.h"
 #include "ui.h"
 
 static const char* TAG = "webserver";
 
+// The "rings in" and "ago" columns of /alarms are only recomputed once per
+// bucket, so repeated polls within it are served from the same buffer.
+static const int ALARMS_FRAGMENT_BUCKET_SECS = 5;
+static const int ALARMS_FRAGMENT_ROW_SIZE = 200;
+
+// One alarm's <tr>, redone when the alarm's version or the bucket changes.
+struct AlarmsFragmentRow {
+  unsigned int version;
+  time_t bucket = -1;
+  char html[ALARMS_FRAGMENT_ROW_SIZE];
+  int len;  // 0 if the slot is empty
+};
+
+struct AlarmsFragment {
+  unsigned int generation;
+  time_t bucket = -1;
+  char etag[24];
+  AlarmsFragmentRow rows[MAX_ALARMS];
+  char html[MAX_ALARMS * ALARMS_FRAGMENT_ROW_SIZE];
+  size_t len;
+};
+
+static AlarmsFragment alarms_fragment;
+
+static void render_alarms_row(Alarms* alarms, int idx, AlarmsFragmentRow* row,
+                              time_t bucket) {
+  row->version = Alarms::versions[idx];
+  row->bucket = bucket;
+  row->len = 0;
+  row->html[0] = 0x00;
+
+  Alarm alarm;
+  if (alarms->get(idx, &alarm) < 0) {
+    return;
+  }
+
+  // Everything in the row is relative to the start of the bucket, so the
+  // output (and the ETag) stays the same for the whole bucket.
+  time_t now_sec = bucket * ALARMS_FRAGMENT_BUCKET_SECS;
+  struct tm now;
+  gmtime_r(&now_sec, &now);
+  int today_sec = (now.tm_hour * 60 * 60) + (now.tm_min * 60) + now.tm_sec;
+
+  long when = Alarms::next_schedule(&alarm, now.tm_wday, today_sec);
+  int res = snprintf(row->html, sizeof(row->html),
+                     "<tr><th scope=\"row\">%s</th><td>%d</td><td>%lds</"
+                     "td><td>%d</td><td>%lds ago</td></tr>",
+                     alarm.name, alarm.compartment, when, alarm.days,
+                     now_sec - alarm.lastReminded);
+  if (res < 0 || res >= (int)sizeof(row->html)) {
+    SMC_LOGE(TAG, "alarms fragment row %d truncated", idx);
+    row->html[0] = 0x00;
+    return;
+  }
+  row->len = res;
+}
+
+// Returns the rendered table rows of /alarms. Only the rows of alarms which
+// changed are redone, all of them once the time bucket rolls over.
+static const AlarmsFragment* render_alarms_fragment(Alarms* alarms) {
+  AlarmsFragment* frag = &alarms_fragment;
+  time_t bucket = time(NULL) / ALARMS_FRAGMENT_BUCKET_SECS;
+  // Taken before the rows, like each row's version, so a change while they
+  // render leaves the cache out of date instead of passing for current.
+  unsigned int generation = Alarms::generation;
+
+  if (frag->bucket == bucket && frag->generation == generation) {
+    return frag;
+  }
+
+  frag->len = 0;
+  for (int i = 0; i < MAX_ALARMS; i++) {
+    AlarmsFragmentRow* row = &frag->rows[i];
+    if (row->bucket != bucket || row->version != Alarms::versions[i]) {
+      render_alarms_row(alarms, i, row, bucket);
+    }
+    memcpy(frag->html + frag->len, row->html, row->len);
+    frag->len += row->len;
+  }
+  frag->html[frag->len] = 0x00;
+
+  frag->generation = generation;
+  frag->bucket = bucket;
+  snprintf(frag->etag, sizeof(frag->etag), "\"%x-%lx\"", frag->generation,
+           (unsigned long)frag->bucket);
+
+  return frag;
+}
+
 int Webserver::setup(Alarms* alarms) {
   // TODO
   assert(MDNS.begin(DEFAULT_HOSTNAME));
@@ -69,18 +159,23 @@ int Webserver::setup(Alarms* alarms) {
           alarm.compartment = req->getParam("compartment")->value().toInt();
         }
 
-        ESP_LOGD(TAG, "aaaa %d", alarm.secondMark);
-
-        int idx = alarms->add(&alarm);
+        SMC_LOGD(TAG, "aaaa %d", alarm.secondMark);
+
+        // Held only while the store changes, the loop task needs it too.
+        int idx;
+        {
+          std::lock_guard<std::recursive_mutex> lock(Alarms::mutex);
+          idx = alarms->add(&alarm);
+          if (idx != -2) {
+            assert(alarms->refresh(&now) == 0);
+            alarms->save_into_fs();
+          }
+        }
 
         if (idx == -2) {
           return res->send(400);
         }
 
-        assert(alarms->refresh(&now) == 0);
-
-        alarms->save_into_fs();
-
         char reply[5];
         memset(reply, 0, sizeof(reply));
         snprintf(reply, sizeof(reply), "%d", idx);
@@ -98,18 +193,23 @@ int Webserver::setup(Alarms* alarms) {
                 return res->send(400);
               }
 
-              int err = alarms->set(idx, NULL);
-              ESP_LOGW(TAG, "err is %d", err);
+              int err;
+              {
+                std::lock_guard<std::recursive_mutex> lock(Alarms::mutex);
+                err = alarms->set(idx, NULL);
+                if (err == 0) {
+                  struct tm now;
+                  Clock::get(&now);
+                  assert(alarms->refresh(&now) == 0);
+                  assert(alarms->save_into_fs() == 0);
+                }
+              }
+
+              SMC_LOGW(TAG, "err is %d", err);
               if (err != 0) {
                 return res->send(400);
               }
 
-              struct tm now;
-              Clock::get(&now);
-              assert(alarms->refresh(&now) == 0);
-
-              assert(alarms->save_into_fs() == 0);
-
               return res->send(200);
             });
 
@@ -168,37 +268,23 @@ int Webserver::setup(Alarms* alarms) {
 
   server.on("/alarms", HTTP_GET,
             [=](PsychicRequest* req, PsychicResponse* res) {
-              struct tm now;
-              Clock::get(&now);
+              unsigned long start = micros();
 
-              for (int i = 0; i < MAX_ALARMS; i++) {
-                Alarm alarm;
-                if (int err = alarms->get(i, &alarm); err < 0) {
-                  continue;
-                };
-
-                char reply[200];
-                memset(reply, 0, sizeof(reply));
-                struct tm now;
-                Clock::get(&now);
-                long when = alarms->next_schedule(
-                    &alarm, now.tm_wday,
-                    (now.tm_hour * 60 * 60) + (now.tm_min * 60) + now.tm_sec);
+              const AlarmsFragment* frag = render_alarms_fragment(alarms);
+              res->addHeader("ETag", frag->etag);
+              res->addHeader("Cache-Control", "no-cache");
 
-                snprintf(reply, sizeof(reply),
-                         "<tr><th scope=\"row\">%s</th><td>%d</td><td>%lds</"
-                         "td><td>%d</td><td>%lds ago</td></tr>",
-                         alarm.name, alarm.compartment, when, alarm.days,
-                         time(NULL) - alarm.lastReminded);
-                if (int err = res->sendChunk((uint8_t*)reply, strlen(reply));
-                    err != 0) {
-                  ESP_LOGE(TAG, "sendChunk returned %d", err);
-                  res->send(500);
-                  return err;
-                }
+              if (req->hasHeader("If-None-Match") &&
+                  strcmp(req->header("If-None-Match").c_str(), frag->etag) ==
+                      0) {
+                SMC_LOGV(TAG, "/alarms 304 in %luus", micros() - start);
+                return res->send(304);
               }
 
-              return res->finishChunking();
+              esp_err_t err = res->send(200, "text/html", frag->html);
+              SMC_LOGV(TAG, "/alarms 200 (%d bytes) in %luus", frag->len,
+                       micros() - start);
+              return err;
             });
 
   server.on("/attend", HTTP_POST,
@@ -231,7 +317,7 @@ int Webserver::setup(Alarms* alarms) {
 
               time_t when = time(NULL) + sec;
 
-              ESP_LOGD(TAG, "when: %ld", when);
+              SMC_LOGD(TAG, "when: %ld", when);
 
               if (alarms->one_off_ring(when) != 0) {
                 return res->send(500);
@@ -316,9 +402,9 @@ int Webserver::setup(Alarms* alarms) {
               char buf[250];
               memset(buf, 0, sizeof(buf));
 
-              ESP_LOGD(TAG, "sim TX: %s", msg);
+              SMC_LOGD(TAG, "sim TX: %s", msg);
               // sms->IO(msg, buf, sizeof(buf), ms);
-              ESP_LOGD(TAG, "sim RX: %s", buf);
+              SMC_LOGD(TAG, "sim RX: %s", buf);
 
               return res->send(200, "text/plain", buf);
             });
@@ -341,6 +427,9 @@ int Webserver::setup(Alarms* alarms) {
 
   register_endpoints_static(&server);
   register_endpoints_admin(&server);
+  register_endpoints_data(&server);
+  register_endpoints_metrics(&server);
+  register_endpoints_profile(&server);
 
   // TODO FIXME WARNING
   server.on("/clearalldata", HTTP_DELETE,
@@ -354,17 +443,10 @@ int Webserver::setup(Alarms* alarms) {
   return server.begin();
 }
 
+// Only queues the message, returns 202 or 503 if the queue is full.
 int Webserver::test_notify(const char* message) {
-  if (WiFi.status() != WL_CONNECTED) {
-    ESP_LOGW(TAG, "not connected");
+  if (smc_notify(message) != 0) {
+    return 503;
   }
-
-  WiFiClient client;
-  HTTPClient http;
-
-  http.begin(client, NOTIFY_URL);
-  int resp = http.POST(message);
-  ESP_LOGD(TAG, "resp: %d", resp);
-  http.end();
-  return resp;
+  return 202;
 }
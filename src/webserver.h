@@ -1,7 +1,7 @@
 #ifndef WEBSERVER_H
 #define WEBSERVER_H
 
-#include "PsychicHttpServer.h"
+#include "http_metrics.h"
 #include "menu/alarm.h"
 
 class Webserver {
@@ -10,7 +10,7 @@ class Webserver {
   static int test_notify(const char* message);
 
  private:
-  PsychicHttpServer server;
+  MetricsHttpServer server;
 };
 
 #endif
@@ -1,57 +1,239 @@
 #include <./wifi.h>
-#include <ESPmDNS.h>
+#include <esp_attr.h>
 #include <string.h>
+#include "./log.h"
 #include "./menu/config.h"
-#include "WiFiMulti.h"
 
 static const char* TAG = "wifi";
 
-static const bool FAST_WIFI_CONNECT = true;
+static const uint32_t WIFI_CACHE_MAGIC = 0x57494649;
 
-int Wifi::setup(void) {
+// Last network joined. RTC memory survives resets and deep sleep, but not a
+// power cycle.
+struct WifiCache {
+  uint32_t magic;
+  char ssid[33];
+  uint8_t bssid[6];
+  int32_t channel;
+};
+
+RTC_DATA_ATTR static WifiCache cache;
+
+// Set from the event task, handled in Wifi::loop().
+static volatile bool got_ip = false;
+static volatile bool disconnected = false;
+static volatile bool scan_done = false;
+static volatile uint8_t disconnect_reason = 0;
+
+void Wifi::on_event(arduino_event_id_t event, arduino_event_info_t info) {
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      got_ip = true;
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      disconnect_reason = info.wifi_sta_disconnected.reason;
+      disconnected = true;
+      break;
+    case ARDUINO_EVENT_WIFI_SCAN_DONE:
+      scan_done = true;
+      break;
+    default:
+      break;
+  }
+}
+
+int Wifi::setup(DevicePreferences* preferences) {
   WiFi.setHostname(DEFAULT_HOSTNAME);
   WiFi.softAPsetHostname(DEFAULT_HOSTNAME);
+  WiFi.mode(WIFI_STA);
+  // Reconnecting is done here, the driver would only retry the same AP.
+  WiFi.setAutoReconnect(false);
+  WiFi.onEvent(on_event);
 
-  if (FAST_WIFI_CONNECT) {
-    ESP_LOGD(TAG, "quickly connecting to %s with pass %s", DEFAULT_WIFI_SSID,
-             DEFAULT_WIFI_PASS);
-    WiFi.begin(DEFAULT_WIFI_SSID, DEFAULT_WIFI_PASS);
-
-    while (WiFi.status() != WL_CONNECTED) {
-      delay(100);
-      if (WiFi.status() == WL_CONNECT_FAILED) {
-        ESP_LOGW(TAG, "connect failed, continuing...");
-        break;
-      }
+  for (const WiFiConfig& cfg : preferences->wifi_configs) {
+    if (cfg.ssid[0] == 0x00) {
+      continue;
     }
+    Candidate* c = &candidates[candidates_len++];
+    // A 32 character SSID fills cfg.ssid without a terminator, c->ssid has
+    // room for one.
+    memset(c, 0, sizeof(Candidate));
+    memcpy(c->ssid, cfg.ssid, sizeof(cfg.ssid));
+    memcpy(c->pass, cfg.pass, sizeof(cfg.pass));
+    c->priority = cfg.priority;
+  }
 
+  if (DEFAULT_WIFI_SSID[0] != 0x00 && find(DEFAULT_WIFI_SSID) == NULL) {
+    Candidate* c = &candidates[candidates_len++];
+    memset(c, 0, sizeof(Candidate));
+    strncpy(c->ssid, DEFAULT_WIFI_SSID, sizeof(c->ssid) - 1);
+    strncpy(c->pass, DEFAULT_WIFI_PASS, sizeof(c->pass) - 1);
+    c->priority = -128;
+  }
+
+  if (candidates_len == 0) {
+    SMC_LOGW(TAG, "no networks configured");
     return 0;
   }
 
-  if (DEFAULT_WIFI_SSID != NULL) {
-    wifi_multi.addAP(DEFAULT_WIFI_SSID, DEFAULT_WIFI_PASS);
+  const Candidate* cached = NULL;
+  if (cache.magic == WIFI_CACHE_MAGIC) {
+    cached = find(cache.ssid);
   }
 
-  while (wifi_multi.run() != WL_CONNECTED) {
-    delay(100);
+  if (cached != NULL) {
+    connect(cached, cache.bssid, cache.channel, true);
+  } else {
+    scan();
+  }
 
-    if (wifi_multi.run() == WL_CONNECT_FAILED) {
-      ESP_LOGW(TAG, "connect failed, continuing...");
-      break;
+  return 0;
+}
+
+bool Wifi::connected(void) {
+  return state == WIFI_CONNECTED;
+}
+
+const Wifi::Candidate* Wifi::find(const char* ssid) {
+  for (int i = 0; i < candidates_len; i++) {
+    if (strcmp(candidates[i].ssid, ssid) == 0) {
+      return &candidates[i];
     }
   }
+  return NULL;
+}
 
-  return 0;
+void Wifi::scan(void) {
+  SMC_LOGD(TAG, "scanning");
+  state = WIFI_SCANNING;
+  attempt_start = millis();
+  scan_done = false;
+  WiFi.scanNetworks(true);
+}
+
+void Wifi::pick_from_scan(void) {
+  int found = WiFi.scanComplete();
+  if (found < 0) {
+    fail("scan failed");
+    return;
+  }
+
+  int best = -1;
+  const Candidate* best_candidate = NULL;
+  for (int i = 0; i < found; i++) {
+    const Candidate* c = find(WiFi.SSID(i).c_str());
+    if (c == NULL) {
+      continue;
+    }
+
+    if (best_candidate == NULL || c->priority > best_candidate->priority ||
+        (c->priority == best_candidate->priority &&
+         WiFi.RSSI(i) > WiFi.RSSI(best))) {
+      best = i;
+      best_candidate = c;
+    }
+  }
+
+  if (best_candidate == NULL) {
+    WiFi.scanDelete();
+    fail("none of the stored networks are in range");
+    return;
+  }
+
+  SMC_LOGD(TAG, "scan took %lums, picked %s (%ddBm) out of %d",
+           millis() - attempt_start, best_candidate->ssid, WiFi.RSSI(best),
+           found);
+
+  uint8_t bssid[6];
+  memcpy(bssid, WiFi.BSSID(best), sizeof(bssid));
+  int channel = WiFi.channel(best);
+  WiFi.scanDelete();
+
+  connect(best_candidate, bssid, channel, false);
 }
 
-int Wifi::reconnect_loop(void) {
-  static int lastReconnectCheck;
-  if (WiFi.status() != WL_CONNECTED &&
-      millis() > lastReconnectCheck + 1000 * 30) {
-    ESP_LOGW(TAG, "disconnected, reconnecting...");
+void Wifi::connect(const Candidate* candidate, const uint8_t* bssid,
+                   int channel, bool warm) {
+  SMC_LOGD(TAG, "connecting to %s on channel %d (%s)", candidate->ssid, channel,
+           warm ? "cached" : "scanned");
+
+  current = candidate;
+  memcpy(current_bssid, bssid, sizeof(current_bssid));
+  current_channel = channel;
+  this->warm = warm;
+
+  state = WIFI_CONNECTING;
+  attempt_start = millis();
+  got_ip = false;
+  disconnected = false;
+  WiFi.begin(candidate->ssid, candidate->pass, channel, bssid);
+}
+
+void Wifi::fail(const char* why) {
+  // The cached AP may have moved or gone, a scan finds out.
+  if (state == WIFI_CONNECTING && warm) {
+    SMC_LOGW(TAG, "%s with the cached network, scanning", why);
+    cache.magic = 0;
     WiFi.disconnect();
-    WiFi.reconnect();
-    lastReconnectCheck = millis();
+    scan();
+    return;
+  }
+
+  SMC_LOGW(TAG, "%s, retrying in %lums", why, retry_ms);
+  WiFi.disconnect();
+  state = WIFI_WAITING;
+  retry_at = millis() + retry_ms;
+  retry_ms *= 2;
+  if (retry_ms > WIFI_RETRY_MAX_MS) {
+    retry_ms = WIFI_RETRY_MAX_MS;
+  }
+}
+
+void Wifi::loop(void) {
+  if (scan_done) {
+    scan_done = false;
+    if (state == WIFI_SCANNING) {
+      pick_from_scan();
+    }
+  }
+
+  if (got_ip) {
+    got_ip = false;
+    if (state == WIFI_CONNECTING) {
+      state = WIFI_CONNECTED;
+      retry_ms = WIFI_RETRY_MIN_MS;
+
+      SMC_LOGI(TAG, "connected to %s in %lums (%s), %lums after boot",
+               current->ssid, millis() - attempt_start,
+               warm ? "cached" : "scanned", millis());
+
+      cache.magic = WIFI_CACHE_MAGIC;
+      strcpy(cache.ssid, current->ssid);
+      memcpy(cache.bssid, current_bssid, sizeof(cache.bssid));
+      cache.channel = current_channel;
+    }
+  }
+
+  if (disconnected) {
+    disconnected = false;
+    if (state == WIFI_CONNECTED) {
+      // Usually the same AP comes back, so try it before scanning.
+      SMC_LOGW(TAG, "disconnected from %s (reason %d), reconnecting",
+               current->ssid, disconnect_reason);
+      connect(current, current_bssid, current_channel, true);
+    } else if (state == WIFI_CONNECTING) {
+      char why[32];
+      snprintf(why, sizeof(why), "disconnected (reason %d)", disconnect_reason);
+      fail(why);
+    }
+  }
+
+  if (state == WIFI_CONNECTING &&
+      millis() - attempt_start > WIFI_CONNECT_TIMEOUT_MS) {
+    fail("timed out");
+  }
+
+  if (state == WIFI_WAITING && (long)(millis() - retry_at) >= 0) {
+    scan();
   }
-  return 0;
 }
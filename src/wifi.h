@@ -1,15 +1,64 @@
 #ifndef WIFI_H
 #define WIFI_H
 
-#include "WiFiMulti.h"
+#include "WiFi.h"
+#include "menu/preferences.h"
 
+static const unsigned long WIFI_CONNECT_TIMEOUT_MS = 10 * 1000;
+static const unsigned long WIFI_RETRY_MIN_MS = 5 * 1000;
+static const unsigned long WIFI_RETRY_MAX_MS = 5 * 60 * 1000;
+
+// The stored configs plus DEFAULT_WIFI_SSID.
+static const int WIFI_MAX_CANDIDATES =
+    sizeof(DevicePreferences::wifi_configs) / sizeof(WiFiConfig) + 1;
+
+enum WifiState {
+  WIFI_IDLE,  // Nothing to connect to
+  WIFI_SCANNING,
+  WIFI_CONNECTING,
+  WIFI_CONNECTED,
+  WIFI_WAITING,  // Backing off before the next scan
+};
+
+// Connects in the background, driven by WiFi events, so nothing here waits on
+// association. The network is picked by priority then RSSI from a scan, and
+// the last one joined is kept in RTC memory so a reconnect (or a reset) can go
+// straight to its BSSID and channel.
 class Wifi {
  public:
-  int setup(void);
-  static int reconnect_loop(void);
+  int setup(DevicePreferences* preferences);
+  // Call in the loop.
+  void loop(void);
+  bool connected(void);
 
  private:
-  WiFiMulti wifi_multi;
+  struct Candidate {
+    char ssid[33];
+    char pass[64];
+    int priority;  // Higher is preferred
+  };
+
+  static void on_event(arduino_event_id_t event, arduino_event_info_t info);
+
+  void scan(void);
+  void pick_from_scan(void);
+  void connect(const Candidate* candidate, const uint8_t* bssid, int channel,
+               bool warm);
+  void fail(const char* why);
+  const Candidate* find(const char* ssid);
+
+  Candidate candidates[WIFI_MAX_CANDIDATES];
+  int candidates_len = 0;
+
+  WifiState state = WIFI_IDLE;
+  const Candidate* current = NULL;
+  uint8_t current_bssid[6];
+  int current_channel = 0;
+  bool warm = false;
+
+  unsigned long attempt_start = 0;
+  unsigned long retry_at = 0;
+  unsigned long retry_ms = WIFI_RETRY_MIN_MS;
 };
 
 #endif
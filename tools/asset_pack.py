@@ -0,0 +1,231 @@
+####
+# Packs the UI's images into one atlas of LVGL image descriptors, already in
+# the display's RGB565, so nothing is decoded or rasterised on the device.
+#
+#   python3 tools/asset_pack.py -o src/menu/assets.h home_bg=grad:32x240:#141428:#37124b
+#
+# Every asset is NAME=KIND:ARGS[:rle] and becomes SMC_ASSET_<NAME>:
+#   grad:WxH:#top:#bottom  a vertical gradient, e.g. a strip to tile as a
+#                          background
+#   png:PATH               an 8-bit RGB or RGBA PNG, RGBA becomes RGB565A8
+# With :rle the pixels are compressed with LVGL's RLE, then decoded once into
+# the image cache instead of being read from flash on every draw. Pays off
+# for icons with runs of one colour, not for anything that has to fit into the
+# cache next to the rest. Both are off in lv_conf.h until an asset needs them:
+# LV_USE_RLE, LV_BIN_DECODER_RAM_LOAD and a LV_CACHE_DEF_SIZE.
+#
+# Needs only the standard library. Run through `make assets`.
+###
+
+import argparse
+import struct
+import sys
+import zlib
+
+CF_RGB565 = 0x12  # LV_COLOR_FORMAT_RGB565
+CF_RGB565A8 = 0x14  # LV_COLOR_FORMAT_RGB565A8
+FLAG_COMPRESSED = 0x0008  # LV_IMAGE_FLAGS_COMPRESSED
+COMPRESS_RLE = 1  # LV_IMAGE_COMPRESS_RLE
+ALIGN = 4  # LV_DRAW_BUF_ALIGN
+
+
+class Asset:
+    def __init__(self, name, w, h, cf, data):
+        self.name = name
+        self.w = w
+        self.h = h
+        self.cf = cf
+        self.stride = w * 2  # Of the RGB565 plane, the A8 one follows
+        self.data = data
+        self.flags = 0
+
+
+def rgb565(r, g, b):
+    # As lv_color_to_u16(), little endian like the ESP32
+    return struct.pack("<H", ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3))
+
+
+def parse_color(text):
+    text = text.lstrip("#")
+    if len(text) != 6:
+        raise ValueError(f"colour {text!r} isn't #rrggbb")
+    return tuple(int(text[i:i + 2], 16) for i in (0, 2, 4))
+
+
+def gradient(name, size, top, bottom):
+    w, h = (int(v) for v in size.split("x"))
+    top = parse_color(top)
+    bottom = parse_color(bottom)
+    rows = []
+    for y in range(h):
+        # Mixed as LVGL does for a bg_grad_dir of LV_GRAD_DIR_VER
+        mix = y * 255 // max(h - 1, 1)
+        c = [((a * (255 - mix) + b * mix) * 0x8081) >> 23 for a, b in zip(top, bottom)]
+        rows.append(rgb565(*c) * w)
+    return Asset(name, w, h, CF_RGB565, b"".join(rows))
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def read_png(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError(f"{path} isn't a PNG")
+
+    p = 8
+    idat = b""
+    while p < len(data):
+        length, kind = struct.unpack_from(">I4s", data, p)
+        chunk = data[p + 8:p + 8 + length]
+        if kind == b"IHDR":
+            w, h, depth, color, _, _, interlace = struct.unpack(">IIBBBBB", chunk)
+        elif kind == b"IDAT":
+            idat += chunk
+        p += 12 + length
+    if depth != 8 or color not in (2, 6) or interlace:
+        raise ValueError(f"{path}: only 8-bit RGB or RGBA without interlacing")
+
+    bpp = 3 if color == 2 else 4
+    raw = zlib.decompress(idat)
+    pixels = []
+    prev = bytearray(w * bpp)
+    for y in range(h):
+        start = y * (w * bpp + 1)
+        kind = raw[start]
+        row = bytearray(raw[start + 1:start + 1 + w * bpp])
+        for i in range(len(row)):
+            a = row[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            row[i] = (row[i] + (0, a, b, (a + b) // 2, paeth(a, b, c))[kind]) & 0xFF
+        pixels.append(bytes(row))
+        prev = row
+    return w, h, bpp, pixels
+
+
+def png(name, path):
+    w, h, bpp, rows = read_png(path)
+    color = b"".join(rgb565(*row[x:x + 3]) for row in rows for x in range(0, len(row), bpp))
+    if bpp == 3:
+        return Asset(name, w, h, CF_RGB565, color)
+    alpha = bytes(row[x + 3] for row in rows for x in range(0, len(row), bpp))
+    return Asset(name, w, h, CF_RGB565A8, color + alpha)
+
+
+def rle(data, blk):
+    # The inverse of lv_rle_decompress(): a control byte with the top bit set
+    # is followed by that many literal blocks, otherwise by one block repeated
+    # that many times.
+    blocks = [data[i:i + blk] for i in range(0, len(data), blk)]
+    out = bytearray()
+    literal = []
+
+    def flush():
+        while literal:
+            n = min(len(literal), 127)
+            out.append(0x80 | n)
+            out.extend(b"".join(literal[:n]))
+            del literal[:n]
+
+    i = 0
+    while i < len(blocks):
+        n = 1
+        while i + n < len(blocks) and n < 127 and blocks[i + n] == blocks[i]:
+            n += 1
+        if n >= 3:
+            flush()
+            out.append(n)
+            out.extend(blocks[i])
+            i += n
+        else:
+            literal.append(blocks[i])
+            i += 1
+    flush()
+    return bytes(out)
+
+
+def compress(asset):
+    # RGB565A8 is compressed in 2 byte blocks as well, see decompress_image()
+    body = rle(asset.data, 2)
+    asset.data = struct.pack("<III", COMPRESS_RLE, len(body), len(asset.data)) + body
+    asset.flags |= FLAG_COMPRESSED
+
+
+def parse_asset(spec):
+    name, _, rest = spec.partition("=")
+    args = rest.split(":")
+    use_rle = args[-1] == "rle"
+    if use_rle:
+        args.pop()
+    if args[0] == "grad" and len(args) == 4:
+        asset = gradient(name, *args[1:])
+    elif args[0] == "png" and len(args) == 2:
+        asset = png(name, args[1])
+    else:
+        raise ValueError(f"can't make an asset of {spec!r}")
+    if use_rle:
+        compress(asset)
+    return asset
+
+
+def write_header(out, assets):
+    atlas = bytearray()
+    offsets = []
+    for asset in assets:
+        atlas.extend(b"\0" * (-len(atlas) % ALIGN))
+        offsets.append(len(atlas))
+        atlas.extend(asset.data)
+
+    out.write("// Generated by tools/asset_pack.py, run `make assets` to update.\n")
+    out.write("#ifndef SMC_ASSETS_H\n#define SMC_ASSETS_H\n\n")
+    out.write('#include <cstdint>\n#include "menu.h"\n#include LVGL_INCLUDE\n\n')
+    out.write("// Every asset, each aligned to LV_DRAW_BUF_ALIGN.\n")
+    out.write(f"alignas({ALIGN}) static const uint8_t SMC_ASSET_ATLAS[] = {{\n")
+    for i in range(0, len(atlas), 16):
+        out.write("  " + ", ".join(f"0x{b:02x}" for b in atlas[i:i + 16]) + ",\n")
+    out.write("};\n")
+
+    for asset, offset in zip(assets, offsets):
+        kind = "RLE " if asset.flags & FLAG_COMPRESSED else ""
+        fmt = "RGB565A8" if asset.cf == CF_RGB565A8 else "RGB565"
+        out.write(f"\n// {asset.w}x{asset.h} {kind}{fmt}, {len(asset.data)} bytes\n")
+        out.write(f"static const lv_image_dsc_t SMC_ASSET_{asset.name.upper()} = {{\n")
+        # lv_image_header_t's fields in little endian order
+        out.write(f"    {{LV_IMAGE_HEADER_MAGIC, 0x{asset.cf:02x}, 0x{asset.flags:04x}, "
+                  f"{asset.w}, {asset.h}, {asset.stride}, 0}},\n")
+        out.write(f"    {len(asset.data)},\n")
+        out.write(f"    SMC_ASSET_ATLAS + {offset},\n")
+        out.write("    NULL,\n    NULL,\n};\n")
+
+    out.write("\n#endif\n")
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-o", "--output", default="-", help="header to write, - for stdout")
+    parser.add_argument("assets", nargs="+", help="NAME=KIND:ARGS[:rle]")
+    args = parser.parse_args()
+
+    try:
+        assets = [parse_asset(spec) for spec in args.assets]
+    except (OSError, ValueError) as e:
+        sys.exit(f"asset_pack: {e}")
+
+    if args.output == "-":
+        write_header(sys.stdout, assets)
+    else:
+        with open(args.output, "w") as out:
+            write_header(out, assets)
+    total = sum(len(a.data) for a in assets)
+    print(f"{len(assets)} assets, {total} bytes", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,131 @@
+####
+# Formats the binary log records of a build with -DSMC_LOG_BINARY, which only
+# carry pointers to their tag and format string, using the firmware's ELF.
+#
+#   pio device monitor --raw | python3 tools/log_decode.py .pio/build/dev/firmware.elf
+#   python3 tools/log_decode.py firmware.elf capture.bin
+#
+# Anything between records, e.g. the boot ROM's output, is passed through.
+# Needs pyelftools, which comes with PlatformIO.
+###
+
+import re
+import struct
+import sys
+
+from elftools.elf.elffile import ELFFile
+
+MAGIC = b"\xa5\x5a"
+HEADER = struct.Struct("<IIIBBxx")  # SmcLogHeader on the ESP32
+LEVELS = "NEWIDV"
+SPEC = re.compile(r"%([-+ #0-9.]*)([hljztL]*)([diouxXcsfFeEgGaAp%])")
+
+
+class Strings:
+    def __init__(self, path):
+        self.sections = []
+        with open(path, "rb") as f:
+            for section in ELFFile(f).iter_sections():
+                if section["sh_flags"] & 0x2 and section["sh_type"] == "SHT_PROGBITS":
+                    self.sections.append((section["sh_addr"], section.data()))
+
+    def get(self, addr):
+        for start, data in self.sections:
+            if start <= addr < start + len(data):
+                end = data.index(b"\0", addr - start)
+                return data[addr - start:end].decode(errors="replace")
+        return f"<0x{addr:08x}>"
+
+
+def read_args(data):
+    args = []
+    p = 0
+    while p < len(data):
+        kind = chr(data[p])
+        p += 1
+        if kind in "ip":
+            args.append(struct.unpack_from("<i" if kind == "i" else "<I", data, p)[0])
+            p += 4
+        elif kind == "l":
+            args.append(struct.unpack_from("<q", data, p)[0])
+            p += 8
+        elif kind == "d":
+            args.append(struct.unpack_from("<d", data, p)[0])
+            p += 8
+        elif kind == "s":
+            args.append(data[p + 1:p + 1 + data[p]].decode(errors="replace"))
+            p += 1 + data[p]
+        else:
+            break
+    return args
+
+
+def format_message(fmt, args):
+    args = iter(args)
+
+    def conv(match):
+        flags, _, kind = match.groups()
+        if kind == "%":
+            return "%"
+        try:
+            val = next(args)
+        except StopIteration:
+            return "?"
+        if kind == "p":
+            return f"0x{val:x}"
+        if kind == "u" and isinstance(val, int) and val < 0:
+            val += 1 << 32
+        if kind in "diouxXc" and not isinstance(val, int):
+            return "?"
+        if kind == "s" and not isinstance(val, str):
+            return "?"
+        return ("%" + flags + kind.replace("u", "d")) % val
+
+    return SPEC.sub(conv, fmt)
+
+
+def decode(strings, stream):
+    buf = b""
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        buf += chunk
+        while True:
+            start = buf.find(MAGIC)
+            if start < 0:
+                keep = 1 if buf.endswith(MAGIC[:1]) else 0
+                sys.stdout.write(buf[:len(buf) - keep].decode(errors="replace"))
+                buf = buf[len(buf) - keep:]
+                break
+            sys.stdout.write(buf[:start].decode(errors="replace"))
+            buf = buf[start:]
+            if len(buf) < 3 or len(buf) < 3 + buf[2]:
+                break
+            record = buf[3:3 + buf[2]]
+            buf = buf[3 + buf[2]:]
+            if len(record) < HEADER.size:
+                continue
+
+            ms, tag, fmt, level, args_len = HEADER.unpack_from(record)
+            args = read_args(record[HEADER.size:HEADER.size + args_len])
+            message = format_message(strings.get(fmt), args)
+            print(f"{LEVELS[level % 6]} ({ms}) {strings.get(tag)}: {message}")
+        sys.stdout.flush()
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__ or "usage: log_decode.py firmware.elf [capture]")
+        sys.exit(1)
+
+    strings = Strings(sys.argv[1])
+    if len(sys.argv) > 2:
+        with open(sys.argv[2], "rb") as f:
+            decode(strings, f)
+    else:
+        decode(strings, sys.stdin.buffer)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,320 @@
+####
+# Pretends to be the SIM module on a pty, to drive the AT engine on the
+# desktop without the hardware.
+#
+#   python3 tools/modem_sim.py [--latency 0.2] [--send-latency 2] [--drop CSQ]
+#
+# Prints the pty path to open at 9600 baud. Lines typed on stdin inject
+# events:
+#
+#   sms <number> <text>    stores a message and sends +CMTI
+#   creg <status>          sends +CREG: <status>
+#   csq <rssi>             sets what AT+CSQ answers
+#   raw <line>             sends <line> as is
+#   stats                  prints how many SMS parts were sent, and how fast
+#
+# AT+CMGS works in both text and PDU mode. PDUs asking for a status report get
+# a +CDS after --report-delay seconds, in whichever mode the modem is then.
+###
+
+import argparse
+import os
+import pty
+import select
+import sys
+import time
+import tty
+
+CTRL_Z = b"\x1a"
+ESC = b"\x1b"
+
+GSM7 = ("@£$¥èéùìòÇ\nØø\rÅåΔ_ΦΓΛΩΠΨΣΘΞ\x1bÆæßÉ !\"#¤%&'()*+,-./0123456789:;<=>?"
+        "¡ABCDEFGHIJKLMNOPQRSTUVWXYZÄÖÑÜ§¿abcdefghijklmnopqrstuvwxyzäöñüà")
+GSM7_EXT = {0x14: "^", 0x28: "{", 0x29: "}", 0x2F: "\\", 0x3C: "[",
+            0x3D: "~", 0x3E: "]", 0x40: "|", 0x65: "€"}
+
+
+def decode_semi_octets(data):
+    digits = ""
+    for octet in data:
+        digits += str(octet & 0x0F)
+        if octet >> 4 != 0x0F:
+            digits += str(octet >> 4)
+    return digits
+
+
+def encode_semi_octets(digits):
+    if len(digits) % 2:
+        digits += "F"
+    return bytes(int(digits[i + 1], 16) << 4 | int(digits[i])
+                 for i in range(0, len(digits), 2))
+
+
+def decode_submit(pdu):
+    """Returns (number, status report wanted, udh, text) of an SMS-SUBMIT."""
+    sca_len = pdu[0]
+    p = 1 + sca_len
+    first = pdu[p]
+    p += 2  # first octet, MR
+    da_len = pdu[p]
+    da_type = pdu[p + 1]
+    number = decode_semi_octets(pdu[p + 2:p + 2 + (da_len + 1) // 2])
+    if da_type == 0x91:
+        number = "+" + number
+    p += 2 + (da_len + 1) // 2
+    dcs = pdu[p + 1]
+    p += 2
+    vpf = (first >> 3) & 0x03
+    p += {0: 0, 2: 1}.get(vpf, 7)
+    udl = pdu[p]
+    ud = pdu[p + 1:]
+
+    udh = b""
+    if first & 0x40:
+        udh = ud[1:1 + ud[0]]
+
+    if dcs & 0x0C == 0x08:
+        body = ud[1 + len(udh):] if udh else ud
+        text = body.decode("utf-16-be", errors="replace")
+    else:
+        bits = int.from_bytes(ud, "little")
+        skip = (8 * (len(udh) + 1) + 6) // 7 if udh else 0
+        septets = [(bits >> (7 * i)) & 0x7F for i in range(skip, udl)]
+        text = ""
+        escape = False
+        for septet in septets:
+            if escape:
+                text += GSM7_EXT.get(septet, "?")
+                escape = False
+            elif septet == 0x1B:
+                escape = True
+            else:
+                text += GSM7[septet]
+
+    return number, bool(first & 0x20), udh, text
+
+
+def status_report_pdu(mr, number):
+    ts = bytes([0x42, 0x50, 0x01, 0x01, 0x00, 0x00, 0x23])
+    international = number.startswith("+")
+    digits = number.lstrip("+")
+    pdu = bytes([0x00, 0x06, mr, len(digits), 0x91 if international else 0x81])
+    pdu += encode_semi_octets(digits) + ts + ts + bytes([0x00])
+    return pdu.hex().upper()
+
+
+class Modem:
+    def __init__(self, fd, args):
+        self.fd = fd
+        self.latency = args.latency
+        self.send_latency = args.send_latency
+        self.report_delay = args.report_delay
+        self.drop = args.drop
+        self.baud = args.baud
+        self.echo = True
+        self.pdu_mode = False
+        self.csq = 17
+        self.creg = 1
+        self.storage = {}
+        self.next_idx = 1
+        self.next_mr = 1
+        self.pending_sms = None  # Length or number while in text entry mode
+        self.reports = []  # (when, mr, number)
+        self.parts_sent = 0
+        self.first_send = None
+        self.last_send = None
+
+    def out(self, line):
+        os.write(self.fd, b"\r\n" + line.encode() + b"\r\n")
+
+    def ok(self):
+        self.out("OK")
+
+    def wire_time(self, data):
+        if self.baud > 0:
+            time.sleep(len(data) * 10 / self.baud)
+
+    def handle(self, cmd):
+        print(f"<- {cmd}")
+        self.wire_time(cmd)
+        if self.echo:
+            os.write(self.fd, cmd.encode() + b"\r")
+
+        name = cmd[2:].split("=")[0].split("?")[0].lstrip("+")
+        if name in self.drop:
+            print(f"   (dropping {name})")
+            return
+
+        time.sleep(self.latency)
+
+        if cmd == "AT":
+            self.ok()
+        elif cmd == "ATE0":
+            self.echo = False
+            self.ok()
+        elif cmd in ("AT+CMGF=0", "AT+CMGF=1"):
+            self.pdu_mode = cmd == "AT+CMGF=0"
+            self.ok()
+        elif cmd == "AT+CREG=1" or cmd.startswith("AT+CNMI"):
+            self.ok()
+        elif cmd == "AT+CSQ":
+            self.out(f"+CSQ: {self.csq},0")
+            self.ok()
+        elif cmd == "AT+CREG?":
+            self.out(f"+CREG: 1,{self.creg}")
+            self.ok()
+        elif cmd.startswith("AT+CMGR="):
+            idx = int(cmd[8:])
+            if idx not in self.storage:
+                self.out("+CMS ERROR: 321")
+                return
+            number, text, ts = self.storage[idx]
+            self.out(f'+CMGR: "REC UNREAD","{number}","","{ts}"')
+            os.write(self.fd, text.encode() + b"\r\n")
+            self.ok()
+        elif cmd.startswith("AT+CMGD="):
+            self.storage.pop(int(cmd[8:]), None)
+            self.ok()
+        elif cmd.startswith("AT+CMGS="):
+            self.pending_sms = cmd[8:].strip('"')
+            os.write(self.fd, b"\r\n> ")
+        else:
+            self.out("ERROR")
+
+    def handle_text(self, data):
+        self.wire_time(data)
+        if data.endswith(ESC):
+            print(f"   sending aborted")
+            self.pending_sms = None
+            return
+
+        body = data.rstrip(CTRL_Z).decode(errors="replace")
+        report = None
+        if self.pdu_mode:
+            try:
+                number, srr, udh, text = decode_submit(bytes.fromhex(body))
+            except (ValueError, IndexError):
+                self.pending_sms = None
+                self.out("+CMS ERROR: 304")
+                return
+            part = f" part {udh[4]}/{udh[3]}" if len(udh) == 5 else ""
+            print(f"   SMS to {number}{part}: {text}")
+            if srr:
+                report = number
+        else:
+            print(f"   SMS to {self.pending_sms}: {body}")
+        self.pending_sms = None
+
+        time.sleep(self.send_latency)
+        mr = self.next_mr
+        self.next_mr = (self.next_mr + 1) % 256
+        self.out(f"+CMGS: {mr}")
+        self.ok()
+
+        now = time.monotonic()
+        self.parts_sent += 1
+        self.first_send = self.first_send or now
+        self.last_send = now
+        if report is not None:
+            self.reports.append((now + self.report_delay, mr, report))
+
+    def send_reports(self):
+        now = time.monotonic()
+        due = [r for r in self.reports if r[0] <= now]
+        self.reports = [r for r in self.reports if r[0] > now]
+        for _, mr, number in due:
+            if self.pdu_mode:
+                pdu = status_report_pdu(mr, number)
+                self.out(f"+CDS: {len(pdu) // 2 - 1}")
+                os.write(self.fd, pdu.encode() + b"\r\n")
+            else:
+                ts = time.strftime("%y/%m/%d,%H:%M:%S+32")
+                self.out(f'+CDS: 6,{mr},"{number}",145,"{ts}","{ts}",0')
+
+    def stats(self):
+        if self.parts_sent < 2:
+            print(f"{self.parts_sent} parts sent")
+            return
+        minutes = (self.last_send - self.first_send) / 60
+        rate = (self.parts_sent - 1) / minutes if minutes > 0 else 0
+        print(f"{self.parts_sent} parts sent, {rate:.1f} per minute")
+
+    def inject(self, line):
+        parts = line.split(" ", 2)
+        if parts[0] == "sms" and len(parts) == 3:
+            idx = self.next_idx
+            self.next_idx += 1
+            ts = time.strftime("%y/%m/%d,%H:%M:%S+32")
+            self.storage[idx] = (parts[1], parts[2], ts)
+            self.out(f'+CMTI: "SM",{idx}')
+        elif parts[0] == "creg" and len(parts) == 2:
+            self.creg = int(parts[1])
+            self.out(f"+CREG: {self.creg}")
+        elif parts[0] == "csq" and len(parts) == 2:
+            self.csq = int(parts[1])
+        elif parts[0] == "raw":
+            self.out(line[4:])
+        elif parts[0] == "stats":
+            self.stats()
+        else:
+            print("unknown event")
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--latency", type=float, default=0.1,
+                        help="seconds before each answer")
+    parser.add_argument("--send-latency", type=float, default=0,
+                        help="extra seconds before +CMGS, the network time")
+    parser.add_argument("--report-delay", type=float, default=1,
+                        help="seconds before a delivery report")
+    parser.add_argument("--baud", type=int, default=0,
+                        help="emulate the wire time of this baud rate")
+    parser.add_argument("--drop", action="append", default=[],
+                        help="never answer this command, e.g. CSQ")
+    args = parser.parse_args()
+
+    master, slave = pty.openpty()
+    tty.setraw(slave)
+    print(f"modem on {os.ttyname(slave)}")
+
+    modem = Modem(master, args)
+    buf = b""
+
+    while True:
+        timeout = 0.1 if modem.reports else None
+        readable, _, _ = select.select([master, sys.stdin], [], [], timeout)
+        modem.send_reports()
+
+        if sys.stdin in readable:
+            data = os.read(sys.stdin.fileno(), 1024)
+            if not data:
+                break
+            for line in data.decode(errors="replace").splitlines():
+                if line.strip():
+                    modem.inject(line.strip())
+
+        if master in readable:
+            buf += os.read(master, 1024)
+            while True:
+                if modem.pending_sms is not None:
+                    ends = [i for i in (buf.find(CTRL_Z), buf.find(ESC))
+                            if i >= 0]
+                    if not ends:
+                        break
+                    end = min(ends)
+                    modem.handle_text(buf[:end + 1])
+                    buf = buf[end + 1:]
+                    continue
+
+                end = buf.find(b"\r")
+                if end < 0:
+                    break
+                cmd = buf[:end].strip().decode(errors="replace")
+                buf = buf[end + 1:]
+                if cmd:
+                    modem.handle(cmd)
+
+
+if __name__ == "__main__":
+    main()
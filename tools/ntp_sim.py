@@ -0,0 +1,67 @@
+####
+# Stand-in SNTP server, to watch the clock sync and drift tracking without
+# waiting days for a real RTC to wander.
+#
+#   python3 tools/ntp_sim.py [--port 1123] [--offset 2.5] [--drift-ppm 50]
+#
+# Answers with the host time plus --offset seconds, plus --drift-ppm of the
+# time since it started. Point NTP_SERVER_PRI in config.h at the host to use
+# it, port 123 needs root.
+###
+
+import argparse
+import socket
+import struct
+import time
+
+NTP_EPOCH = 2208988800  # 1900-01-01 to 1970-01-01
+
+
+def to_ntp(t):
+    secs = int(t)
+    frac = int((t - secs) * (1 << 32)) & 0xFFFFFFFF
+    return struct.pack("!II", (secs + NTP_EPOCH) & 0xFFFFFFFF, frac)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--port", type=int, default=123)
+    parser.add_argument("--offset", type=float, default=0,
+                        help="seconds added to the host time")
+    parser.add_argument("--drift-ppm", type=float, default=0,
+                        help="how fast the served time runs from the host")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("0.0.0.0", args.port))
+    print(f"ntp on port {args.port}")
+
+    start = time.time()
+
+    def now():
+        t = time.time()
+        return t + args.offset + (t - start) * args.drift_ppm / 1e6
+
+    while True:
+        data, addr = sock.recvfrom(512)
+        received = now()
+        if len(data) < 48:
+            continue
+
+        version = (data[0] >> 3) & 0x07
+        # LI 0, the client version, mode 4 (server), stratum 1, no root delay
+        reply = bytes([version << 3 | 4, 1, data[2], 0xEC])
+        reply += struct.pack("!II", 0, 0) + b"SIM\x00"
+        reply += to_ntp(received)  # Reference
+        reply += data[40:48]  # Originate, the client transmit time
+        reply += to_ntp(received)
+        reply += to_ntp(now())
+        sock.sendto(reply, addr)
+
+        served = time.strftime("%H:%M:%S", time.gmtime(received))
+        print(f"{addr[0]} v{version} -> {served}, "
+              f"{received - time.time():+.3f}s from host")
+
+
+if __name__ == "__main__":
+    main()